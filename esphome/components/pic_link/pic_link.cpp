@@ -0,0 +1,261 @@
+#include "pic_link.h"
+#include "esphome/core/log.h"
+#include "esphome/core/hal.h"
+#include <algorithm>
+#include <cstring>
+
+static const char *const TAG = "pic_link";
+using namespace esphome::pic_link;
+
+// Svarstid inklusive en full ögonblicksbild (263 bytes = ~23 ms vid 115200 Baud)
+static const uint32_t LINK_TIMEOUT_MS = 100;
+static const uint8_t LINK_HELLO_RETRIES = 3;
+// Högst så många READ_EVENTS per update() (63 händelser per svar)
+static const uint8_t LINK_EVENT_BATCHES = 4;
+
+void PicLink::setup() {
+  ESP_LOGCONFIG(TAG, "PIC Link initialiseras...");
+  if (!this->negotiate_()) {
+    ESP_LOGW(TAG, "PIC svarar inte, försöker igen vid nästa uppdatering.");
+  }
+}
+
+void PicLink::dump_config() {
+  ESP_LOGCONFIG(TAG, "PIC Link (UART2 blockprotokoll):");
+  ESP_LOGCONFIG(TAG, "  Ansluten: %s", YESNO(this->linked_));
+  ESP_LOGCONFIG(TAG, "  PIC Firmware: %u.%u", this->pic_fw_major_, this->pic_fw_minor_);
+  ESP_LOGCONFIG(TAG, "  Baudrate: %u", baud_from_code_(this->baud_code_));
+  LOG_UPDATE_INTERVAL(this);
+}
+
+void PicLink::update() {
+  if (!this->linked_ && !this->negotiate_()) {
+    return;
+  }
+  // Hela registerMap i en enda transaktion
+  if (!this->read_block(0, PIC_TOTAL_REGS, this->snapshot_.data())) {
+    ESP_LOGW(TAG, "Ögonblicksbild misslyckades, förhandlar om länken.");
+    this->linked_ = false;
+    return;
+  }
+  this->snapshot_valid_ = true;
+  this->drain_events();
+}
+
+bool PicLink::drain_events() {
+  for (uint8_t batch = 0; batch < LINK_EVENT_BATCHES; batch++) {
+    // Kvittera förra svaret och be om så många som ryms
+    uint8_t request[2] = {this->events_unacked_, 0};
+    uint16_t length;
+    if (!this->transact_(LINK_CMD_READ_EVENTS, request, sizeof(request), &length) || length < 2 ||
+        length != 2 + this->response_[1] * LINK_EVENT_SIZE) {
+      // Osäkert vad PIC:en fick: kvittera inget nästa gång (hellre dubbletter än förlorade händelser)
+      this->events_unacked_ = 0;
+      return false;
+    }
+    uint8_t overflows = this->response_[0];
+    if (overflows != this->event_overflows_) {
+      ESP_LOGW(TAG, "PIC:ens händelse-FIFO har svämmat över (%u totalt)", overflows);
+      this->event_overflows_ = overflows;
+    }
+    uint8_t count = this->response_[1];
+    for (uint8_t i = 0; i < count; i++) {
+      const uint8_t *raw = &this->response_[2 + i * LINK_EVENT_SIZE];
+      PicEvent event{(uint16_t) (raw[0] | (raw[1] << 8)), raw[2], raw[3]};
+      ESP_LOGV(TAG, "Händelse t=%u reg %u = 0x%02X", event.tick_ms, event.reg, event.value);
+      this->event_callback_.call(event);
+    }
+    this->events_unacked_ = count;
+    if (count < LINK_MAX_EVENTS)
+      break;  // FIFO:n är tom
+  }
+  return true;
+}
+
+bool PicLink::read_block(uint8_t start, uint16_t count, uint8_t *out) {
+  if (count == 0 || start + count > PIC_TOTAL_REGS)
+    return false;
+  uint8_t request[2] = {start, (uint8_t) (count & 0xFF)};  // 0 = 256
+  uint16_t length;
+  if (!this->transact_(LINK_CMD_READ_BLOCK, request, sizeof(request), &length))
+    return false;
+  if (length != 1 + count || this->response_[0] != start) {
+    ESP_LOGW(TAG, "Oväntat READ_BLOCK-svar (%u bytes)", length);
+    return false;
+  }
+  memcpy(out, &this->response_[1], count);
+  return true;
+}
+
+bool PicLink::write_block(uint8_t start, const uint8_t *data, uint16_t count) {
+  if (count == 0 || start + count > PIC_TOTAL_REGS)
+    return false;
+  uint8_t request[LINK_MAX_PAYLOAD];
+  request[0] = start;
+  memcpy(&request[1], data, count);
+  uint16_t length;
+  if (!this->transact_(LINK_CMD_WRITE_BLOCK, request, 1 + count, &length))
+    return false;
+  if (length == 2 && this->snapshot_valid_) {
+    // Håll ögonblicksbilden i synk utan att vänta på nästa update()
+    memcpy(&this->snapshot_[start], data, count);
+  }
+  return length == 2;
+}
+
+bool PicLink::negotiate_() {
+  // Börja alltid på standardhastighet. En PIC som står kvar på en högre hastighet
+  // faller själv tillbaka efter några ramfel.
+  if (this->baud_code_ != LINK_BAUD_115200) {
+    this->baud_code_ = LINK_BAUD_115200;
+    this->parent_->set_baud_rate(baud_from_code_(this->baud_code_));
+    this->parent_->load_settings(false);
+  }
+
+  uint8_t pic_max_baud = LINK_BAUD_115200;
+  bool ok = false;
+  for (uint8_t attempt = 0; attempt < LINK_HELLO_RETRIES && !ok; attempt++) {
+    ok = this->hello_(&pic_max_baud);
+  }
+  if (!ok)
+    return false;
+
+  uint8_t target = std::min(this->max_baud_code_, pic_max_baud);
+  if (target != LINK_BAUD_115200) {
+    if (this->set_baud_(target) && this->hello_(&pic_max_baud)) {
+      ESP_LOGI(TAG, "Länken körs i %u Baud", baud_from_code_(target));
+    } else {
+      ESP_LOGW(TAG, "Baudbyte misslyckades, kör vidare i 115200 Baud");
+      this->baud_code_ = LINK_BAUD_115200;
+      this->parent_->set_baud_rate(baud_from_code_(this->baud_code_));
+      this->parent_->load_settings(false);
+    }
+  }
+
+  this->events_unacked_ = 0;
+  this->linked_ = true;
+  return true;
+}
+
+bool PicLink::hello_(uint8_t *pic_max_baud_code) {
+  uint16_t length;
+  if (!this->transact_(LINK_CMD_HELLO, nullptr, 0, &length) || length != 5)
+    return false;
+  this->pic_fw_major_ = this->response_[1];
+  this->pic_fw_minor_ = this->response_[2];
+  *pic_max_baud_code = this->response_[4];
+  ESP_LOGD(TAG, "HELLO: protokoll %u, PIC FW %u.%u", this->response_[0], this->pic_fw_major_, this->pic_fw_minor_);
+  return true;
+}
+
+bool PicLink::set_baud_(uint8_t code) {
+  uint16_t length;
+  if (!this->transact_(LINK_CMD_SET_BAUD, &code, 1, &length) || length != 1 || this->response_[0] != code)
+    return false;
+  // PIC:en byter först när svaret har lämnat dess UART; vi byter efter att ha tagit emot det.
+  this->flush();
+  this->baud_code_ = code;
+  this->parent_->set_baud_rate(baud_from_code_(code));
+  this->parent_->load_settings(false);
+  delay(2);
+  return true;
+}
+
+void PicLink::send_frame_(uint8_t cmd, const uint8_t *payload, uint16_t length) {
+  uint8_t header[4] = {LINK_SYNC, cmd, (uint8_t) (length & 0xFF), (uint8_t) (length >> 8)};
+  uint16_t crc = 0xFFFF;
+  for (uint8_t i = 1; i < sizeof(header); i++)
+    crc = crc16_update_(crc, header[i]);
+  for (uint16_t i = 0; i < length; i++)
+    crc = crc16_update_(crc, payload[i]);
+  this->write_array(header, sizeof(header));
+  if (length > 0)
+    this->write_array(payload, length);
+  this->write_byte((uint8_t) (crc & 0xFF));
+  this->write_byte((uint8_t) (crc >> 8));
+}
+
+bool PicLink::transact_(uint8_t cmd, const uint8_t *payload, uint16_t length, uint16_t *response_length) {
+  // Släng eventuella rester från en tidigare, avbruten transaktion
+  uint8_t junk;
+  while (this->available())
+    this->read_byte(&junk);
+
+  this->send_frame_(cmd, payload, length);
+
+  uint32_t deadline = millis() + LINK_TIMEOUT_MS;
+  uint8_t data = 0;
+  do {
+    if (!this->read_byte_timeout_(&data, deadline)) {
+      ESP_LOGW(TAG, "Timeout i väntan på svar (CMD 0x%02X)", cmd);
+      return false;
+    }
+  } while (data != LINK_SYNC);
+
+  uint8_t header[3];
+  for (uint8_t &b : header) {
+    if (!this->read_byte_timeout_(&b, deadline))
+      return false;
+  }
+  uint16_t crc = 0xFFFF;
+  for (uint8_t b : header)
+    crc = crc16_update_(crc, b);
+
+  uint16_t rx_length = header[1] | (header[2] << 8);
+  if (rx_length > this->response_.size()) {
+    ESP_LOGW(TAG, "För lång svarsram (%u bytes)", rx_length);
+    return false;
+  }
+  for (uint16_t i = 0; i < rx_length; i++) {
+    if (!this->read_byte_timeout_(&this->response_[i], deadline))
+      return false;
+    crc = crc16_update_(crc, this->response_[i]);
+  }
+
+  uint8_t crc_lo, crc_hi;
+  if (!this->read_byte_timeout_(&crc_lo, deadline) || !this->read_byte_timeout_(&crc_hi, deadline))
+    return false;
+  if (crc != (uint16_t) (crc_lo | (crc_hi << 8))) {
+    ESP_LOGW(TAG, "CRC-fel i svar (CMD 0x%02X)", cmd);
+    return false;
+  }
+  if (header[0] == (cmd | LINK_ERROR_FLAG)) {
+    ESP_LOGW(TAG, "PIC svarade med fel 0x%02X (CMD 0x%02X)", rx_length ? this->response_[0] : 0, cmd);
+    return false;
+  }
+  if (header[0] != (cmd | LINK_RESPONSE_FLAG))
+    return false;
+
+  *response_length = rx_length;
+  return true;
+}
+
+bool PicLink::read_byte_timeout_(uint8_t *data, uint32_t deadline) {
+  while (!this->available()) {
+    if ((int32_t) (millis() - deadline) >= 0)
+      return false;
+    yield();
+  }
+  return this->read_byte(data);
+}
+
+uint16_t PicLink::crc16_update_(uint16_t crc, uint8_t data) {
+  // Modbus CRC-16 (polynom 0xA001), samma som firmware/pic_bridge/crc.c
+  crc ^= data;
+  for (uint8_t i = 0; i < 8; i++)
+    crc = (crc & 1) ? (crc >> 1) ^ 0xA001 : (crc >> 1);
+  return crc;
+}
+
+uint32_t PicLink::baud_from_code_(uint8_t code) {
+  switch (code) {
+    case LINK_BAUD_230400:
+      return 230400;
+    case LINK_BAUD_460800:
+      return 460800;
+    case LINK_BAUD_1000000:
+      return 1000000;
+    default:
+      return 115200;
+  }
+}
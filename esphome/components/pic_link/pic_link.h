@@ -0,0 +1,95 @@
+#pragma once
+
+#include "esphome/core/component.h"
+#include "esphome/core/helpers.h"
+#include "esphome/components/uart/uart.h"
+#include <array>
+#include <functional>
+
+namespace esphome {
+namespace pic_link {
+
+// Ramat binärprotokoll mot PIC18F47Q43 (UART2). Måste matcha firmware/pic_bridge/esp_link.h.
+// Ram: SYNC | CMD | LEN_LO | LEN_HI | PAYLOAD[LEN] | CRC_LO | CRC_HI (Modbus CRC-16 över CMD..PAYLOAD)
+static const uint8_t LINK_SYNC = 0xA5;
+static const uint8_t LINK_CMD_HELLO = 0x01;
+static const uint8_t LINK_CMD_READ_BLOCK = 0x02;
+static const uint8_t LINK_CMD_WRITE_BLOCK = 0x03;
+static const uint8_t LINK_CMD_SET_BAUD = 0x04;
+static const uint8_t LINK_CMD_READ_EVENTS = 0x05;
+static const uint8_t LINK_RESPONSE_FLAG = 0x80;
+static const uint8_t LINK_ERROR_FLAG = 0x40;
+
+static const uint8_t LINK_BAUD_115200 = 0;
+static const uint8_t LINK_BAUD_230400 = 1;
+static const uint8_t LINK_BAUD_460800 = 2;
+static const uint8_t LINK_BAUD_1000000 = 3;
+
+static const uint16_t PIC_TOTAL_REGS = 256;
+static const uint16_t LINK_MAX_PAYLOAD = 1 + PIC_TOTAL_REGS;
+static const uint8_t LINK_MAX_EVENTS = 63;
+static const uint8_t LINK_EVENT_SIZE = 4;
+
+// En av pumpens I2C-skrivningar, loggad av PIC:en (firmware/pic_bridge/events.h)
+struct PicEvent {
+  uint16_t tick_ms;  // PIC:ens millisekundräknare (slår runt efter 65.5 s)
+  uint8_t reg;
+  uint8_t value;
+};
+
+class PicLink : public PollingComponent, public uart::UARTDevice {
+ public:
+  // Högsta baudkod att förhandla fram (begränsas även av PIC:ens HELLO-svar)
+  void set_max_baud_code(uint8_t code) { max_baud_code_ = code; }
+
+  void setup() override;
+  void update() override;
+  void dump_config() override;
+  float get_setup_priority() const override { return setup_priority::DATA; }
+
+  // Läser/skriver ett block av PIC:ens registerMap. count = 1..256.
+  bool read_block(uint8_t start, uint16_t count, uint8_t *out);
+  bool write_block(uint8_t start, const uint8_t *data, uint16_t count);
+
+  // Tömmer PIC:ens händelse-FIFO och anropar callbacks per händelse. Körs i update().
+  bool drain_events();
+  void add_on_event_callback(std::function<void(const PicEvent &)> &&callback) {
+    this->event_callback_.add(std::move(callback));
+  }
+  // Händelser PIC:en kastat för att FIFO:n var full
+  uint8_t get_event_overflows() const { return event_overflows_; }
+
+  // Värden från senaste ögonblicksbilden (hela registerMap i en ram)
+  bool has_snapshot() const { return snapshot_valid_; }
+  uint8_t get_register(uint8_t index) const { return snapshot_[index]; }
+  // HI/LO-par som signerat ord, t.ex. REG_ADC_NTC_OUTDOOR_HI (°C * 100)
+  int16_t get_word(uint8_t hi_index) const {
+    return (int16_t) ((snapshot_[hi_index] << 8) | snapshot_[(uint8_t) (hi_index + 1)]);
+  }
+
+ protected:
+  uint8_t max_baud_code_{LINK_BAUD_1000000};
+  uint8_t baud_code_{LINK_BAUD_115200};
+  uint8_t pic_fw_major_{0};
+  uint8_t pic_fw_minor_{0};
+  bool linked_{false};
+  bool snapshot_valid_{false};
+  std::array<uint8_t, PIC_TOTAL_REGS> snapshot_{};
+  std::array<uint8_t, LINK_MAX_PAYLOAD> response_{};
+  uint8_t events_unacked_{0};
+  uint8_t event_overflows_{0};
+  CallbackManager<void(const PicEvent &)> event_callback_;
+
+  bool negotiate_();
+  bool hello_(uint8_t *pic_max_baud_code);
+  bool set_baud_(uint8_t code);
+  // Skickar en ram och väntar på svaret. Svarets payload hamnar i response_.
+  bool transact_(uint8_t cmd, const uint8_t *payload, uint16_t length, uint16_t *response_length);
+  void send_frame_(uint8_t cmd, const uint8_t *payload, uint16_t length);
+  bool read_byte_timeout_(uint8_t *data, uint32_t deadline);
+  static uint16_t crc16_update_(uint16_t crc, uint8_t data);
+  static uint32_t baud_from_code_(uint8_t code);
+};
+
+}  // namespace pic_link
+}  // namespace esphome
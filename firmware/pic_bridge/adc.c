@@ -1,124 +1,157 @@
 #include "adc.h"
 #include "globals.h"
-#include "spoofer.h" // För ResistanceToTemp_100x
+#include "ntc_table.h"
+#include "regmap.h"
 #include <xc.h>
-#include <stdio.h>
 
 // Vi antar att NTC-givaren är kopplad i en spänningsdelare
 // med ett fast motstånd R_fix = 10 kOhm (10000 Ohm) till VCC.
 // ADC-värdet (Vout) mäts mellan R_fix och NTC (R_ntc).
+// OBS: Ändras spänningsdelaren måste tools/gen_ntc_table.py uppdateras och köras om.
 #define R_FIX_OHM_100X 1000000L // 10000 Ohm * 100
-#define ADC_MAX_VALUE  1023      // 10-bitars ADC (0-1023)
+#define ADC_MAX_VALUE  1023      // Tabellindex: 10-bitars kod (0-1023)
 
-// Interna tillstånd för ADC-sekvensering
-#define CHANNEL_OUTDOOR 0b00001 // AN1 (RA1)
-#define CHANNEL_INDOOR  0b00101 // AN5 (RB5)
+// ADCC Burst Average: ADC_BURST_SAMPLES 12-bitars sampel summeras i ADACC och
+// ADFLTR = summa >> ADC_BURST_SHIFT. 64 sampel >> 4 ger ett 14-bitars värde.
+#define ADC_BURST_SAMPLES    64
+#define ADC_BURST_SHIFT      4
+#define ADC_OVERSAMPLED_BITS 14
+#define ADC_TABLE_SHIFT      (ADC_OVERSAMPLED_BITS - 10) // 14 bit -> tabellindex
+
+// Brusmått: glidande medel (1/8) av |skillnaden| mellan två bursts, i 1/16 LSB
+#define ADC_NOISE_SHIFT      3
+#define ADC_NOISE_FRACTION   4
+
+// Insamlingstid före första samplet efter kanalbyte (ADC-klockor, ~16 us)
+#define ADC_ACQUISITION_TAD  8
+
+// Kanaler (ADPCH)
+#define CHANNEL_OUTDOOR 0b000001 // ANA1 (RA1)
+#define CHANNEL_INDOOR  0b001101 // ANB5 (RB5)
+
+typedef struct {
+    uint8_t channel;
+    uint8_t temp_hi_reg;        // REG_ADC_NTC_*_HI
+    uint8_t oversampled_hi_reg; // REG_ADC_*_OVERSAMPLED_HI
+    uint8_t noise_hi_reg;       // REG_ADC_*_NOISE_HI
+    uint16_t last;              // Förra burstens 14-bitars värde
+    uint16_t noise;             // 1/16 LSB
+    bool primed;
+} adc_channel_t;
+
+static adc_channel_t channels[] = {
+    { CHANNEL_OUTDOOR, REG_ADC_NTC_OUTDOOR_HI, REG_ADC_OUTDOOR_OVERSAMPLED_HI, REG_ADC_OUTDOOR_NOISE_HI, 0, 0, false },
+    { CHANNEL_INDOOR,  REG_ADC_NTC_INDOOR_HI,  REG_ADC_INDOOR_OVERSAMPLED_HI,  REG_ADC_INDOOR_NOISE_HI,  0, 0, false },
+};
+#define ADC_CHANNELS (sizeof(channels) / sizeof(channels[0]))
+
+static uint8_t active_channel = 0;
+static bool burst_running = false;
+
+// Skrivs av ISR:en, läses av ADC_Process först när burst_done är satt
+static volatile uint16_t burst_result;
+static volatile bool burst_done = false;
 
 void ADC_Init(void) {
     // ADC Konfiguration:
-    
+
     // 1. Vref: VDD (5V)
     ADREFbits.ADNREF = 0; // Vref- = Vss
     ADREFbits.ADPREF = 0b00; // Vref+ = VDD
 
     // 2. Clock: Fosc/64 (ADC-klocka ~1MHz)
     ADCLK = 0x3F; // Fosc/64
-    
-    // 3. Resultatformat: Högerjusterat (10-bitars)
-    ADCON0bits.FM = 0b01; 
-    
-    // 4. Initial kanal: Utetemp AN1
-    ADCON0bits.ADCH = CHANNEL_OUTDOOR; 
-    
+
+    // 3. Resultatformat: Högerjusterat
+    ADCON0bits.FM = 1;
+
+    // 4. Beräkningsenheten: Burst Average, hårdvaran summerar och skiftar
+    ADCON2bits.MD = 0b011;          // Burst Average
+    ADCON2bits.CRS = ADC_BURST_SHIFT;
+    ADRPT = ADC_BURST_SAMPLES;
+    ADACQ = ADC_ACQUISITION_TAD;    // Kanalen hinner svänga in efter bytet
+    ADCON3bits.TMD = 0b111;         // Tröskelavbrott efter varje burst (ingen tröskel)
+
+    // 5. Initial kanal: Utetemp
+    ADPCH = channels[0].channel;
+
+    // 6. ADTIF på låg prioritet, ett avbrott per burst
+    IPR1bits.ADTIP = 0;
+    PIR1bits.ADTIF = 0;
+    PIE1bits.ADTIE = 1;
+
     ADCON0bits.ADON = 1; // Slå på ADC-modulen
 }
 
+bool ADC_ISR_Handler(void) {
+    if (!(PIE1bits.ADTIE && PIR1bits.ADTIF)) {
+        return false;
+    }
+    PIR1bits.ADTIF = 0;
+    burst_result = ADFLTR;
+    burst_done = true;
+    return true;
+}
+
 /**
- * @brief Beräknar NTC-motståndet baserat på rådata från ADC.
- * Förutsätter en spänningsdelare med R_fix på 10kOhm mot VCC.
- * R_NTC = R_fix * ( (ADC_MAX_VALUE + 1) / ADC_VALUE - 1 )
- * @param adc_raw Råvärde från ADC (0-1023).
- * @return Motstånd i Ohm * 100 (int32_t).
+ * @brief Slår upp temperaturen ur tabellen och interpolerar med de extra bitarna.
+ * Tabellerna i ntc_table.c genereras av tools/gen_ntc_table.py med samma
+ * spänningsdelare (R_FIX_OHM_100X) och kurvor som tidigare.
+ * @param oversampled 14-bitars värde från burst-medelvärdet.
+ * @return Temperatur i °C * 100 för vald NTC-kurva (REG_NTC_CURVE_SELECT).
  */
-static int32_t calculate_ntc_resistance(uint16_t adc_raw) {
-    if (adc_raw == 0) {
-        return 5000000L; // Maxvärde (50kOhm * 100)
+static int16_t adc_oversampled_to_temp_100x(uint16_t oversampled) {
+    const int16_t *table = (registerMap[REG_NTC_CURVE_SELECT] == 0)
+                           ? NTC_TABLE_22KOHM   // 0 = 22 kOhm
+                           : NTC_TABLE_150OHM;  // 1 = 150 Ohm (Default)
+    uint16_t code = oversampled >> ADC_TABLE_SHIFT;
+    uint8_t fraction = oversampled & ((1 << ADC_TABLE_SHIFT) - 1);
+
+    if (code >= ADC_MAX_VALUE) {
+        return table[ADC_MAX_VALUE];
     }
-    
-    int32_t numerator = (int32_t)R_FIX_OHM_100X * 1024L;
-    int32_t term1 = numerator / adc_raw;
-    int32_t term2 = R_FIX_OHM_100X;
-    
-    int32_t resistance_100x = term1 - term2;
-    
-    if (resistance_100x > 5000000L) {
-        return 5000000L;
+    int16_t t0 = table[code];
+    int16_t t1 = table[code + 1];
+    return (int16_t)(t0 + (((int32_t)(t1 - t0) * fraction) >> ADC_TABLE_SHIFT));
+}
+
+static void adc_store_result(adc_channel_t *ch, uint16_t oversampled) {
+    // Brus: skillnaden mot förra bursten på samma kanal
+    if (ch->primed) {
+        uint16_t delta = (oversampled > ch->last) ? oversampled - ch->last : ch->last - oversampled;
+        uint16_t delta_scaled = (delta >= (0xFFFF >> ADC_NOISE_FRACTION))
+                                ? 0xFFFF : (uint16_t)(delta << ADC_NOISE_FRACTION);
+        // noise += (delta - noise) / 8
+        int32_t step = ((int32_t)delta_scaled - ch->noise) >> ADC_NOISE_SHIFT;
+        ch->noise = (uint16_t)(ch->noise + step);
     }
-    
-    return resistance_100x;
+    ch->last = oversampled;
+    ch->primed = true;
+
+    REGMAP_WriteWord(ch->temp_hi_reg, (uint16_t)adc_oversampled_to_temp_100x(oversampled));
+    REGMAP_WriteWord(ch->oversampled_hi_reg, oversampled);
+    REGMAP_WriteWord(ch->noise_hi_reg, ch->noise);
+
+    // Råvärde som tabellindex (för debug/kalibrering)
+    REGMAP_WriteWord(REG_ADC_NTC_RAW_HI, oversampled >> ADC_TABLE_SHIFT);
 }
 
+void ADC_Process(void) {
+    if (burst_done) {
+        // Resultatet är stabilt: ingen ny burst startas förrän det är läst
+        burst_done = false;
+        burst_running = false;
+        adc_store_result(&channels[active_channel], burst_result);
+
+        // Nästa kanal; ADACQ ger insvängningstid när bursten startar
+        active_channel++;
+        if (active_channel >= ADC_CHANNELS) active_channel = 0;
+        ADPCH = channels[active_channel].channel;
+    }
 
-bool ADC_Process(void) {
-    static uint8_t state = 0;
-    static uint16_t timer = 0; 
-    static uint8_t current_channel = CHANNEL_OUTDOOR; // AN1
-
-    timer++; 
-    
-    switch(state) {
-        case 0: // Starta konvertering (vänta 1000 cykler)
-            if (timer > 1000) { 
-                ADCON0bits.ADGO = 1; // Starta konvertering
-                state = 1;
-                timer = 0;
-            }
-            break;
-            
-        case 1: // Vänta på resultat
-            if (!ADCON0bits.ADGO) {
-                // Konvertering klar
-                uint16_t adc_raw = (ADRESH << 8) | ADRESL;
-                
-                // --- 1. Konvertera och lagra värdet för den just avlästa kanalen ---
-                int32_t resistance_100x = calculate_ntc_resistance(adc_raw);
-                int16_t temp_100x;
-                uint8_t hi_reg, lo_reg;
-                
-                // Välj rätt NTC-kurva och lagra resultatet på rätt plats i registerMap
-                
-                if (current_channel == CHANNEL_OUTDOOR) {
-                    temp_100x = ResistanceToTemp_100x(resistance_100x); 
-                    hi_reg = REG_ADC_NTC_OUTDOOR_HI;
-                    lo_reg = REG_ADC_NTC_OUTDOOR_LO;
-                    
-                    // Nästa kanal blir INNE
-                    current_channel = CHANNEL_INDOOR;
-                    ADCON0bits.ADCH = CHANNEL_INDOOR;
-                    
-                } else { // current_channel == CHANNEL_INDOOR
-                    temp_100x = ResistanceToTemp_100x(resistance_100x); 
-                    hi_reg = REG_ADC_NTC_INDOOR_HI;
-                    lo_reg = REG_ADC_NTC_INDOOR_LO;
-                    
-                    // Nästa kanal blir UTE
-                    current_channel = CHANNEL_OUTDOOR;
-                    ADCON0bits.ADCH = CHANNEL_OUTDOOR;
-                }
-                
-                // Lagra beräknad temperatur
-                registerMap[hi_reg] = (uint8_t)((temp_100x >> 8) & 0xFF);
-                registerMap[lo_reg] = (uint8_t)(temp_100x & 0xFF);
-                
-                // Lagra råvärde (för debug/kalibrering)
-                registerMap[REG_ADC_NTC_RAW_HI] = (uint8_t)((adc_raw >> 8) & 0xFF);
-                registerMap[REG_ADC_NTC_RAW_LO] = (uint8_t)(adc_raw & 0xFF);
-                       
-                state = 0; // Gå tillbaka till start
-                timer = 0;
-                return true;
-            }
-            break;
+    if (!burst_running) {
+        ADCON2bits.ACLR = 1; // Nollställ ADACC/ADCNT inför bursten
+        ADCON0bits.ADGO = 1;
+        burst_running = true;
     }
-    return false;
 }
@@ -3,16 +3,27 @@
 
 #include <stdbool.h>
 
+// Schemaläggarens period för ADC_Process. Varje körning tar hand om förra
+// burst-medelvärdet och startar nästa på andra kanalen, så varje kanal får
+// ett översamplat värde varannan period (500 ms).
+#define ADC_TASK_PERIOD_MS 250
+
 /**
  * @brief Initierar ADC-modulen på PIC:en.
  */
 void ADC_Init(void);
 
 /**
- * @brief Läser av ADC-värdet från NTC-givaren och konverterar till temperatur.
- * Resultatet lagras i registerMap.
- * @return true om en ny mätning slutfördes.
+ * @brief ADCC tröskelavbrott (ADTIF): en burst är klar och ADFLTR håller medelvärdet.
+ * Den är designad att kallas från låg-prioritets-ISR i main.c.
+ * @return true om avbrottet hanterades, false annars.
+ */
+bool ADC_ISR_Handler(void);
+
+/**
+ * @brief Konverterar senaste burst-medelvärdet till temperatur och startar nästa.
+ * Resultatet, det översamplade värdet och brusmåttet lagras i registerMap.
  */
-bool ADC_Process(void);
+void ADC_Process(void);
 
 #endif // ADC_H
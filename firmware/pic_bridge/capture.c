@@ -0,0 +1,172 @@
+#include "capture.h"
+#include "globals.h"
+#include "scheduler.h"
+#include "debug.h"
+#include <xc.h>
+
+#define CAPTURE_FAST_BAUD 1000000UL
+
+// Antal poster som tidtas i CAPTURE_Init (TMR1-tick = 8 instruktionscykler)
+#define CAPTURE_CALIBRATION_RECORDS 16
+
+// Producent: I2C-ISR:en (hög prioritet). Konsument: UART3-ISR:en (låg prioritet, debug.c).
+// Posterna är 4 byte och bufferten 256, så en post delas aldrig av omslaget.
+static volatile uint8_t buffer[CAPTURE_BUFFER_SIZE];
+static volatile uint8_t head = 0; // Skrivs av I2C-ISR:en
+static volatile uint8_t tail = 0; // Skrivs av UART3-ISR:en
+
+static volatile bool capture_on = false;
+static volatile bool addr_due = false;  // Adressposten skrivs vid första databyten
+static volatile uint8_t lost = 0;       // Kastade poster sedan senaste CAPTURE_LOST
+
+static uint8_t active_control = 0;      // Senast tillämpade REG_I2C_CAPTURE_CONTROL
+static volatile bool fast_baud = false; // Läses av UART3-ISR:en via CAPTURE_Active
+
+static const uint8_t header[] = { 'I', '2', 'C', 'C', 'A', 'P', CAPTURE_FORMAT_VERSION, CAPTURE_RECORD_SIZE };
+
+static void capture_put(uint8_t hdr, uint8_t data, uint16_t stamp) {
+    uint8_t h = head;
+    buffer[h] = hdr;
+    buffer[(uint8_t)(h + 1)] = data;
+    buffer[(uint8_t)(h + 2)] = (uint8_t)(stamp & 0xFF);
+    buffer[(uint8_t)(h + 3)] = (uint8_t)(stamp >> 8);
+    head = (uint8_t)(h + CAPTURE_RECORD_SIZE);
+}
+
+// Ledigt utrymme räcker för count poster? En plats hålls tom för att skilja full från tom.
+static bool capture_room(uint8_t count) {
+    return (uint8_t)(tail - head - 1) >= (uint8_t)(count * CAPTURE_RECORD_SIZE);
+}
+
+static void capture_drop(void) {
+    if (lost != 0xFF) {
+        lost++;
+    }
+    registerMap[REG_I2C_CAPTURE_LOST]++;
+}
+
+// Förlustposten måste före nästa post så att värddatorn ser var luckan är
+static bool capture_flush_lost(uint8_t following) {
+    if (lost == 0) {
+        return capture_room(following);
+    }
+    if (!capture_room((uint8_t)(following + 1))) {
+        return false;
+    }
+    capture_put(CAPTURE_HDR(CAPTURE_LOST, 0), lost, TMR1);
+    lost = 0;
+    return true;
+}
+
+void CAPTURE_Init(void) {
+    // Tidta CAPTURE_Record med avbrotten avslagna. Slingans overhead räknas in.
+    INTCON0bits.GIE = 0;
+    head = 0;
+    tail = 0;
+    capture_on = true;
+    uint16_t start = TMR1;
+    for (uint8_t i = 0; i < CAPTURE_CALIBRATION_RECORDS; i++) {
+        CAPTURE_Record(CAPTURE_HDR(CAPTURE_WRITE, 0), i);
+    }
+    uint16_t ticks = (uint16_t)(TMR1 - start);
+    capture_on = false;
+    head = 0;
+    tail = 0;
+    lost = 0;
+    INTCON0bits.GIE = 1;
+
+    uint16_t cycles = (uint16_t)(((uint32_t)ticks * 8) / CAPTURE_CALIBRATION_RECORDS);
+    registerMap[REG_I2C_CAPTURE_CYCLES] = (cycles > 0xFF) ? 0xFF : (uint8_t)cycles;
+    registerMap[REG_I2C_CAPTURE_CONTROL] = 0;
+    registerMap[REG_I2C_CAPTURE_LOST] = 0;
+
+}
+
+void CAPTURE_Record(uint8_t hdr, uint8_t data) {
+    if (!capture_on) {
+        return;
+    }
+    if (addr_due) {
+        if (!capture_flush_lost(2)) {
+            capture_drop();
+            return;
+        }
+        addr_due = false;
+        capture_put(CAPTURE_HDR(CAPTURE_ADDR, 0), I2C1ADB0, TMR1);
+    } else if (!capture_flush_lost(1)) {
+        capture_drop();
+        return;
+    }
+    capture_put(hdr, data, TMR1);
+}
+
+void CAPTURE_RecordStart(bool restart) {
+    if (!capture_on) {
+        return;
+    }
+    addr_due = true;
+    if (restart) {
+        if (capture_flush_lost(1)) {
+            capture_put(CAPTURE_HDR(CAPTURE_RESTART, 0), 0, TMR1);
+        } else {
+            capture_drop();
+        }
+        return;
+    }
+    // Tidsposten förankrar TMR1-tiderna i transaktionen till millisekundticken
+    if (capture_flush_lost(2)) {
+        capture_put(CAPTURE_HDR(CAPTURE_TIME, 0), 0, SCHEDULER_Millis());
+        capture_put(CAPTURE_HDR(CAPTURE_START, 0), 0, TMR1);
+    } else {
+        capture_drop();
+    }
+}
+
+void CAPTURE_Process(void) {
+    uint8_t control = registerMap[REG_I2C_CAPTURE_CONTROL];
+
+    if (control != active_control) {
+        active_control = control;
+        capture_on = false; // ISR:en slutar producera, kvarvarande poster skickas klart
+
+        if (control & CAPTURE_CONTROL_ON) {
+            // Börja om med tom buffert. UART3-ISR:en hålls ute medan index nollställs.
+            PIE9bits.U3TXIE = 0;
+            while (!U3ERRIRbits.TXMTIF); // Sista byten från förra fångsten
+            fast_baud = (control & CAPTURE_CONTROL_FAST) != 0;
+            DEBUG_SetBaudRate(fast_baud ? CAPTURE_FAST_BAUD : DEBUG_BAUD);
+
+            head = 0;
+            tail = 0;
+            lost = 0;
+            addr_due = false;
+            for (uint8_t i = 0; i < sizeof(header); i++) {
+                buffer[i] = header[i];
+            }
+            head = sizeof(header);
+            capture_on = true;
+        }
+    }
+
+    if (head != tail) {
+        PIE9bits.U3TXIE = 1;
+    } else if (fast_baud && !capture_on && U3ERRIRbits.TXMTIF) {
+        // Fångsten avslutad och utskickad: tillbaka till debug-hastigheten
+        fast_baud = false;
+        DEBUG_SetBaudRate(DEBUG_BAUD);
+        PIE9bits.U3TXIE = 1; // Loggmeddelanden som väntat under fångsten
+    }
+}
+
+bool CAPTURE_TxNext(uint8_t *out) {
+    if (tail == head) {
+        return false; // CAPTURE_Process slår på sändningen igen när det kommit nya poster
+    }
+    *out = buffer[tail];
+    tail++;
+    return true;
+}
+
+bool CAPTURE_Active(void) {
+    return capture_on || fast_baud || (head != tail);
+}
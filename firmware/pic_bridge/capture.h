@@ -0,0 +1,77 @@
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// --- Bussfångst av pumpens I2C-trafik (för att kartlägga okända ThermIQ-register) ---
+// Slås på med REG_I2C_CAPTURE_CONTROL. I2C-ISR:en lägger varje START/adress/
+// data/STOP som en post i en ringbuffert som UART3-avbrottet skickar vidare.
+// Avkodas på värddatorn med tools/i2c_capture_decode.cpp (text eller pcap).
+//
+// Strömformat: ett huvud när fångsten slås på, därefter poster om 4 byte:
+//   Huvud: 'I' '2' 'C' 'C' 'A' 'P' CAPTURE_FORMAT_VERSION CAPTURE_RECORD_SIZE
+//   Post:  [typ << 4 | flaggor] [data] [tid LO] [tid HI]
+// Tiden är TMR1 (0.5 us, slår runt efter 32.8 ms) utom för CAPTURE_TIME som
+// bär SCHEDULER_Millis() och läggs före varje START.
+
+#define CAPTURE_FORMAT_VERSION 1
+#define CAPTURE_RECORD_SIZE    4
+#define CAPTURE_BUFFER_SIZE    256 // 64 poster, 8-bitars index slår runt av sig självt
+
+// Posttyper (övre nibbeln)
+#define CAPTURE_TIME    0x1 // data = 0, tid = ms
+#define CAPTURE_START   0x2
+#define CAPTURE_RESTART 0x3
+#define CAPTURE_STOP    0x4
+#define CAPTURE_ADDR    0x5 // data = adressbyte inkl. R/W (I2C1ADB0)
+#define CAPTURE_WRITE   0x6 // Master -> PIC
+#define CAPTURE_READ    0x7 // PIC -> Master
+#define CAPTURE_ERROR   0x8 // data = I2C1ERR (BCLIF/BTOIF/NACKIF)
+#define CAPTURE_LOST    0x9 // data = antal poster som kastats före denna (mättar vid 255)
+
+// Flaggor (nedre nibbeln)
+#define CAPTURE_FLAG_IGNORED 0x1 // I2C avstängd (REG_I2C_ENABLE_CONTROL = 0), byten hanterades inte
+
+// Postens första byte
+#define CAPTURE_HDR(type, flags) ((uint8_t)(((type) << 4) | (flags)))
+
+// REG_I2C_CAPTURE_CONTROL
+#define CAPTURE_CONTROL_ON   0x01
+#define CAPTURE_CONTROL_FAST 0x02 // UART3 i 1 Mbaud under fångsten (annars 115200)
+
+/**
+ * @brief Nollställer fångsten och mäter vad en post kostar i ISR:en
+ * (REG_I2C_CAPTURE_CYCLES). Anropas efter I2C_Init(), som startar TMR1.
+ */
+void CAPTURE_Init(void);
+
+/**
+ * @brief Lägger en post med första byte hdr (CAPTURE_HDR). Anropas endast från I2C-ISR:en.
+ * Avstängd fångst kostar ett test; påslagen ett fast antal cykler (REG_I2C_CAPTURE_CYCLES).
+ * Första WRITE/READ efter START/RESTART föregås av en CAPTURE_ADDR-post.
+ */
+void CAPTURE_Record(uint8_t hdr, uint8_t data);
+
+/**
+ * @brief START (CAPTURE_TIME + CAPTURE_START) eller RESTART. Anropas endast från I2C-ISR:en.
+ */
+void CAPTURE_RecordStart(bool restart);
+
+/**
+ * @brief Följer REG_I2C_CAPTURE_CONTROL, byter UART3-hastighet och startar sändningen.
+ */
+void CAPTURE_Process(void);
+
+/**
+ * @brief Nästa byte att skicka. Anropas från UART3-ISR:en (debug.c).
+ * @return false om inget väntar.
+ */
+bool CAPTURE_TxNext(uint8_t *out);
+
+/**
+ * @brief UART3 används av fångsten (påslagen, poster kvar eller 1 Mbaud). Loggen väntar då.
+ */
+bool CAPTURE_Active(void);
+
+#endif // CAPTURE_H
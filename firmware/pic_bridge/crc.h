@@ -0,0 +1,20 @@
+#ifndef CRC_H
+#define CRC_H
+
+#include <stdint.h>
+
+// Startvärde för Modbus CRC-16 (polynom 0xA001, reflekterat)
+#define CRC16_INIT 0xFFFF
+
+/**
+ * @brief Uppdaterar en Modbus CRC-16 med en byte (tabelldriven, ingen bitloop).
+ */
+uint16_t CRC16_Update(uint16_t crc, uint8_t data);
+
+/**
+ * @brief Beräknar Modbus CRC-16 över en buffert.
+ * Resultatet skickas LSB först på linan.
+ */
+uint16_t CRC16_Compute(const volatile uint8_t *data, uint16_t length);
+
+#endif // CRC_H
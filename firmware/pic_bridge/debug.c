@@ -1,20 +1,39 @@
 #include "debug.h"
 #include "globals.h"
-#include <stdio.h>
+#include "capture.h"
+#include "log.h"
 
 void DEBUG_Init(void) {
     // UART3 konfigureras för 115200 Baud @ 64MHz
-    // U3BRG = (_XTAL_FREQ / (16 * Baud)) - 1 = (64000000 / (16 * 115200)) - 1 = 33.72 -> 34
-    U3BRG = 34; 
-    U3CON0bits.BRGS = 0; // High speed mode (BRG16=0)
+    DEBUG_SetBaudRate(DEBUG_BAUD);
     U3CON0bits.TXEN = 1; // Enable Transmitter
     U3CON0bits.RXEN = 1; // Enable Receiver
     U3CON1bits.ON = 1;   // Enable UART3
+
+    // Låg prioritet, I2C-slaven går först
+    IPR9bits.U3TXIP = 0;
+    PIE9bits.U3TXIE = 0; // Slås på av loggen/fångsten när det finns data att skicka
+}
+
+void DEBUG_SetBaudRate(uint32_t baud) {
+    // High speed mode (BRGS=1): U3BRG = (Fosc / (4 * Baud)) - 1, avrundat
+    // 115200 -> 138, 1000000 -> 15 (exakt)
+    U3CON0bits.BRGS = 1;
+    U3BRG = (uint16_t)(((_XTAL_FREQ + 2 * baud) / (4 * baud)) - 1);
 }
 
-// putch är den funktionen XC8-kompilatorn kallar när man använder printf
-void putch(char data) {
-    // Vänta tills TX-bufferten är tom (TXMTIF = Transmit Shift Register Empty)
-    while(!U3ERRIRbits.TXMTIF); 
-    U3TXB = data;
+bool DEBUG_ISR_Handler(void) {
+    if (!(PIE9bits.U3TXIE && PIR9bits.U3TXIF)) {
+        return false;
+    }
+    // Fyll HW-FIFO:n. Bussfångsten går först, loggen väntar så länge den pågår.
+    uint8_t data;
+    while (!U3FIFObits.TXBF) {
+        if (!CAPTURE_TxNext(&data) && !LOG_TxNext(&data)) {
+            PIE9bits.U3TXIE = 0; // Inget mer att skicka
+            break;
+        }
+        U3TXB = data;
+    }
+    return true;
 }
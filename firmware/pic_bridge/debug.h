@@ -1,9 +1,27 @@
 #ifndef DEBUG_H
 #define	DEBUG_H
 
+#include <stdint.h>
+#include <stdbool.h>
+
+#define DEBUG_BAUD 115200UL
+
+/**
+ * @brief Initierar UART3 (Debug). Allt som skickas köas och skickas av avbrottet:
+ * tokeniserad logg (log.c) och bussfångst (capture.c). printf används inte.
+ */
 void DEBUG_Init(void);
 
-// putch är standardfunktionen som används av printf i XC8
-void putch(char data);
+/**
+ * @brief Sätter UART3:s hastighet (capture.c kör fångsten i 1 Mbaud).
+ */
+void DEBUG_SetBaudRate(uint32_t baud);
+
+/**
+ * @brief UART3 TX Interrupt Service Routine Logic.
+ * Den är designad att kallas från låg-prioritets-ISR i main.c.
+ * @return true om avbrottet hanterades, false annars.
+ */
+bool DEBUG_ISR_Handler(void);
 
 #endif	/* DEBUG_H */
@@ -0,0 +1,317 @@
+#include "esp_link.h"
+#include "globals.h"
+#include "uart2.h"
+#include "crc.h"
+#include "regmap.h"
+#include "events.h"
+#include "log.h"
+
+// Minsta lediga TX-plats innan en ny ram tolkas (header + kort payload + CRC).
+// Längre svar (READ_BLOCK) strömmas direkt ur registerMap i den takt det finns plats.
+#define LINK_TX_RESERVE 16
+
+// Antal ramfel efter ett baudbyte innan PIC:en faller tillbaka till UART2_DEFAULT_BAUD.
+// Inträffar när ESP:n startat om och pratar standardhastighet igen.
+#define LINK_FALLBACK_FRAMING_ERRORS 4
+
+#define LINK_NO_BAUD_CHANGE 0xFF
+
+static const uint32_t LINK_BAUD_RATES[] = {115200UL, 230400UL, 460800UL, 1000000UL};
+
+typedef enum {
+    LINK_RX_IDLE = 0,
+    LINK_RX_CMD,
+    LINK_RX_LEN_LO,
+    LINK_RX_LEN_HI,
+    LINK_RX_PAYLOAD,
+    LINK_RX_CRC_LO,
+    LINK_RX_CRC_HI,
+    // Gamla protokollet
+    LINK_RX_LEGACY_READ_INDEX,
+    LINK_RX_LEGACY_WRITE_INDEX,
+    LINK_RX_LEGACY_WRITE_VALUE
+} link_rx_state_t;
+
+// --- Mottagning ---
+static link_rx_state_t rx_state = LINK_RX_IDLE;
+static uint8_t rx_cmd;
+static uint16_t rx_len;
+static uint16_t rx_pos;
+static uint16_t rx_crc;
+static uint8_t rx_crc_lo;
+static uint8_t rx_payload[LINK_MAX_PAYLOAD];
+static uint8_t legacy_index;
+static bool frame_pending = false; // Ram mottagen men inte besvarad (väntar på konsekvent läsning)
+
+// --- Sändning ---
+static bool tx_active = false;
+static uint16_t tx_stream_index;     // Nästa index i tx_snapshot att strömma
+static uint16_t tx_stream_remaining; // Antal bytes kvar att strömma
+static uint16_t tx_crc;
+
+// READ_BLOCK (konsekvent kopia av registerMap) och READ_EVENTS strömmas härifrån
+static uint8_t tx_snapshot[TOTAL_REGS];
+static regmap_wait_t snapshot_wait;
+
+// Antal händelser i senaste READ_EVENTS-svaret (tas bort när ESP:n kvitterar dem)
+static uint8_t events_unacked = 0;
+
+// --- Baudförhandling ---
+static uint8_t pending_baud_code = LINK_NO_BAUD_CHANGE;
+static uint8_t current_baud_code = LINK_BAUD_115200;
+static uint8_t framing_errors_at_switch = 0;
+
+void ESP_LINK_Init(void) {
+    rx_state = LINK_RX_IDLE;
+    tx_active = false;
+    frame_pending = false;
+    events_unacked = 0;
+    pending_baud_code = LINK_NO_BAUD_CHANGE;
+    current_baud_code = LINK_BAUD_115200;
+}
+
+static void link_put(uint8_t data) {
+    UART2_Write(data);
+    tx_crc = CRC16_Update(tx_crc, data);
+}
+
+static void link_begin_response(uint8_t cmd, uint16_t length) {
+    UART2_Write(LINK_SYNC);
+    tx_crc = CRC16_INIT;
+    link_put(cmd);
+    link_put((uint8_t)(length & 0xFF));
+    link_put((uint8_t)(length >> 8));
+    tx_stream_remaining = 0;
+    tx_active = true;
+}
+
+static void link_send_error(uint8_t cmd, uint8_t code) {
+    link_begin_response(cmd | LINK_ERROR_FLAG, 1);
+    link_put(code);
+}
+
+// Strömmar registerdata och avslutar ramen med CRC när allt har köats
+static void link_pump_tx(void) {
+    if (!tx_active) {
+        return;
+    }
+    while (tx_stream_remaining > 0 && UART2_TxFree() > 0) {
+        link_put(tx_snapshot[tx_stream_index]);
+        tx_stream_index++;
+        tx_stream_remaining--;
+    }
+    if (tx_stream_remaining == 0 && UART2_TxFree() >= 2) {
+        UART2_Write((uint8_t)(tx_crc & 0xFF)); // LSB först
+        UART2_Write((uint8_t)(tx_crc >> 8));
+        tx_active = false;
+    }
+}
+
+// Returnerar false om ramen ska hanteras om nästa varv (pumpen skrev under läsningen)
+static bool link_handle_frame(void) {
+    uint8_t response = rx_cmd | LINK_RESPONSE_FLAG;
+    uint8_t start;
+    uint16_t count;
+    regmap_copy_t copy;
+
+    switch (rx_cmd) {
+        case LINK_CMD_HELLO:
+            if (rx_len != 0) { link_send_error(rx_cmd, LINK_ERR_LENGTH); return true; }
+            link_begin_response(response, 5);
+            link_put(LINK_PROTOCOL_VERSION);
+            link_put(FW_VERSION_MAJOR);
+            link_put(FW_VERSION_MINOR);
+            link_put((uint8_t)(TOTAL_REGS - 1));
+            link_put(LINK_BAUD_MAX);
+            break;
+
+        case LINK_CMD_READ_BLOCK:
+            if (rx_len != 2) { link_send_error(rx_cmd, LINK_ERR_LENGTH); return true; }
+            start = rx_payload[0];
+            count = rx_payload[1] ? rx_payload[1] : 256;
+            if ((uint16_t)start + count > TOTAL_REGS) { link_send_error(rx_cmd, LINK_ERR_RANGE); return true; }
+            copy = REGMAP_SnapshotWait(&snapshot_wait, start, count, tx_snapshot);
+            if (copy == REGMAP_COPY_RETRY) {
+                return false;
+            }
+            if (copy == REGMAP_COPY_TIMEOUT) { link_send_error(rx_cmd, LINK_ERR_BUSY); return true; }
+            link_begin_response(response, 1 + count);
+            link_put(start);
+            tx_stream_index = 0;
+            tx_stream_remaining = count;
+            break;
+
+        case LINK_CMD_WRITE_BLOCK:
+            if (rx_len < 2) { link_send_error(rx_cmd, LINK_ERR_LENGTH); return true; }
+            start = rx_payload[0];
+            count = rx_len - 1;
+            if ((uint16_t)start + count > TOTAL_REGS) { link_send_error(rx_cmd, LINK_ERR_RANGE); return true; }
+            REGMAP_WriteBlock(start, &rx_payload[1], count);
+            link_begin_response(response, 2);
+            link_put(start);
+            link_put((uint8_t)count); // 0 = 256
+            break;
+
+        case LINK_CMD_READ_EVENTS: {
+            if (rx_len != 2) { link_send_error(rx_cmd, LINK_ERR_LENGTH); return true; }
+            if (rx_payload[0] > events_unacked) { link_send_error(rx_cmd, LINK_ERR_RANGE); return true; }
+            EVENTS_Drop(rx_payload[0]);
+            // Okvitterade händelser skickas om från början av FIFO:n
+            uint8_t n = EVENTS_Count();
+            uint8_t max = rx_payload[1] ? rx_payload[1] : LINK_MAX_EVENTS;
+            if (max > LINK_MAX_EVENTS) max = LINK_MAX_EVENTS;
+            if (n > max) n = max;
+            for (uint8_t i = 0; i < n; i++) {
+                event_t ev;
+                EVENTS_Peek(i, &ev);
+                uint8_t *dst = &tx_snapshot[i * EVENTS_WIRE_SIZE];
+                dst[0] = (uint8_t)(ev.tick_ms & 0xFF);
+                dst[1] = (uint8_t)(ev.tick_ms >> 8);
+                dst[2] = ev.reg;
+                dst[3] = ev.value;
+            }
+            events_unacked = n;
+            link_begin_response(response, 2 + (uint16_t)n * EVENTS_WIRE_SIZE);
+            link_put(registerMap[REG_EVENT_OVERFLOWS]);
+            link_put(n);
+            tx_stream_index = 0;
+            tx_stream_remaining = (uint16_t)n * EVENTS_WIRE_SIZE;
+            break;
+        }
+
+        case LINK_CMD_SET_BAUD:
+            if (rx_len != 1) { link_send_error(rx_cmd, LINK_ERR_LENGTH); return true; }
+            if (rx_payload[0] > LINK_BAUD_MAX) { link_send_error(rx_cmd, LINK_ERR_RANGE); return true; }
+            // Svaret skickas i nuvarande hastighet, bytet sker när det har lämnat UART:en
+            link_begin_response(response, 1);
+            link_put(rx_payload[0]);
+            pending_baud_code = rx_payload[0];
+            break;
+
+        default:
+            link_send_error(rx_cmd, LINK_ERR_UNKNOWN_CMD);
+            break;
+    }
+    return true;
+}
+
+static void link_receive(uint8_t rx) {
+    switch (rx_state) {
+        case LINK_RX_IDLE:
+            if (rx == LINK_SYNC) {
+                rx_crc = CRC16_INIT;
+                rx_state = LINK_RX_CMD;
+            }
+            else if (rx == 'R') rx_state = LINK_RX_LEGACY_READ_INDEX;
+            else if (rx == 'W') rx_state = LINK_RX_LEGACY_WRITE_INDEX;
+            break;
+
+        case LINK_RX_CMD:
+            rx_cmd = rx;
+            rx_crc = CRC16_Update(rx_crc, rx);
+            rx_state = LINK_RX_LEN_LO;
+            break;
+
+        case LINK_RX_LEN_LO:
+            rx_len = rx;
+            rx_crc = CRC16_Update(rx_crc, rx);
+            rx_state = LINK_RX_LEN_HI;
+            break;
+
+        case LINK_RX_LEN_HI:
+            rx_len |= (uint16_t)rx << 8;
+            rx_crc = CRC16_Update(rx_crc, rx);
+            rx_pos = 0;
+            if (rx_len > LINK_MAX_PAYLOAD) {
+                // Kan inte buffras, synka om på nästa SYNC
+                link_send_error(rx_cmd, LINK_ERR_LENGTH);
+                rx_state = LINK_RX_IDLE;
+            } else {
+                rx_state = (rx_len > 0) ? LINK_RX_PAYLOAD : LINK_RX_CRC_LO;
+            }
+            break;
+
+        case LINK_RX_PAYLOAD:
+            rx_payload[rx_pos++] = rx;
+            rx_crc = CRC16_Update(rx_crc, rx);
+            if (rx_pos >= rx_len) rx_state = LINK_RX_CRC_LO;
+            break;
+
+        case LINK_RX_CRC_LO:
+            rx_crc_lo = rx;
+            rx_state = LINK_RX_CRC_HI;
+            break;
+
+        case LINK_RX_CRC_HI:
+            if (rx_crc == (uint16_t)((rx << 8) | rx_crc_lo)) {
+                frame_pending = !link_handle_frame();
+            } else {
+                link_send_error(rx_cmd, LINK_ERR_CRC);
+            }
+            rx_state = LINK_RX_IDLE;
+            break;
+
+        // --- Gamla protokollet: 'R' <idx> -> värde, 'W' <idx> <val> -> 'K' ---
+        case LINK_RX_LEGACY_READ_INDEX:
+            UART2_Write(registerMap[rx]);
+            rx_state = LINK_RX_IDLE;
+            break;
+
+        case LINK_RX_LEGACY_WRITE_INDEX:
+            legacy_index = rx;
+            rx_state = LINK_RX_LEGACY_WRITE_VALUE;
+            break;
+
+        case LINK_RX_LEGACY_WRITE_VALUE:
+            registerMap[legacy_index] = rx;
+            UART2_Write('K');
+            rx_state = LINK_RX_IDLE;
+            break;
+    }
+}
+
+void ESP_LINK_Task(void) {
+    // 1. Fortsätt strömma ett påbörjat svar
+    link_pump_tx();
+
+    // 2. Genomför ett förhandlat baudbyte när svaret har lämnat UART:en
+    if (pending_baud_code != LINK_NO_BAUD_CHANGE) {
+        if (tx_active || !UART2_TxIdle()) {
+            return;
+        }
+        UART2_SetBaudRate(LINK_BAUD_RATES[pending_baud_code]);
+        current_baud_code = pending_baud_code;
+        pending_baud_code = LINK_NO_BAUD_CHANGE;
+        framing_errors_at_switch = UART2_FramingErrors();
+        LOG_1(LOG_LINK_BAUD, current_baud_code);
+    }
+
+    // 3. Fall tillbaka till standardhastighet om motparten inte följde med
+    if (current_baud_code != LINK_BAUD_115200
+        && (uint8_t)(UART2_FramingErrors() - framing_errors_at_switch) >= LINK_FALLBACK_FRAMING_ERRORS) {
+        UART2_SetBaudRate(UART2_DEFAULT_BAUD);
+        current_baud_code = LINK_BAUD_115200;
+        rx_state = LINK_RX_IDLE;
+        LOG_0(LOG_LINK_BAUD_FALLBACK);
+    }
+
+    // 4. En ram som väntade på en konsekvent läsning går före nya bytes
+    if (frame_pending) {
+        if (UART2_TxFree() < LINK_TX_RESERVE) {
+            return;
+        }
+        frame_pending = !link_handle_frame();
+        if (frame_pending) {
+            return;
+        }
+        link_pump_tx();
+    }
+
+    // 5. Tolka mottagna bytes så länge ett svar får plats.
+    // Ett svar i taget: nästa ram tolkas först när det förra är helt köat.
+    while (!tx_active && !frame_pending && pending_baud_code == LINK_NO_BAUD_CHANGE
+           && UART2_RxCount() > 0 && UART2_TxFree() >= LINK_TX_RESERVE) {
+        link_receive(UART2_Read());
+        link_pump_tx();
+    }
+}
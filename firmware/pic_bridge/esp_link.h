@@ -0,0 +1,59 @@
+#ifndef ESP_LINK_H
+#define ESP_LINK_H
+
+#include <stdint.h>
+
+// --- Ramat binärprotokoll PIC <-> XIAO/ESP32 (UART2) ---
+// Ram:  SYNC | CMD | LEN_LO | LEN_HI | PAYLOAD[LEN] | CRC_LO | CRC_HI
+// CRC:  Modbus CRC-16 (crc.c) över CMD, LEN och PAYLOAD.
+// Svar: Samma format med CMD | LINK_RESPONSE_FLAG. Fel: CMD | LINK_ERROR_FLAG och
+//       en byte felkod som payload.
+// Det gamla protokollet ('R' <idx> / 'W' <idx> <val>) accepteras fortfarande
+// så länge ramen inte börjar med LINK_SYNC.
+// Referensimplementation för ESP-sidan: esphome/components/pic_link/
+#define LINK_SYNC               0xA5
+#define LINK_PROTOCOL_VERSION   2
+
+#define LINK_CMD_HELLO          0x01 // -> version, FW major/minor, antal register, max baudkod
+#define LINK_CMD_READ_BLOCK     0x02 // start, antal (0 = 256) -> start, data[antal]
+#define LINK_CMD_WRITE_BLOCK    0x03 // start, data[N] -> start, N
+#define LINK_CMD_SET_BAUD       0x04 // baudkod -> baudkod (byter efter att svaret skickats)
+#define LINK_CMD_READ_EVENTS    0x05 // kvittens, max antal -> overflow, N, N x (tick LO, tick HI, reg, värde)
+                                     // Kvittensen tar bort så många av de händelser som skickades förra
+                                     // gången; okvitterade skickas om. Se events.h.
+
+#define LINK_RESPONSE_FLAG      0x80
+#define LINK_ERROR_FLAG         0x40
+
+#define LINK_ERR_CRC            0x01
+#define LINK_ERR_UNKNOWN_CMD    0x02
+#define LINK_ERR_RANGE          0x03
+#define LINK_ERR_LENGTH         0x04
+#define LINK_ERR_BUSY           0x05 // READ_BLOCK: pumpen skrev under hela tidsgränsen (regmap.h)
+
+// Baudkoder för LINK_CMD_SET_BAUD
+#define LINK_BAUD_115200        0
+#define LINK_BAUD_230400        1
+#define LINK_BAUD_460800        2
+#define LINK_BAUD_1000000       3
+#define LINK_BAUD_MAX           LINK_BAUD_1000000
+
+// Största payload: WRITE_BLOCK med start + hela registerMap
+#define LINK_MAX_PAYLOAD        (1 + 256)
+
+// Största antal händelser per READ_EVENTS-svar (ryms i tx_snapshot, TOTAL_REGS bytes, i esp_link.c)
+#define LINK_MAX_EVENTS         63
+
+/**
+ * @brief Återställer protokollets tillstånd. UART2 ska redan vara initierad.
+ */
+void ESP_LINK_Init(void);
+
+/**
+ * @brief Tolkar mottagna bytes, strömmar svar och hanterar baudbyte.
+ * Blockerar aldrig; svar skickas i den takt TX-ringbufferten har plats.
+ * Anropas från MODBUS_Task().
+ */
+void ESP_LINK_Task(void);
+
+#endif // ESP_LINK_H
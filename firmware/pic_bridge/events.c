@@ -0,0 +1,54 @@
+#include "events.h"
+#include "globals.h"
+#include "scheduler.h"
+#include "i2c.h"
+
+#define EVENTS_MASK (EVENTS_FIFO_SIZE - 1)
+
+// Samma mönster som UART2-ringbuffertarna: head skrivs av ISR:en, tail av huvudloopen.
+// En plats hålls tom för att skilja full från tom.
+static volatile event_t fifo[EVENTS_FIFO_SIZE];
+static volatile uint8_t head = 0;
+static volatile uint8_t tail = 0;
+
+void EVENTS_Init(void) {
+    head = 0;
+    tail = 0;
+    registerMap[REG_EVENT_FIFO_LEVEL] = 0;
+    registerMap[REG_EVENT_OVERFLOWS] = 0;
+}
+
+void EVENTS_Record(uint8_t reg, uint8_t value) {
+    uint8_t next = (uint8_t)((head + 1) & EVENTS_MASK);
+    if (next == tail) {
+        registerMap[REG_EVENT_OVERFLOWS]++; // ESP:n hann inte tömma, händelsen kastas
+        return;
+    }
+    fifo[head].tick_ms = SCHEDULER_Millis();
+    fifo[head].reg = reg;
+    fifo[head].value = value;
+    head = next;
+    registerMap[REG_EVENT_FIFO_LEVEL] = (uint8_t)((head - tail) & EVENTS_MASK);
+}
+
+uint8_t EVENTS_Count(void) {
+    return (uint8_t)((head - tail) & EVENTS_MASK);
+}
+
+void EVENTS_Peek(uint8_t offset, event_t *out) {
+    uint8_t idx = (uint8_t)((tail + offset) & EVENTS_MASK);
+    out->tick_ms = fifo[idx].tick_ms;
+    out->reg = fifo[idx].reg;
+    out->value = fifo[idx].value;
+}
+
+void EVENTS_Drop(uint8_t count) {
+    if (count > EVENTS_Count()) {
+        count = EVENTS_Count();
+    }
+    // Nivåregistret skrivs även av ISR:en, håll den ute under uppdateringen
+    I2C_Hold();
+    tail = (uint8_t)((tail + count) & EVENTS_MASK);
+    registerMap[REG_EVENT_FIFO_LEVEL] = (uint8_t)((head - tail) & EVENTS_MASK);
+    I2C_Release();
+}
@@ -0,0 +1,45 @@
+#ifndef EVENTS_H
+#define EVENTS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// --- Händelse-FIFO för pumpens I2C-skrivningar ---
+// Varje ändrad byte i registerMap (och varje kommando via 0xFE) loggas med
+// tidsstämpel. ESP:n tömmer FIFO:n i bulk med LINK_CMD_READ_EVENTS (esp_link.c).
+// Producent: I2C-ISR:en (hög prioritet). Konsument: huvudloopen.
+#define EVENTS_FIFO_SIZE 64 // Måste vara en tvåpotens
+
+typedef struct {
+    uint16_t tick_ms; // SCHEDULER_Millis() när byten skrevs
+    uint8_t reg;      // registerMap-index
+    uint8_t value;    // Nytt värde
+} event_t;
+
+// Storlek på en händelse i LINK_CMD_READ_EVENTS-svaret: tick LO, tick HI, reg, värde
+#define EVENTS_WIRE_SIZE 4
+
+void EVENTS_Init(void);
+
+/**
+ * @brief Lägger en händelse i FIFO:n. Anropas endast från I2C-ISR:en.
+ * Är FIFO:n full kastas händelsen och REG_EVENT_OVERFLOWS räknas upp.
+ */
+void EVENTS_Record(uint8_t reg, uint8_t value);
+
+/**
+ * @brief Antal händelser i FIFO:n (inklusive skickade men ej kvitterade).
+ */
+uint8_t EVENTS_Count(void);
+
+/**
+ * @brief Kopierar händelse nummer offset (0 = äldsta) utan att ta bort den.
+ */
+void EVENTS_Peek(uint8_t offset, event_t *out);
+
+/**
+ * @brief Tar bort de count äldsta händelserna (kvitterade av ESP:n).
+ */
+void EVENTS_Drop(uint8_t count);
+
+#endif // EVENTS_H
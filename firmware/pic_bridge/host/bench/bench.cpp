@@ -0,0 +1,829 @@
+// Benchmark av pic_bridge mot den simulerade hårdvaran (host/sim).
+//
+// Firmwaren bootas en gång; scenarierna körs sedan efter varandra mot samma
+// PIC. Värdtiden för varje anrop av I2C_Slave_ISR_Handler, MODBUS_Task och
+// SPOOFER_Process mäts via länkarens --wrap. Tiderna är värddatorns väggklocka
+// och inkluderar simulatorns SFR-åtkomster: jämför dem mellan två byggen, inte
+// mot PIC:ens cykler (de mäts på riktigt i REG_PERF_*, perf.c).
+//
+// Data-EEPROM:en innehåller en journalpost när PIC:en bootas (varmstart, nvm.c).
+// ADC-kanalerna följer digipottarna. pic_bridge_bench har spooferns standard
+// (öppen slinga) och kör alla scenarier utom spoofer_closed_loop, som bara finns i
+// pic_bridge_bench_closed_loop (SPOOFER_CLOSED_LOOP=1, se host/CMakeLists.txt).
+// Potten är nominell utom i spoofer_closed_loop.
+//
+// Kör:  pic_bridge_bench [--quick] [scenario ...]
+//       pic_bridge_bench_closed_loop [--quick]
+
+#include "peers.h"
+#include "sim.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+extern "C" {
+#include "crc.h"
+#include "esp_link.h"
+#include "globals.h"
+#include "modbus_rtu.h"
+#include "ntc_table.h"
+#include "nvm.h"
+#include "onewire.h"
+#include "regmap.h"
+#include "spoofer.h"
+
+bool __real_I2C_Slave_ISR_Handler(void);
+void __real_MODBUS_Task(void);
+void __real_SPOOFER_Process(void);
+}
+
+namespace {
+
+// Antal bytes i ThermiaIQ-blocket som pumpen loggar (reg 0-116)
+const size_t PUMP_BLOCK = 117;
+
+const uint32_t ESP_BAUD = 115200;
+const uint32_t RS485_BAUD = 9600;
+const uint8_t RS485_SLAVE_ID = 1;
+
+// --- Värdtid per anrop ---
+
+class Samples {
+ public:
+  void add(uint64_t ns) { this->ns_.push_back(ns); }
+  void clear() { this->ns_.clear(); }
+  size_t count() const { return this->ns_.size(); }
+
+  uint64_t total() const {
+    uint64_t sum = 0;
+    for (uint64_t v : this->ns_)
+      sum += v;
+    return sum;
+  }
+
+  void print(const char *name) const {
+    if (this->ns_.empty()) {
+      std::printf("  %-24s inga anrop\n", name);
+      return;
+    }
+    std::vector<uint64_t> sorted = this->ns_;
+    std::sort(sorted.begin(), sorted.end());
+    std::printf("  %-24s %8zu anrop  medel %6llu ns  p99 %7llu ns  max %8llu ns\n", name, sorted.size(),
+                static_cast<unsigned long long>(this->total() / sorted.size()),
+                static_cast<unsigned long long>(sorted[(sorted.size() * 99) / 100]),
+                static_cast<unsigned long long>(sorted.back()));
+  }
+
+ private:
+  std::vector<uint64_t> ns_;
+};
+
+Samples isr_samples;
+Samples modbus_samples;
+Samples spoofer_samples;
+
+uint64_t host_ns() {
+  return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+void clear_samples() {
+  isr_samples.clear();
+  modbus_samples.clear();
+  spoofer_samples.clear();
+}
+
+// --- Hjälpare ---
+
+sim::PumpMaster pump(I2C_SLAVE_ADDR);
+sim::EspPeer esp(ESP_BAUD);
+sim::ModbusMaster rs485(RS485_SLAVE_ID, RS485_BAUD);
+
+bool failed = false;
+
+void check(bool ok, const char *what) {
+  if (!ok) {
+    std::printf("  FEL: %s\n", what);
+    failed = true;
+  }
+}
+
+std::vector<uint8_t> pump_pattern(uint32_t k) {
+  std::vector<uint8_t> data(PUMP_BLOCK);
+  for (size_t i = 0; i < PUMP_BLOCK; i++)
+    data[i] = static_cast<uint8_t>(k * 7 + i);
+  return data;
+}
+
+// Alla bytes kommer från samma pump_pattern (ingen halv transaktion i kopian)
+bool pattern_consistent(const std::vector<uint8_t> &bytes) {
+  for (size_t i = 1; i < bytes.size(); i++) {
+    if (static_cast<uint8_t>(bytes[i] - i) != static_cast<uint8_t>(bytes[0]))
+      return false;
+  }
+  return true;
+}
+
+// Håller pumpen sysselsatt med nya skrivningar medan ett annat scenario körs
+uint32_t pump_round = 0;
+void keep_pump_busy() {
+  if (pump.idle())
+    pump.write(0, pump_pattern(pump_round++));
+}
+
+bool esp_request(uint8_t cmd, const std::vector<uint8_t> &payload, std::vector<uint8_t> *response) {
+  bool done = false;
+  esp.request(cmd, payload, [&](uint8_t rsp, const std::vector<uint8_t> &data) {
+    done = rsp == (cmd | LINK_RESPONSE_FLAG);
+    if (response != nullptr)
+      *response = data;
+  });
+  return sim::run_until([] { return esp.idle(); }, sim::ms(500)) && done;
+}
+
+double virtual_seconds(sim::Time start) { return static_cast<double>(sim::now() - start) / 1e9; }
+
+// --- Scenarier ---
+
+void scenario_pump_write_burst(uint32_t n) {
+  std::printf("== pump_write_burst: %u x Master Write av reg 0-116\n", n);
+  clear_samples();
+  sim::Time start = sim::now();
+  uint64_t before = pump.completed();
+  for (uint32_t k = 0; k < n; k++)
+    pump.write(0, pump_pattern(pump_round++));
+  check(sim::run_until([] { return pump.idle(); }, sim::ms(20) * n), "pumpen blev inte klar");
+
+  uint64_t transactions = pump.completed() - before;
+  isr_samples.print("I2C_Slave_ISR_Handler");
+  if (isr_samples.total() > 0) {
+    std::printf("  ISR-bunden takt %.0f transaktioner/s, bussen %.1f/s\n",
+                transactions * 1e9 / static_cast<double>(isr_samples.total()), transactions / virtual_seconds(start));
+  }
+  std::vector<uint8_t> expected = pump_pattern(pump_round - 1);
+  bool match = true;
+  for (size_t i = 0; i < PUMP_BLOCK; i++)
+    match = match && registerMap[i] == expected[i];
+  check(match, "registerMap matchar inte pumpens sista skrivning");
+  check((registerMapSeq & 0x01) == 0, "registerMapSeq udda efter STOP");
+}
+
+void scenario_pump_read_poll(uint32_t n) {
+  std::printf("== pump_read_poll: %u x Master Read av 16 bytes från reg 16\n", n);
+  clear_samples();
+  sim::Time start = sim::now();
+  uint32_t mismatches = 0;
+  for (uint32_t k = 0; k < n; k++) {
+    pump.read(16, 16, [&](const std::vector<uint8_t> &data) {
+      for (size_t i = 0; i < data.size(); i++) {
+        if (data[i] != registerMap[16 + i])
+          mismatches++;
+      }
+    });
+  }
+  check(sim::run_until([] { return pump.idle(); }, sim::ms(5) * n), "pumpen blev inte klar");
+
+  isr_samples.print("I2C_Slave_ISR_Handler");
+  if (isr_samples.total() > 0) {
+    std::printf("  ISR-bunden takt %.0f transaktioner/s, bussen %.1f/s\n",
+                n * 1e9 / static_cast<double>(isr_samples.total()), n / virtual_seconds(start));
+  }
+  check(mismatches == 0, "pumpen läste andra bytes än registerMap");
+}
+
+void scenario_modbus_under_pump(uint32_t n) {
+  std::printf("== modbus_under_pump: %u x FC03 reg 0-116 (9600 baud) medan pumpen skriver\n", n);
+  clear_samples();
+  sim::Time worst = 0;
+  uint32_t bad = 0, inconsistent = 0;
+  for (uint32_t k = 0; k < n; k++) {
+    bool ok = false;
+    std::vector<uint8_t> bytes;
+    rs485.read_holding(MODBUS_RTU_WORD_VIEW_BASE, PUMP_BLOCK - 1, [&](bool response_ok, const std::vector<uint8_t> &regs) {
+      ok = response_ok;
+      // Ordvyn: register j = map[j] << 8 | map[j + 1]
+      for (size_t j = 0; j + 1 < regs.size(); j += 2)
+        bytes.push_back(regs[j]);
+      if (!regs.empty())
+        bytes.push_back(regs.back());
+    });
+    bool done = sim::run_until(
+        [] {
+          keep_pump_busy();
+          return rs485.idle();
+        },
+        sim::ms(1000));
+    if (!done || !ok) {
+      bad++;
+      continue;
+    }
+    if (!pattern_consistent(bytes))
+      inconsistent++;
+    worst = std::max(worst, rs485.last_latency());
+  }
+  check(sim::run_until([] { return pump.idle(); }, sim::ms(50)), "pumpen blev inte klar");
+
+  modbus_samples.print("MODBUS_Task");
+  isr_samples.print("I2C_Slave_ISR_Handler");
+  std::printf("  svarstid förfrågan -> sista byten i svaret: max %.2f ms\n", worst / 1e6);
+  std::printf("  svar som blandar två pumpskrivningar: %u av %u\n", inconsistent, n - bad);
+  // Pumpen pausar bara mellan STOP och nästa START; läsaren ska hinna där inom
+  // REGMAP_SNAPSHOT_TIMEOUT_MS (regmap.h) i stället för att svara upptagen
+  check(bad == 0, "Modbus-svar saknas, har fel CRC eller är undantag (upptagen)");
+  check(inconsistent == 0, "Modbus-svar blandar två pumpskrivningar");
+}
+
+// Ordvyns register N och N+1 delar registerMap[N+1] (modbus_rtu.h)
+bool modbus_write(uint16_t start, const std::vector<uint16_t> &values) {
+  bool ok = false;
+  rs485.write_multiple(start, values, [&](bool response_ok, const std::vector<uint8_t> &) { ok = response_ok; });
+  return sim::run_until([] { return rs485.idle(); }, sim::ms(500)) && ok;
+}
+
+void scenario_modbus_word_view_writes(uint32_t n) {
+  std::printf("== modbus_word_view_writes: %u x FC16 över målregistren i ord- och bytevyn\n", n);
+  uint32_t corrupted = 0, accepted = 0, rejected = 0, wide_rejected = 0;
+  for (uint32_t k = 0; k < n; k++) {
+    int16_t outdoor = static_cast<int16_t>(-1000 + k * 37);
+    int16_t indoor = static_cast<int16_t>(2000 + k * 11);
+    auto targets = [] {
+      return std::vector<uint8_t>(&registerMap[REG_TARGET_OUTDOOR_TEMP_HI], &registerMap[REG_TARGET_INDOOR_TEMP_LO] + 1);
+    };
+    std::vector<uint8_t> before = targets();
+
+    // Fyra ord från registret före målen: undantag 02 och inga bytes ändrade
+    if (modbus_write(MODBUS_RTU_WORD_VIEW_BASE + REG_TARGET_OUTDOOR_TEMP_HI - 1, {0x1111, 0x2222, 0x3333, 0x4444}))
+      accepted++;
+    else if (rs485.last_exception() == MB_EX_ILLEGAL_ADDRESS)
+      rejected++;
+    if (targets() != before)
+      corrupted++;
+
+    // Ett värde över 0xFF i bytevyn: undantag 03 och inga bytes ändrade (inte heller de före)
+    if (!modbus_write(MODBUS_RTU_BYTE_VIEW_BASE + REG_TARGET_OUTDOOR_TEMP_HI, {0x11, 0x22, 0x133, 0x44}) &&
+        rs485.last_exception() == MB_EX_ILLEGAL_VALUE)
+      wide_rejected++;
+    if (targets() != before)
+      corrupted++;
+
+    // Samma mål som bytes i bytevyn, och ett ord (ett HI/LO-par) i ordvyn
+    bool ok = modbus_write(MODBUS_RTU_BYTE_VIEW_BASE + REG_TARGET_OUTDOOR_TEMP_HI,
+                           {static_cast<uint16_t>((outdoor >> 8) & 0xFF), static_cast<uint16_t>(outdoor & 0xFF),
+                            static_cast<uint16_t>((indoor >> 8) & 0xFF), static_cast<uint16_t>(indoor & 0xFF)});
+    check(ok, "FC16 i bytevyn avvisades");
+    ok = modbus_write(MODBUS_RTU_WORD_VIEW_BASE + REG_TARGET_INDOOR_TEMP_HI, {static_cast<uint16_t>(indoor + 1)});
+    check(ok, "FC16 med ett ord i ordvyn avvisades");
+    int actual_outdoor = static_cast<int16_t>((registerMap[REG_TARGET_OUTDOOR_TEMP_HI] << 8) | registerMap[REG_TARGET_OUTDOOR_TEMP_LO]);
+    int actual_indoor = static_cast<int16_t>((registerMap[REG_TARGET_INDOOR_TEMP_HI] << 8) | registerMap[REG_TARGET_INDOOR_TEMP_LO]);
+    if (actual_outdoor != outdoor || actual_indoor != indoor + 1)
+      corrupted++;
+  }
+
+  std::printf("  flerordsskrivningar i ordvyn: %u avvisade, %u godtagna; för breda bytevärden: %u avvisade; "
+              "%u gånger ändrades fel bytes\n",
+              rejected, accepted, wide_rejected, corrupted);
+  check(rejected == n, "FC16 med flera ord i ordvyn gav inte undantag 02");
+  check(wide_rejected == n, "FC16 med värde över 0xFF i bytevyn gav inte undantag 03");
+  check(corrupted == 0, "FC16 skrev över grannregister");
+}
+
+void scenario_esp_snapshot_under_pump(uint32_t n) {
+  std::printf("== esp_snapshot_under_pump: %u x READ_BLOCK 0-255 (115200 baud) medan pumpen skriver\n", n);
+  clear_samples();
+  sim::Time worst = 0;
+  uint32_t bad = 0, inconsistent = 0;
+  for (uint32_t k = 0; k < n; k++) {
+    bool ok = false;
+    std::vector<uint8_t> payload;
+    esp.request(LINK_CMD_READ_BLOCK, {0, 0}, [&](uint8_t rsp, const std::vector<uint8_t> &data) {
+      ok = rsp == (LINK_CMD_READ_BLOCK | LINK_RESPONSE_FLAG) && data.size() == 1 + TOTAL_REGS;
+      payload = data;
+    });
+    bool done = sim::run_until(
+        [] {
+          keep_pump_busy();
+          return esp.idle();
+        },
+        sim::ms(200));
+    if (!done || !ok) {
+      bad++;
+      continue;
+    }
+    if (!pattern_consistent(std::vector<uint8_t>(payload.begin() + 1, payload.begin() + 1 + PUMP_BLOCK)))
+      inconsistent++;
+    worst = std::max(worst, esp.last_latency());
+  }
+  check(sim::run_until([] { return pump.idle(); }, sim::ms(50)), "pumpen blev inte klar");
+
+  modbus_samples.print("MODBUS_Task");
+  isr_samples.print("I2C_Slave_ISR_Handler");
+  std::printf("  svarstid förfrågan -> sista byten i svaret: max %.2f ms\n", worst / 1e6);
+  std::printf("  svar som blandar två pumpskrivningar: %u av %u\n", inconsistent, n - bad);
+  check(bad == 0, "READ_BLOCK-svar saknas, har fel CRC eller är LINK_ERR_BUSY");
+  check(inconsistent == 0, "READ_BLOCK-svar blandar två pumpskrivningar");
+}
+
+// --- Digipottarna och ADC-kanalerna (spoofer.h, adc.c) ---
+
+// ADPCH i adc.c
+const uint8_t ADC_CHANNEL_OUTDOOR = 0b000001;
+const uint8_t ADC_CHANNEL_INDOOR = 0b001101;
+
+const double ADC_R_FIX_OHM = 10000.0;  // R_FIX_OHM_100X i adc.c
+
+struct PotModel {
+  double r_ab_ohm;
+  double r_wiper_ohm;
+};
+
+// Potten som wiper-tabellen bygger på (SPOOF_POT_*_100X)
+const PotModel POT_NOMINAL = {SPOOF_POT_R_AB_100X / 100.0, SPOOF_POT_R_WIPER_100X / 100.0};
+// En pott som avviker från den nominella (MCP4251: R_AB +-20 %), så tabellen ensam missar målet
+const PotModel POT_DEVIATING = {11500.0, 100.0};
+
+// Potten i simuleringen; spoofer_closed_loop byter till POT_DEVIATING
+PotModel sim_pot = POT_NOMINAL;
+
+// Samma delare som tools/gen_ntc_table.py räknar med: kod / 1024 = R_FIX / (R_FIX + R), 14 bit
+uint16_t pot_node_adc(int pot) {
+  double r = sim_pot.r_wiper_ohm + sim_pot.r_ab_ohm * sim::digipot().wiper[pot] / 256.0;
+  return static_cast<uint16_t>(std::min(16383.0, 16384.0 * ADC_R_FIX_OHM / (ADC_R_FIX_OHM + r) + 0.5));
+}
+
+// Temperaturen pumpen ser med den nominella potten och vald kurva, som wiper_temp_100x i spoofer.c
+int nominal_wiper_temp(uint8_t wiper) {
+  return ResistanceToTemp_100x(SPOOF_POT_R_WIPER_100X + (SPOOF_POT_R_AB_100X * wiper) / 256);
+}
+
+// Största temperatursteget till en granne: närmare än så kan wipern inte garantera att träffa
+int wiper_step(uint8_t wiper) {
+  int step = 0;
+  if (wiper > 0)
+    step = nominal_wiper_temp(wiper - 1) - nominal_wiper_temp(wiper);
+  if (wiper < 255)
+    step = std::max(step, nominal_wiper_temp(wiper) - nominal_wiper_temp(wiper + 1));
+  return step;
+}
+
+int16_t reg_word(uint8_t hi_reg) { return static_cast<int16_t>((registerMap[hi_reg] << 8) | registerMap[hi_reg + 1]); }
+
+// Spoofing av och på nollställer PI-trimmen (loop_reset i spoofer.c)
+void spoofer_reset_trim() {
+  check(esp_request(LINK_CMD_WRITE_BLOCK, {REG_SPOOFING_ENABLED, 0}, nullptr), "WRITE_BLOCK besvarades inte");
+  sim::run_for(sim::ms(2 * SPOOFER_TASK_PERIOD_MS));
+}
+
+void scenario_esp_dump_throughput(uint32_t n) {
+  std::printf("== esp_dump_throughput: %u x READ_BLOCK 0-255 (%u baud), pumpen tyst\n", n, ESP_BAUD);
+  clear_samples();
+  // SYNC, CMD, LEN_LO, LEN_HI, start, 256 bytes, CRC_LO, CRC_HI
+  const size_t FRAME_BYTES = 4 + 1 + TOTAL_REGS + 2;
+  uint64_t total_ns = 0;
+  uint32_t bad = 0;
+  for (uint32_t k = 0; k < n; k++) {
+    sim::Time start = sim::now();
+    std::vector<uint8_t> payload;
+    if (!esp_request(LINK_CMD_READ_BLOCK, {0, 0}, &payload) || payload.size() != 1 + TOTAL_REGS) {
+      bad++;
+      continue;
+    }
+    // Förfrågan (8 bytes) går på samma hastighet och räknas bort
+    total_ns += sim::now() - start - 8 * sim::uart_byte_time(ESP_BAUD);
+  }
+
+  double line_rate = ESP_BAUD / 10.0;
+  double rate = (n > bad && total_ns > 0) ? FRAME_BYTES * (n - bad) * 1e9 / static_cast<double>(total_ns) : 0.0;
+  std::printf("  %zu bytes per svar: %.0f bytes/s, %.1f %% av linjehastigheten (%.0f bytes/s)\n", FRAME_BYTES, rate,
+              100.0 * rate / line_rate, line_rate);
+  check(bad == 0, "READ_BLOCK-svar saknas eller har fel CRC");
+  // TX-ringen rymmer 255 bytes (uart2.h): resten strömmas utan att linjen står still
+  check(rate >= 0.95 * line_rate, "dumpen går långsammare än 95 % av linjehastigheten");
+}
+
+// Målen och på/av-registret skrivs i ett block (registers.schema håller dem i följd)
+static_assert(REG_TARGET_INDOOR_TEMP_HI == REG_TARGET_OUTDOOR_TEMP_HI + 2 &&
+                  REG_SPOOFING_ENABLED == REG_TARGET_OUTDOOR_TEMP_HI + 4,
+              "spoofer-registren ligger inte i följd");
+
+void scenario_spoofer_targets(uint32_t n) {
+  std::printf("== spoofer_targets: %u målbyten via WRITE_BLOCK REG_TARGET_OUTDOOR_TEMP_HI..REG_SPOOFING_ENABLED\n", n);
+  clear_samples();
+  spoofer_reset_trim();
+  uint32_t writes_before = sim::digipot().writes[0] + sim::digipot().writes[1];
+  int worst_error = 0, worst_excess = INT32_MIN;
+  for (uint32_t k = 0; k < n; k++) {
+    int16_t outdoor = static_cast<int16_t>(-2000 + (k * 337) % 4000);  // -20.00 .. +19.99 °C
+    int16_t indoor = static_cast<int16_t>(1500 + (k * 53) % 1000);     // 15.00 .. 24.99 °C
+    std::vector<uint8_t> block = {REG_TARGET_OUTDOOR_TEMP_HI,
+                                  static_cast<uint8_t>(outdoor >> 8),
+                                  static_cast<uint8_t>(outdoor & 0xFF),
+                                  static_cast<uint8_t>(indoor >> 8),
+                                  static_cast<uint8_t>(indoor & 0xFF),
+                                  1};
+    check(esp_request(LINK_CMD_WRITE_BLOCK, block, nullptr), "WRITE_BLOCK besvarades inte");
+    // Första gången byggs wiper-tabellen upp över flera varv
+    sim::run_for(k == 0 ? sim::ms(500) : sim::ms(3 * SPOOFER_TASK_PERIOD_MS));
+
+    // Potten är nominell och målen byts snabbare än reglerperioden, så PI-trimmen står
+    // kvar på 0 och felet är wiper-upplösningen vid målet
+    int error = std::abs(reg_word(REG_SPOOF_ACTUAL_OUTDOOR_HI) - outdoor);
+    worst_error = std::max(worst_error, error);
+    worst_excess = std::max(worst_excess, error - wiper_step(sim::digipot().wiper[1]));
+  }
+
+  spoofer_samples.print("SPOOFER_Process");
+  uint32_t writes = sim::digipot().writes[0] + sim::digipot().writes[1] - writes_before;
+  std::printf("  %u wiper-skrivningar över SPI2, största fel ute %.2f °C (%+.2f °C mot ett wiper-steg)\n", writes,
+              worst_error / 100.0, worst_excess / 100.0);
+  check(writes > 0, "inga wiper-skrivningar");
+  check(worst_excess <= 0, "felet ute är större än ett wiper-steg");
+}
+
+// Temperaturen pumpen ser från den simulerade potten (Ohm * 100 som i spoofer.c)
+int pot_seen_temp(int pot) {
+  double r = sim_pot.r_wiper_ohm + sim_pot.r_ab_ohm * sim::digipot().wiper[pot] / 256.0;
+  return ResistanceToTemp_100x(static_cast<int32_t>(r * 100.0));
+}
+
+void scenario_spoofer_wiper_accuracy(uint32_t n) {
+  std::printf("== spoofer_wiper_accuracy: %u mål per kurva över pottens område, nominell pott, öppen slinga\n", n);
+  uint8_t curve_before = registerMap[REG_NTC_CURVE_SELECT];
+  spoofer_reset_trim();
+  struct Curve {
+    const char *name;
+    uint8_t select;
+  };
+  for (const Curve &c : {Curve{"150 Ohm", 1}, Curve{"22 kOhm", 0}}) {
+    check(esp_request(LINK_CMD_WRITE_BLOCK, {REG_NTC_CURVE_SELECT, c.select}, nullptr), "WRITE_BLOCK besvarades inte");
+    // Pottens område med kurvan: högsta wiper är kallast
+    int coldest = nominal_wiper_temp(255), warmest = nominal_wiper_temp(0);
+    int worst = 0, worst_excess = INT32_MIN;
+    for (uint32_t k = 0; k < n; k++) {
+      int16_t outdoor = static_cast<int16_t>(coldest + (static_cast<int64_t>(warmest - coldest) * k) / std::max<uint32_t>(1, n - 1));
+      int16_t indoor = static_cast<int16_t>(warmest - (outdoor - coldest));
+      std::vector<uint8_t> block = {REG_TARGET_OUTDOOR_TEMP_HI,          static_cast<uint8_t>(outdoor >> 8),
+                                    static_cast<uint8_t>(outdoor & 0xFF), static_cast<uint8_t>(indoor >> 8),
+                                    static_cast<uint8_t>(indoor & 0xFF),  1};
+      check(esp_request(LINK_CMD_WRITE_BLOCK, block, nullptr), "WRITE_BLOCK besvarades inte");
+      // Första varvet byggs wiper-tabellen för kurvan. Målen byts sedan snabbare än
+      // SPOOFER_PI_PERIOD_MS, så regleringen tar aldrig ett steg: slingan är öppen.
+      sim::run_for(k == 0 ? sim::ms(500) : sim::ms(3 * SPOOFER_TASK_PERIOD_MS));
+
+      for (int pot : {1, 0}) {
+        int residual = std::abs(pot_seen_temp(pot) - (pot == 1 ? outdoor : indoor));
+        worst = std::max(worst, residual);
+        worst_excess = std::max(worst_excess, residual - wiper_step(sim::digipot().wiper[pot]));
+      }
+    }
+    std::printf("  %-8s %.2f .. %.2f °C: största fel %.2f °C (%+.2f °C mot ett wiper-steg)\n", c.name, coldest / 100.0,
+                warmest / 100.0, worst / 100.0, worst_excess / 100.0);
+    check(worst_excess <= 0, "pumpen ser ett fel större än ett wiper-steg");
+  }
+  check(esp_request(LINK_CMD_WRITE_BLOCK, {REG_NTC_CURVE_SELECT, curve_before}, nullptr), "WRITE_BLOCK besvarades inte");
+  sim::run_for(sim::ms(500));
+}
+
+// --- NTC-tabellerna (ntc_table.c) mot den gamla beräkningen ---
+
+// Som calculate_ntc_resistance() i adc.c före tabellerna (och tools/gen_ntc_table.py)
+const int32_t NTC_R_FIX_100X = 1000000L;
+const int32_t NTC_RESISTANCE_MAX_100X = 5000000L;
+
+int32_t ntc_code_resistance_100x(uint16_t code) {
+  if (code == 0)
+    return NTC_RESISTANCE_MAX_100X;
+  return std::min((NTC_R_FIX_100X * 1024) / code - NTC_R_FIX_100X, NTC_RESISTANCE_MAX_100X);
+}
+
+void scenario_ntc_table(uint32_t n) {
+  std::printf("== ntc_table: alla %u koder per kurva mot ResistanceToTemp_100x, tid per sampel över %u varv\n",
+              NTC_TABLE_SIZE, n);
+  uint8_t curve_before = registerMap[REG_NTC_CURVE_SELECT];
+  struct Curve {
+    const char *name;
+    uint8_t select;
+    const int16_t *table;
+  };
+  for (const Curve &c : {Curve{"150 Ohm", 1, NTC_TABLE_150OHM}, Curve{"22 kOhm", 0, NTC_TABLE_22KOHM}}) {
+    // Firmwaren står still medan bänken kör, så kurvvalet kan lånas utan att spoofern märker det
+    registerMap[REG_NTC_CURVE_SELECT] = c.select;
+    int worst = 0;
+    for (uint16_t code = 0; code < NTC_TABLE_SIZE; code++)
+      worst = std::max(worst, std::abs(c.table[code] - ResistanceToTemp_100x(ntc_code_resistance_100x(code))));
+
+    volatile int32_t sink = 0;
+    uint64_t start = host_ns();
+    for (uint32_t k = 0; k < n; k++) {
+      for (uint16_t code = 0; code < NTC_TABLE_SIZE; code++)
+        sink = sink + ResistanceToTemp_100x(ntc_code_resistance_100x(code));
+    }
+    uint64_t old_ns = host_ns() - start;
+    start = host_ns();
+    for (uint32_t k = 0; k < n; k++) {
+      for (uint16_t code = 0; code < NTC_TABLE_SIZE; code++)
+        sink = sink + c.table[code];
+    }
+    uint64_t new_ns = host_ns() - start;
+
+    double samples = static_cast<double>(n) * NTC_TABLE_SIZE;
+    std::printf("  %-8s största avvikelse %d (°C * 100); per sampel: division + sökning %.1f ns, tabell %.2f ns\n",
+                c.name, worst, old_ns / samples, new_ns / samples);
+    check(worst == 0, "NTC-tabellen avviker från ResistanceToTemp_100x");
+  }
+  registerMap[REG_NTC_CURVE_SELECT] = curve_before;
+}
+
+// --- Journalen i data-EEPROM:en (nvm.h) ---
+
+struct NvmRecord {
+  bool valid;
+  uint16_t seq;
+  uint8_t slot;
+  uint8_t data[NVM_DATA_LEN];
+};
+
+// Samma ordning som persisted_regs i nvm.c
+const uint8_t NVM_REGS[NVM_DATA_LEN] = {REG_TARGET_OUTDOOR_TEMP_HI, REG_TARGET_OUTDOOR_TEMP_LO,
+                                        REG_TARGET_INDOOR_TEMP_HI,  REG_TARGET_INDOOR_TEMP_LO,
+                                        REG_SPOOFING_ENABLED,       REG_RELAY_CONTROL,
+                                        REG_I2C_ENABLE_CONTROL};
+
+void nvm_put_record(uint8_t slot, uint16_t seq, const uint8_t *data) {
+  uint8_t *rec = sim::eeprom() + slot * NVM_SLOT_SIZE;
+  rec[0] = static_cast<uint8_t>(seq & 0xFF);
+  rec[1] = static_cast<uint8_t>(seq >> 8);
+  std::memcpy(rec + 2, data, NVM_DATA_LEN);
+  uint16_t crc = CRC16_Compute(rec, NVM_RECORD_LEN - 2);
+  rec[NVM_RECORD_LEN - 2] = static_cast<uint8_t>(crc & 0xFF);
+  rec[NVM_RECORD_LEN - 1] = static_cast<uint8_t>(crc >> 8);
+}
+
+NvmRecord nvm_newest_record() {
+  NvmRecord newest = {};
+  for (uint8_t slot = 0; slot < NVM_SLOTS; slot++) {
+    const uint8_t *rec = sim::eeprom() + slot * NVM_SLOT_SIZE;
+    uint16_t crc = CRC16_Compute(rec, NVM_RECORD_LEN - 2);
+    if (rec[NVM_RECORD_LEN - 2] != (crc & 0xFF) || rec[NVM_RECORD_LEN - 1] != (crc >> 8))
+      continue;
+    uint16_t seq = static_cast<uint16_t>(rec[0] | (rec[1] << 8));
+    if (newest.valid && static_cast<int16_t>(seq - newest.seq) <= 0)
+      continue;
+    newest.valid = true;
+    newest.seq = seq;
+    newest.slot = slot;
+    std::memcpy(newest.data, rec + 2, NVM_DATA_LEN);
+  }
+  return newest;
+}
+
+// Posten som ligger i EEPROM:en vid start: -5.00 °C ute, 21.00 °C inne, spoofing på, EVU-relä, I2C på
+const uint16_t WARM_SEQ = 0xFFFF;  // Nästa post slår runt till 0
+const uint8_t WARM_SLOT = NVM_SLOTS - 1;
+const uint8_t WARM_DATA[NVM_DATA_LEN] = {0xFE, 0x0C, 0x08, 0x34, 1, 0x01, 1};
+
+// Vad PIC:en hade återställt innan ESP:n hunnit säga något (setup)
+bool warm_registers_ok = false;
+bool warm_outputs_ok = false;
+
+void scenario_nvm_journal(uint32_t n) {
+  std::printf("== nvm_journal: varmstart och %u journalförda målbyten (ramp i 3 steg var)\n", n);
+  std::printf("  varmstart: registren %s, reläer och wipers %s innan ESP:n anslöt\n",
+              warm_registers_ok ? "återställda" : "INTE återställda", warm_outputs_ok ? "satta" : "INTE satta");
+  check(warm_registers_ok, "styrregistren återställdes inte ur EEPROM:en");
+  check(warm_outputs_ok, "reläer/wipers följde inte de återställda registren");
+
+  uint32_t writes_before = sim::eeprom_writes();
+  NvmRecord previous = nvm_newest_record();
+  sim::Time worst = 0;
+  uint32_t records = 0;
+  for (uint32_t k = 0; k < n; k++) {
+    // En ramp från XIAO: bara slutvärdet ska journalföras
+    int16_t outdoor = 0;
+    for (int step = 0; step < 3; step++) {
+      outdoor = static_cast<int16_t>(-1000 + k * 50 + step * 10);
+      std::vector<uint8_t> block = {REG_TARGET_OUTDOOR_TEMP_HI, static_cast<uint8_t>(outdoor >> 8),
+                                    static_cast<uint8_t>(outdoor & 0xFF)};
+      check(esp_request(LINK_CMD_WRITE_BLOCK, block, nullptr), "WRITE_BLOCK besvarades inte");
+      sim::run_for(sim::ms(100));
+    }
+    sim::Time start = sim::now();
+    NvmRecord newest = {};
+    bool done = sim::run_until(
+        [&] {
+          newest = nvm_newest_record();
+          return newest.valid && newest.seq != previous.seq;
+        },
+        sim::ms(NVM_SETTLE_MS + 1000));
+    if (!done) {
+      check(false, "ändringen journalfördes inte");
+      break;
+    }
+    worst = std::max(worst, sim::now() - start);
+    records++;
+    check(newest.seq == static_cast<uint16_t>(previous.seq + 1), "löpnumret ökade inte med ett");
+    check(newest.slot == (previous.slot + 1) % NVM_SLOTS, "posten hamnade inte på nästa plats");
+    check(newest.data[0] == static_cast<uint8_t>(outdoor >> 8) && newest.data[1] == static_cast<uint8_t>(outdoor & 0xFF),
+          "posten innehåller inte rampens slutvärde");
+    previous = newest;
+  }
+  sim::run_for(sim::ms(2 * NVM_TASK_PERIOD_MS));
+
+  uint32_t writes = sim::eeprom_writes() - writes_before;
+  std::printf("  %u poster, %.1f byteskrivningar per post, tid efter sista steget till giltig post max %.2f s\n", records,
+              records ? static_cast<double>(writes) / records : 0.0, worst / 1e9);
+  std::printf("  REG_NVM_STATUS 0x%02X, nyaste post %u på plats %u\n", registerMap[REG_NVM_STATUS], previous.seq,
+              previous.slot);
+  check(records == 0 || writes == records * NVM_RECORD_LEN, "fler EEPROM-skrivningar än posterna kräver");
+  check(!(registerMap[REG_NVM_STATUS] & (NVM_STATUS_PENDING | NVM_STATUS_WRITE_ERROR)),
+        "REG_NVM_STATUS visar väntande ändring eller skrivfel");
+}
+
+// --- 1-Wire: en kortsluten buss får inte ge givare ---
+
+// En kortsluten lina läser varje bit som 0 och bit/komplement som "konflikt". Tas
+// den för en presence-puls söker PIC:en igenom ROM 0, 0x80.. (CRC-fel på nästan alla).
+void scenario_onewire_shorted_bus(uint32_t n) {
+  // Första cykeln hinner börja innan kortslutningen: den räknas inte
+  std::printf("== onewire_shorted_bus: %u mätcykler med linan kortsluten mot jord\n", n);
+  sim::onewire_short(true);
+  sim::run_for(sim::ms(ONEWIRE_TASK_PERIOD_MS));
+  uint8_t crc_before = registerMap[REG_DS18B20_CRC_ERRORS];
+  uint32_t fake = 0;
+  for (uint32_t k = 0; k < n; k++) {
+    sim::run_for(sim::ms(ONEWIRE_TASK_PERIOD_MS));
+    fake = std::max<uint32_t>(fake, registerMap[REG_DS18B20_COUNT]);
+  }
+  uint8_t crc_errors = static_cast<uint8_t>(registerMap[REG_DS18B20_CRC_ERRORS] - crc_before);
+  sim::onewire_short(false);
+  std::printf("  REG_DS18B20_COUNT max %u, %u nya ROM-CRC-fel\n", fake, crc_errors);
+  check(fake == 0, "kortsluten buss registrerades som givare");
+  check(crc_errors == 0, "kortsluten buss söktes igenom som om givare svarade");
+}
+
+// --- Sluten spoofing: ADC-kanalerna mäter digipottarnas nod (spoofer.h) ---
+
+void scenario_spoofer_closed_loop(uint32_t n) {
+  std::printf("== spoofer_closed_loop: %u målbyten, PI mot ADC (potten %.0f Ohm i stället för %.0f Ohm)\n", n,
+              POT_DEVIATING.r_ab_ohm, POT_NOMINAL.r_ab_ohm);
+  clear_samples();
+  sim_pot = POT_DEVIATING;
+  const sim::Time HOLD = sim::ms(20000);
+  uint32_t unsettled = 0;
+  uint64_t settle_sum = 0;
+  uint16_t settle_max = 0;
+  int error_max = 0;
+  for (uint32_t k = 0; k < n; k++) {
+    int16_t outdoor = static_cast<int16_t>(-1500 + (k * 733) % 3000);  // -15.00 .. +14.99 °C
+    int16_t indoor = static_cast<int16_t>(1800 + (k * 97) % 600);      // 18.00 .. 23.99 °C
+    std::vector<uint8_t> block = {REG_TARGET_OUTDOOR_TEMP_HI,          static_cast<uint8_t>(outdoor >> 8),
+                                  static_cast<uint8_t>(outdoor & 0xFF), static_cast<uint8_t>(indoor >> 8),
+                                  static_cast<uint8_t>(indoor & 0xFF),  1};
+    check(esp_request(LINK_CMD_WRITE_BLOCK, block, nullptr), "WRITE_BLOCK besvarades inte");
+    sim::run_for(HOLD);
+
+    // Registret räknar tills felet är inom marginalen: nära HOLD = svängde aldrig in
+    for (uint8_t reg : {REG_SPOOF_SETTLE_OUTDOOR_MS_HI, REG_SPOOF_SETTLE_INDOOR_MS_HI}) {
+      uint16_t settle = static_cast<uint16_t>(reg_word(reg));
+      if (settle + 2 * SPOOFER_PI_PERIOD_MS >= static_cast<int>(HOLD / sim::ms(1))) {
+        unsettled++;
+        continue;
+      }
+      settle_sum += settle;
+      settle_max = std::max(settle_max, settle);
+    }
+    error_max = std::max({error_max, std::abs(reg_word(REG_SPOOF_ERROR_OUTDOOR_HI)),
+                          std::abs(reg_word(REG_SPOOF_ERROR_INDOOR_HI))});
+  }
+
+  spoofer_samples.print("SPOOFER_Process");
+  uint32_t settled = 2 * n - unsettled;
+  std::printf("  insvängning medel %.1f s, max %.1f s; kvarvarande fel max %.2f °C; %u av %u ej insvängda\n",
+              settled ? settle_sum / 1000.0 / settled : 0.0, settle_max / 1000.0, error_max / 100.0, unsettled, 2 * n);
+  check(unsettled == 0, "regleringen svängde inte in");
+  sim_pot = POT_NOMINAL;
+}
+
+struct Scenario {
+  const char *name;
+  void (*run)(uint32_t n);
+  uint32_t iterations;
+  bool closed_loop = false;
+};
+
+const Scenario SCENARIOS[] = {
+    {"pump_write_burst", scenario_pump_write_burst, 500},
+    {"pump_read_poll", scenario_pump_read_poll, 2000},
+    {"modbus_under_pump", scenario_modbus_under_pump, 30},
+    {"modbus_word_view_writes", scenario_modbus_word_view_writes, 20},
+    {"esp_snapshot_under_pump", scenario_esp_snapshot_under_pump, 100},
+    {"esp_dump_throughput", scenario_esp_dump_throughput, 50},
+    {"spoofer_targets", scenario_spoofer_targets, 100},
+    {"spoofer_wiper_accuracy", scenario_spoofer_wiper_accuracy, 100},
+    {"ntc_table", scenario_ntc_table, 200},
+    {"nvm_journal", scenario_nvm_journal, 20},
+    {"onewire_shorted_bus", scenario_onewire_shorted_bus, 10},
+    {"spoofer_closed_loop", scenario_spoofer_closed_loop, 10, true},
+};
+
+// Scenarierna som hör till bygget: den slutna slingan bara med SPOOFER_CLOSED_LOOP
+bool in_build(const Scenario &s) { return s.closed_loop == (SPOOFER_CLOSED_LOOP != 0); }
+
+// Startar PIC:en med en journalpost i EEPROM:en och gör det ESP:n gör vid uppstart:
+// HELLO och slå på I2C-slaven
+void setup() {
+  sim::uart_attach(1, &rs485);
+  sim::uart_attach(2, &esp);
+  sim::adc_source(ADC_CHANNEL_OUTDOOR, [] { return pot_node_adc(1); });  // Pot 1: ute
+  sim::adc_source(ADC_CHANNEL_INDOOR, [] { return pot_node_adc(0); });   // Pot 0: inne
+  nvm_put_record(WARM_SLOT, WARM_SEQ, WARM_DATA);
+  sim::boot();
+
+  warm_registers_ok = (registerMap[REG_NVM_STATUS] & NVM_STATUS_RESTORED) != 0;
+  for (size_t i = 0; i < NVM_DATA_LEN; i++)
+    warm_registers_ok = warm_registers_ok && registerMap[NVM_REGS[i]] == WARM_DATA[i];
+  // EVU-reläet på RC3, båda wipers flyttade från 50 %
+  warm_outputs_ok = (sim::lat_c() & 0x08) != 0 && sim::digipot().wiper[0] != 128 && sim::digipot().wiper[1] != 128;
+  sim::run_for(sim::ms(5));
+
+  std::vector<uint8_t> hello;
+  check(esp_request(LINK_CMD_HELLO, {}, &hello) && !hello.empty() && hello[0] == LINK_PROTOCOL_VERSION,
+        "HELLO besvarades inte");
+  check(esp_request(LINK_CMD_WRITE_BLOCK, {REG_I2C_ENABLE_CONTROL, 1}, nullptr), "I2C kunde inte slås på");
+}
+
+int usage() {
+  std::fprintf(stderr, "Användning: %s [--quick] [scenario ...]\n",
+               SPOOFER_CLOSED_LOOP ? "pic_bridge_bench_closed_loop" : "pic_bridge_bench");
+  for (const Scenario &s : SCENARIOS)
+    if (in_build(s))
+      std::fprintf(stderr, "  %s\n", s.name);
+  return 2;
+}
+
+}  // namespace
+
+extern "C" {
+
+bool __wrap_I2C_Slave_ISR_Handler(void) {
+  uint64_t start = host_ns();
+  bool handled = __real_I2C_Slave_ISR_Handler();
+  if (handled)
+    isr_samples.add(host_ns() - start);
+  return handled;
+}
+
+void __wrap_MODBUS_Task(void) {
+  uint64_t start = host_ns();
+  __real_MODBUS_Task();
+  modbus_samples.add(host_ns() - start);
+}
+
+void __wrap_SPOOFER_Process(void) {
+  uint64_t start = host_ns();
+  __real_SPOOFER_Process();
+  spoofer_samples.add(host_ns() - start);
+}
+
+}  // extern "C"
+
+int main(int argc, char **argv) {
+  bool quick = false;
+  std::vector<std::string> selected;
+  for (int i = 1; i < argc; i++) {
+    if (std::strcmp(argv[i], "--quick") == 0) {
+      quick = true;
+    } else if (argv[i][0] == '-') {
+      return usage();
+    } else {
+      selected.emplace_back(argv[i]);
+    }
+  }
+  for (const std::string &name : selected) {
+    bool known = false;
+    for (const Scenario &s : SCENARIOS)
+      known = known || (in_build(s) && name == s.name);
+    if (!known)
+      return usage();
+  }
+
+  setup();
+  for (const Scenario &s : SCENARIOS) {
+    if (!in_build(s))
+      continue;
+    if (!selected.empty() && std::find(selected.begin(), selected.end(), s.name) == selected.end())
+      continue;
+    s.run(quick ? std::max<uint32_t>(1, s.iterations / 10) : s.iterations);
+  }
+
+  sim::I2cErrors errors = sim::i2c_errors();
+  std::printf("== I2C: %u RX-överskridningar, %u TX-underskridningar, %llu NACK; %.1f s virtuell tid\n",
+              errors.rx_overflow, errors.tx_underrun, static_cast<unsigned long long>(pump.nacks()),
+              sim::now() / 1e9);
+  check(errors.rx_overflow == 0 && errors.tx_underrun == 0 && pump.nacks() == 0, "I2C-fel i simuleringen");
+  return failed ? 1 : 0;
+}
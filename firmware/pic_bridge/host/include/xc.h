@@ -0,0 +1,317 @@
+// Värdversion av <xc.h> för den Linux-byggda simulatorn (host/).
+// Firmwaren kompileras oförändrad: varje SFR är en makro som går via
+// sim_sfr_access(), så simulatorn (sim/sim.cpp) ser varje läsning och skrivning
+// i samma ordning som på PIC:en och kan räkna fram flaggor, tömma FIFO:er osv.
+//
+// Bara de register och bitar firmwaren använder finns med. Bitpositionerna
+// följer databladet för PIC18F47Q43 där registret även används som helt byte
+// (I2C1PIE/PIR/ERR, INTCON0, PPSLOCK); för övriga spelar ordningen ingen roll.
+// Ny SFR i firmwaren: lägg till den i SIM_SFR_LIST och som makro nedan.
+
+#ifndef HOST_XC_H
+#define HOST_XC_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// --- XC8-specifikt ---
+#define __interrupt(priority)
+#define SLEEP() sim_sleep()
+#define NOP()   ((void)0)
+
+void sim_sleep(void);
+
+// --- Registerlista ---
+#define SIM_SFR_LIST(X) \
+    X(ADACQ) X(ADCLK) X(ADCON0) X(ADCON2) X(ADCON3) X(ADFLTR) X(ADPCH) X(ADREF) X(ADRPT) \
+    X(ANSELA) X(ANSELB) X(ANSELC) X(CPUDOZE) \
+    X(I2C1ADB0) X(I2C1ADR0) X(I2C1ADR1) X(I2C1ADR2) X(I2C1ADR3) \
+    X(I2C1CON0) X(I2C1CON1) X(I2C1CON2) X(I2C1ERR) X(I2C1PIE) X(I2C1PIR) \
+    X(I2C1RXB) X(I2C1STAT1) X(I2C1TXB) X(I2C1SCLPPS) X(I2C1SDAPPS) \
+    X(INLVLC) X(INTCON0) \
+    X(IPR1) X(IPR3) X(IPR4) X(IPR5) X(IPR7) X(IPR8) X(IPR9) X(IPR12) \
+    X(PIE1) X(PIE3) X(PIE4) X(PIE5) X(PIE7) X(PIE8) X(PIE9) X(PIE12) \
+    X(PIR1) X(PIR3) X(PIR4) X(PIR5) X(PIR7) X(PIR8) X(PIR9) X(PIR12) \
+    X(LATA) X(LATC) X(ODCONA) X(ODCONB) X(OSCCON1) X(OSCFRQ) X(PORTD) X(PPSLOCK) \
+    X(NVMADRH) X(NVMADRL) X(NVMADRU) X(NVMCON0) X(NVMCON1) X(NVMDATL) X(NVMLOCK) \
+    X(RA0PPS) X(RA2PPS) X(RB0PPS) X(RB1PPS) X(RB2PPS) X(RB4PPS) X(RC0PPS) X(RC6PPS) \
+    X(SSP2BUF) X(SSP2CON1) X(SSP2CON2) X(SSP2STAT) \
+    X(T0CON0) X(T0CON1) X(TMR0H) X(TMR0L) \
+    X(T1CLK) X(T1CON) X(TMR1) \
+    X(T2CLKCON) X(T2CON) X(T2HLT) X(T2PR) X(T2TMR) \
+    X(T3CLK) X(T3CON) X(TMR3) \
+    X(TRISA) X(TRISB) X(TRISC) X(TRISD) X(WPUDR) \
+    X(U1BRG) X(U1CON0) X(U1CON1) X(U1ERRIE) X(U1ERRIR) X(U1FIFO) X(U1RXB) X(U1RXPPS) X(U1TXB) \
+    X(U2BRG) X(U2CON0) X(U2CON1) X(U2ERRIR) X(U2FIFO) X(U2RXB) X(U2RXPPS) X(U2TXB) \
+    X(U3BRG) X(U3CON0) X(U3CON1) X(U3ERRIR) X(U3FIFO) X(U3RXPPS) X(U3TXB) \
+    X(U4BRG) X(U4CON0) X(U4CON1) X(U4RXB) X(U4RXPPS) X(U4TXB)
+
+#define SIM_SFR_ENUM(name) SIM_SFR_##name,
+typedef enum { SIM_SFR_LIST(SIM_SFR_ENUM) SIM_SFR_COUNT } sim_sfr_id_t;
+#undef SIM_SFR_ENUM
+
+/**
+ * @brief Synkar simulatorn och returnerar registrets lagring (32 bitar, little endian).
+ * Läsregister (RXB) hämtar nästa byte, skrivregister (TXB) tas om hand vid nästa åtkomst.
+ */
+volatile void *sim_sfr_access(sim_sfr_id_t id);
+
+#define SIM_SFR8(name)        (*(volatile uint8_t *)sim_sfr_access(SIM_SFR_##name))
+#define SIM_SFR16(name)       (*(volatile uint16_t *)sim_sfr_access(SIM_SFR_##name))
+#define SIM_BITS(name)        (*(volatile name##bits_t *)sim_sfr_access(SIM_SFR_##name))
+
+// --- Bitfält ---
+typedef struct { uint8_t ADGO:1; uint8_t :1; uint8_t FM:1; uint8_t :1; uint8_t CS:1; uint8_t :1; uint8_t CONT:1; uint8_t ADON:1; } ADCON0bits_t;
+typedef struct { uint8_t MD:3; uint8_t ACLR:1; uint8_t CRS:3; uint8_t PSIS:1; } ADCON2bits_t;
+typedef struct { uint8_t TMD:3; uint8_t SOI:1; uint8_t CALC:3; uint8_t :1; } ADCON3bits_t;
+typedef struct { uint8_t ADPREF:2; uint8_t :2; uint8_t ADNREF:1; uint8_t :3; } ADREFbits_t;
+typedef struct { uint8_t ANSELA0:1; uint8_t ANSELA1:1; uint8_t ANSELA2:1; uint8_t ANSELA3:1; uint8_t ANSELA4:1; uint8_t ANSELA5:1; uint8_t ANSELA6:1; uint8_t ANSELA7:1; } ANSELAbits_t;
+typedef struct { uint8_t ANSELB0:1; uint8_t ANSELB1:1; uint8_t ANSELB2:1; uint8_t ANSELB3:1; uint8_t ANSELB4:1; uint8_t ANSELB5:1; uint8_t ANSELB6:1; uint8_t ANSELB7:1; } ANSELBbits_t;
+typedef struct { uint8_t ANSELC0:1; uint8_t ANSELC1:1; uint8_t ANSELC2:1; uint8_t ANSELC3:1; uint8_t ANSELC4:1; uint8_t ANSELC5:1; uint8_t ANSELC6:1; uint8_t ANSELC7:1; } ANSELCbits_t;
+typedef struct { uint8_t DOZE:3; uint8_t :1; uint8_t DOE:1; uint8_t ROI:1; uint8_t DOZEN:1; uint8_t IDLEN:1; } CPUDOZEbits_t;
+
+typedef struct { uint8_t MODE:3; uint8_t MDR:1; uint8_t CSTR:1; uint8_t S:1; uint8_t RSEN:1; uint8_t EN:1; } I2C1CON0bits_t;
+typedef struct { uint8_t CSD:1; uint8_t TXU:1; uint8_t RXO:1; uint8_t :1; uint8_t ACKT:1; uint8_t ACKSTAT:1; uint8_t ACKDT:1; uint8_t ACKCNT:1; } I2C1CON1bits_t;
+typedef struct { uint8_t BFRET:2; uint8_t SDAHT:2; uint8_t ABD:1; uint8_t FME:1; uint8_t GCEN:1; uint8_t ACNT:1; } I2C1CON2bits_t;
+typedef struct { uint8_t NACKIE:1; uint8_t BCLIE:1; uint8_t BTOIE:1; uint8_t :1; uint8_t NACKIF:1; uint8_t BCLIF:1; uint8_t BTOIF:1; uint8_t :1; } I2C1ERRbits_t;
+typedef struct { uint8_t SCIE:1; uint8_t RSCIE:1; uint8_t PCIE:1; uint8_t ADRIE:1; uint8_t WRIE:1; uint8_t :1; uint8_t ACKTIE:1; uint8_t CNTIE:1; } I2C1PIEbits_t;
+typedef struct { uint8_t SCIF:1; uint8_t RSCIF:1; uint8_t PCIF:1; uint8_t ADRIF:1; uint8_t WRIF:1; uint8_t :1; uint8_t ACKTIF:1; uint8_t CNTIF:1; } I2C1PIRbits_t;
+typedef struct { uint8_t RXBF:1; uint8_t :1; uint8_t CLRBF:1; uint8_t RXRE:1; uint8_t :1; uint8_t TXBE:1; uint8_t :1; uint8_t TXWE:1; } I2C1STAT1bits_t;
+
+typedef struct { uint8_t INLVLC0:1; uint8_t INLVLC1:1; uint8_t INLVLC2:1; uint8_t INLVLC3:1; uint8_t INLVLC4:1; uint8_t INLVLC5:1; uint8_t INLVLC6:1; uint8_t INLVLC7:1; } INLVLCbits_t;
+typedef union {
+    struct { uint8_t INT0EDG:1; uint8_t INT1EDG:1; uint8_t INT2EDG:1; uint8_t :2; uint8_t IPEN:1; uint8_t GIEL:1; uint8_t GIE:1; };
+    struct { uint8_t :7; uint8_t GIEH:1; };
+} INTCON0bits_t;
+
+typedef struct { uint8_t :1; uint8_t :1; uint8_t ADTIP:1; uint8_t :5; } IPR1bits_t;
+typedef struct { uint8_t :1; uint8_t TMR2IP:1; uint8_t :5; uint8_t TMR0IP:1; } IPR3bits_t;
+typedef struct { uint8_t :4; uint8_t U1RXIP:1; uint8_t U1TXIP:1; uint8_t U1EIP:1; uint8_t :1; } IPR4bits_t;
+typedef struct { uint8_t :4; uint8_t TMR3IP:1; uint8_t :3; } IPR5bits_t;
+typedef struct { uint8_t :1; uint8_t I2C1RXIP:1; uint8_t I2C1TXIP:1; uint8_t I2C1IP:1; uint8_t I2C1EIP:1; uint8_t :3; } IPR7bits_t;
+typedef struct { uint8_t :4; uint8_t U2RXIP:1; uint8_t U2TXIP:1; uint8_t :2; } IPR8bits_t;
+typedef struct { uint8_t :5; uint8_t U3TXIP:1; uint8_t :2; } IPR9bits_t;
+typedef struct { uint8_t :4; uint8_t U4RXIP:1; uint8_t :3; } IPR12bits_t;
+
+typedef struct { uint8_t :1; uint8_t :1; uint8_t ADTIE:1; uint8_t :5; } PIE1bits_t;
+typedef struct { uint8_t :1; uint8_t TMR2IE:1; uint8_t :5; uint8_t TMR0IE:1; } PIE3bits_t;
+typedef struct { uint8_t :4; uint8_t U1RXIE:1; uint8_t U1TXIE:1; uint8_t U1EIE:1; uint8_t :1; } PIE4bits_t;
+typedef struct { uint8_t :4; uint8_t TMR3IE:1; uint8_t :3; } PIE5bits_t;
+typedef struct { uint8_t :1; uint8_t I2C1RXIE:1; uint8_t I2C1TXIE:1; uint8_t I2C1IE:1; uint8_t I2C1EIE:1; uint8_t :3; } PIE7bits_t;
+typedef struct { uint8_t :4; uint8_t U2RXIE:1; uint8_t U2TXIE:1; uint8_t :2; } PIE8bits_t;
+typedef struct { uint8_t :5; uint8_t U3TXIE:1; uint8_t :2; } PIE9bits_t;
+typedef struct { uint8_t :4; uint8_t U4RXIE:1; uint8_t :3; } PIE12bits_t;
+
+typedef struct { uint8_t :1; uint8_t :1; uint8_t ADTIF:1; uint8_t :5; } PIR1bits_t;
+typedef struct { uint8_t :1; uint8_t TMR2IF:1; uint8_t :5; uint8_t TMR0IF:1; } PIR3bits_t;
+typedef struct { uint8_t :4; uint8_t U1RXIF:1; uint8_t U1TXIF:1; uint8_t U1EIF:1; uint8_t :1; } PIR4bits_t;
+typedef struct { uint8_t :4; uint8_t TMR3IF:1; uint8_t :3; } PIR5bits_t;
+typedef struct { uint8_t :1; uint8_t I2C1RXIF:1; uint8_t I2C1TXIF:1; uint8_t I2C1IF:1; uint8_t I2C1EIF:1; uint8_t :3; } PIR7bits_t;
+typedef struct { uint8_t :4; uint8_t U2RXIF:1; uint8_t U2TXIF:1; uint8_t :2; } PIR8bits_t;
+typedef struct { uint8_t :5; uint8_t U3TXIF:1; uint8_t :2; } PIR9bits_t;
+typedef struct { uint8_t :4; uint8_t U4RXIF:1; uint8_t :3; } PIR12bits_t;
+
+typedef struct { uint8_t GO:1; uint8_t :7; } NVMCON0bits_t;
+typedef struct { uint8_t CMD:3; uint8_t :4; uint8_t WRERR:1; } NVMCON1bits_t;
+
+typedef struct { uint8_t LATA0:1; uint8_t LATA1:1; uint8_t LATA2:1; uint8_t LATA3:1; uint8_t LATA4:1; uint8_t LATA5:1; uint8_t LATA6:1; uint8_t LATA7:1; } LATAbits_t;
+typedef struct { uint8_t LATC0:1; uint8_t LATC1:1; uint8_t LATC2:1; uint8_t LATC3:1; uint8_t LATC4:1; uint8_t LATC5:1; uint8_t LATC6:1; uint8_t LATC7:1; } LATCbits_t;
+typedef struct { uint8_t ODCA0:1; uint8_t ODCA1:1; uint8_t ODCA2:1; uint8_t ODCA3:1; uint8_t ODCA4:1; uint8_t ODCA5:1; uint8_t ODCA6:1; uint8_t ODCA7:1; } ODCONAbits_t;
+typedef struct { uint8_t ODCB0:1; uint8_t ODCB1:1; uint8_t ODCB2:1; uint8_t ODCB3:1; uint8_t ODCB4:1; uint8_t ODCB5:1; uint8_t ODCB6:1; uint8_t ODCB7:1; } ODCONBbits_t;
+typedef struct { uint8_t RD0:1; uint8_t RD1:1; uint8_t RD2:1; uint8_t RD3:1; uint8_t RD4:1; uint8_t RD5:1; uint8_t RD6:1; uint8_t RD7:1; } PORTDbits_t;
+typedef struct { uint8_t PPSLOCKED:1; uint8_t :7; } PPSLOCKbits_t;
+
+typedef struct { uint8_t SSPM:4; uint8_t CKP:1; uint8_t SSPEN:1; uint8_t SSPOV:1; uint8_t WCOL:1; } SSP2CON1bits_t;
+typedef struct { uint8_t SEN:1; uint8_t RSEN:1; uint8_t PEN:1; uint8_t RCEN:1; uint8_t ACKEN:1; uint8_t ACKDT:1; uint8_t ACKSTAT:1; uint8_t GCEN:1; } SSP2CON2bits_t;
+typedef struct { uint8_t BF:1; uint8_t UA:1; uint8_t RW:1; uint8_t S:1; uint8_t P:1; uint8_t DA:1; uint8_t CKE:1; uint8_t SMP:1; } SSP2STATbits_t;
+
+typedef struct { uint8_t OUTPS:4; uint8_t MD16:1; uint8_t OUT:1; uint8_t :1; uint8_t EN:1; } T0CON0bits_t;
+typedef struct { uint8_t CKPS:4; uint8_t ASYNC:1; uint8_t CS:3; } T0CON1bits_t;
+typedef struct { uint8_t ON:1; uint8_t RD16:1; uint8_t SYNC:1; uint8_t :1; uint8_t CKPS:2; uint8_t :2; } T1CONbits_t;
+typedef struct { uint8_t CS:5; uint8_t :3; } T2CLKCONbits_t;
+typedef struct { uint8_t OUTPS:4; uint8_t CKPS:3; uint8_t ON:1; } T2CONbits_t;
+typedef struct { uint8_t MODE:5; uint8_t CSYNC:1; uint8_t CPOL:1; uint8_t PSYNC:1; } T2HLTbits_t;
+typedef struct { uint8_t ON:1; uint8_t RD16:1; uint8_t SYNC:1; uint8_t :1; uint8_t CKPS:2; uint8_t :2; } T3CONbits_t;
+
+typedef struct { uint8_t TRISA0:1; uint8_t TRISA1:1; uint8_t TRISA2:1; uint8_t TRISA3:1; uint8_t TRISA4:1; uint8_t TRISA5:1; uint8_t TRISA6:1; uint8_t TRISA7:1; } TRISAbits_t;
+typedef struct { uint8_t TRISB0:1; uint8_t TRISB1:1; uint8_t TRISB2:1; uint8_t TRISB3:1; uint8_t TRISB4:1; uint8_t TRISB5:1; uint8_t TRISB6:1; uint8_t TRISB7:1; } TRISBbits_t;
+typedef struct { uint8_t TRISC0:1; uint8_t TRISC1:1; uint8_t TRISC2:1; uint8_t TRISC3:1; uint8_t TRISC4:1; uint8_t TRISC5:1; uint8_t TRISC6:1; uint8_t TRISC7:1; } TRISCbits_t;
+typedef struct { uint8_t TRISD0:1; uint8_t TRISD1:1; uint8_t TRISD2:1; uint8_t TRISD3:1; uint8_t TRISD4:1; uint8_t TRISD5:1; uint8_t TRISD6:1; uint8_t TRISD7:1; } TRISDbits_t;
+typedef struct { uint8_t WPUDR0:1; uint8_t WPUDR1:1; uint8_t WPUDR2:1; uint8_t WPUDR3:1; uint8_t WPUDR4:1; uint8_t WPUDR5:1; uint8_t WPUDR6:1; uint8_t WPUDR7:1; } WPUDRbits_t;
+
+// UART1-4 har samma layout
+typedef struct { uint8_t MODE:4; uint8_t RXEN:1; uint8_t TXEN:1; uint8_t ABDEN:1; uint8_t BRGS:1; } sim_uart_con0_t;
+typedef struct { uint8_t SENDB:1; uint8_t BRKOVR:1; uint8_t :1; uint8_t RXBIMD:1; uint8_t WUE:1; uint8_t :2; uint8_t ON:1; } sim_uart_con1_t;
+typedef struct { uint8_t TXCIF:1; uint8_t RXFOIF:1; uint8_t RXBKIF:1; uint8_t FERIF:1; uint8_t CERIF:1; uint8_t ABDOVF:1; uint8_t PERIF:1; uint8_t TXMTIF:1; } sim_uart_errir_t;
+typedef struct { uint8_t TXCIE:1; uint8_t RXFOIE:1; uint8_t RXBKIE:1; uint8_t FERIE:1; uint8_t CERIE:1; uint8_t ABDOVE:1; uint8_t PERIE:1; uint8_t TXMTIE:1; } sim_uart_errie_t;
+typedef struct { uint8_t RXBF:1; uint8_t RXBE:1; uint8_t XON:1; uint8_t RXIDL:1; uint8_t TXBF:1; uint8_t TXBE:1; uint8_t STPMD:1; uint8_t TXWRE:1; } sim_uart_fifo_t;
+typedef sim_uart_con0_t  U1CON0bits_t;
+typedef sim_uart_con1_t  U1CON1bits_t;
+typedef sim_uart_errie_t U1ERRIEbits_t;
+typedef sim_uart_errir_t U1ERRIRbits_t;
+typedef sim_uart_fifo_t  U1FIFObits_t;
+typedef sim_uart_con0_t  U2CON0bits_t;
+typedef sim_uart_con1_t  U2CON1bits_t;
+typedef sim_uart_errir_t U2ERRIRbits_t;
+typedef sim_uart_fifo_t  U2FIFObits_t;
+typedef sim_uart_con0_t  U3CON0bits_t;
+typedef sim_uart_con1_t  U3CON1bits_t;
+typedef sim_uart_errir_t U3ERRIRbits_t;
+typedef sim_uart_fifo_t  U3FIFObits_t;
+typedef sim_uart_con0_t  U4CON0bits_t;
+typedef sim_uart_con1_t  U4CON1bits_t;
+
+// --- Register ---
+#define ADACQ       SIM_SFR16(ADACQ)
+#define ADCLK       SIM_SFR8(ADCLK)
+#define ADCON0bits  SIM_BITS(ADCON0)
+#define ADCON2bits  SIM_BITS(ADCON2)
+#define ADCON3bits  SIM_BITS(ADCON3)
+#define ADFLTR      SIM_SFR16(ADFLTR)
+#define ADPCH       SIM_SFR8(ADPCH)
+#define ADREFbits   SIM_BITS(ADREF)
+#define ADRPT       SIM_SFR8(ADRPT)
+#define ANSELAbits  SIM_BITS(ANSELA)
+#define ANSELBbits  SIM_BITS(ANSELB)
+#define ANSELCbits  SIM_BITS(ANSELC)
+#define CPUDOZEbits SIM_BITS(CPUDOZE)
+
+#define I2C1ADB0      SIM_SFR8(I2C1ADB0)
+#define I2C1ADR0      SIM_SFR8(I2C1ADR0)
+#define I2C1ADR1      SIM_SFR8(I2C1ADR1)
+#define I2C1ADR2      SIM_SFR8(I2C1ADR2)
+#define I2C1ADR3      SIM_SFR8(I2C1ADR3)
+#define I2C1CON0bits  SIM_BITS(I2C1CON0)
+#define I2C1CON1bits  SIM_BITS(I2C1CON1)
+#define I2C1CON2bits  SIM_BITS(I2C1CON2)
+#define I2C1ERR       SIM_SFR8(I2C1ERR)
+#define I2C1ERRbits   SIM_BITS(I2C1ERR)
+#define I2C1PIE       SIM_SFR8(I2C1PIE)
+#define I2C1PIEbits   SIM_BITS(I2C1PIE)
+#define I2C1PIR       SIM_SFR8(I2C1PIR)
+#define I2C1PIRbits   SIM_BITS(I2C1PIR)
+#define I2C1RXB       SIM_SFR8(I2C1RXB)
+#define I2C1STAT1bits SIM_BITS(I2C1STAT1)
+#define I2C1TXB       SIM_SFR8(I2C1TXB)
+#define I2C1SCLPPS    SIM_SFR8(I2C1SCLPPS)
+#define I2C1SDAPPS    SIM_SFR8(I2C1SDAPPS)
+
+#define INLVLCbits  SIM_BITS(INLVLC)
+#define INTCON0bits SIM_BITS(INTCON0)
+
+#define IPR1bits  SIM_BITS(IPR1)
+#define IPR3bits  SIM_BITS(IPR3)
+#define IPR4bits  SIM_BITS(IPR4)
+#define IPR5bits  SIM_BITS(IPR5)
+#define IPR7bits  SIM_BITS(IPR7)
+#define IPR8bits  SIM_BITS(IPR8)
+#define IPR9bits  SIM_BITS(IPR9)
+#define IPR12bits SIM_BITS(IPR12)
+#define PIE1bits  SIM_BITS(PIE1)
+#define PIE3bits  SIM_BITS(PIE3)
+#define PIE4bits  SIM_BITS(PIE4)
+#define PIE5bits  SIM_BITS(PIE5)
+#define PIE7bits  SIM_BITS(PIE7)
+#define PIE8bits  SIM_BITS(PIE8)
+#define PIE9bits  SIM_BITS(PIE9)
+#define PIE12bits SIM_BITS(PIE12)
+#define PIR1bits  SIM_BITS(PIR1)
+#define PIR3bits  SIM_BITS(PIR3)
+#define PIR4bits  SIM_BITS(PIR4)
+#define PIR5bits  SIM_BITS(PIR5)
+#define PIR7bits  SIM_BITS(PIR7)
+#define PIR8bits  SIM_BITS(PIR8)
+#define PIR9bits  SIM_BITS(PIR9)
+#define PIR12bits SIM_BITS(PIR12)
+
+#define LATAbits    SIM_BITS(LATA)
+#define LATCbits    SIM_BITS(LATC)
+#define ODCONAbits  SIM_BITS(ODCONA)
+#define ODCONBbits  SIM_BITS(ODCONB)
+#define NVMADRH     SIM_SFR8(NVMADRH)
+#define NVMADRL     SIM_SFR8(NVMADRL)
+#define NVMADRU     SIM_SFR8(NVMADRU)
+#define NVMCON0bits SIM_BITS(NVMCON0)
+#define NVMCON1bits SIM_BITS(NVMCON1)
+#define NVMDATL     SIM_SFR8(NVMDATL)
+#define NVMLOCK     SIM_SFR8(NVMLOCK)
+#define OSCCON1     SIM_SFR8(OSCCON1)
+#define OSCFRQ      SIM_SFR8(OSCFRQ)
+#define PORTDbits   SIM_BITS(PORTD)
+#define PPSLOCK     SIM_SFR8(PPSLOCK)
+#define PPSLOCKbits SIM_BITS(PPSLOCK)
+#define RA0PPS      SIM_SFR8(RA0PPS)
+#define RA2PPS      SIM_SFR8(RA2PPS)
+#define RB0PPS      SIM_SFR8(RB0PPS)
+#define RB1PPS      SIM_SFR8(RB1PPS)
+#define RB2PPS      SIM_SFR8(RB2PPS)
+#define RB4PPS      SIM_SFR8(RB4PPS)
+#define RC0PPS      SIM_SFR8(RC0PPS)
+#define RC6PPS      SIM_SFR8(RC6PPS)
+
+#define SSP2BUF      SIM_SFR8(SSP2BUF)
+#define SSP2CON1bits SIM_BITS(SSP2CON1)
+#define SSP2CON2bits SIM_BITS(SSP2CON2)
+#define SSP2STATbits SIM_BITS(SSP2STAT)
+
+#define T0CON0bits   SIM_BITS(T0CON0)
+#define T0CON1bits   SIM_BITS(T0CON1)
+#define TMR0H        SIM_SFR8(TMR0H)
+#define TMR0L        SIM_SFR8(TMR0L)
+#define T1CLK        SIM_SFR8(T1CLK)
+#define T1CONbits    SIM_BITS(T1CON)
+#define TMR1         SIM_SFR16(TMR1)
+#define T2CLKCONbits SIM_BITS(T2CLKCON)
+#define T2CONbits    SIM_BITS(T2CON)
+#define T2HLTbits    SIM_BITS(T2HLT)
+#define T2PR         SIM_SFR8(T2PR)
+#define T2TMR        SIM_SFR8(T2TMR)
+#define T3CLK        SIM_SFR8(T3CLK)
+#define T3CONbits    SIM_BITS(T3CON)
+#define TMR3         SIM_SFR16(TMR3)
+
+#define TRISAbits SIM_BITS(TRISA)
+#define TRISBbits SIM_BITS(TRISB)
+#define TRISCbits SIM_BITS(TRISC)
+#define TRISDbits SIM_BITS(TRISD)
+#define WPUDRbits SIM_BITS(WPUDR)
+
+#define U1BRG       SIM_SFR16(U1BRG)
+#define U1CON0bits  SIM_BITS(U1CON0)
+#define U1CON1bits  SIM_BITS(U1CON1)
+#define U1ERRIEbits SIM_BITS(U1ERRIE)
+#define U1ERRIRbits SIM_BITS(U1ERRIR)
+#define U1FIFObits  SIM_BITS(U1FIFO)
+#define U1RXB       SIM_SFR8(U1RXB)
+#define U1RXPPS     SIM_SFR8(U1RXPPS)
+#define U1TXB       SIM_SFR8(U1TXB)
+#define U2BRG       SIM_SFR16(U2BRG)
+#define U2CON0bits  SIM_BITS(U2CON0)
+#define U2CON1bits  SIM_BITS(U2CON1)
+#define U2ERRIRbits SIM_BITS(U2ERRIR)
+#define U2FIFObits  SIM_BITS(U2FIFO)
+#define U2RXB       SIM_SFR8(U2RXB)
+#define U2RXPPS     SIM_SFR8(U2RXPPS)
+#define U2TXB       SIM_SFR8(U2TXB)
+#define U3BRG       SIM_SFR16(U3BRG)
+#define U3CON0bits  SIM_BITS(U3CON0)
+#define U3CON1bits  SIM_BITS(U3CON1)
+#define U3ERRIRbits SIM_BITS(U3ERRIR)
+#define U3FIFObits  SIM_BITS(U3FIFO)
+#define U3RXPPS     SIM_SFR8(U3RXPPS)
+#define U3TXB       SIM_SFR8(U3TXB)
+#define U4BRG       SIM_SFR16(U4BRG)
+#define U4CON0bits  SIM_BITS(U4CON0)
+#define U4CON1bits  SIM_BITS(U4CON1)
+#define U4RXB       SIM_SFR8(U4RXB)
+#define U4RXPPS     SIM_SFR8(U4RXPPS)
+#define U4TXB       SIM_SFR8(U4TXB)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HOST_XC_H
@@ -0,0 +1,191 @@
+#include "peers.h"
+
+#include <cstdint>
+
+extern "C" {
+#include "crc.h"
+#include "esp_link.h"
+}
+
+namespace sim {
+
+// --- PumpMaster ---
+
+// Adressen NACK:ades: resten av transaktionen hoppas över
+const size_t STEP_STOP = SIZE_MAX;
+
+PumpMaster::PumpMaster(uint8_t addr7, uint32_t bus_hz)
+    : addr7_(addr7), bit_time_((1000000000ULL + bus_hz / 2) / bus_hz) {}
+
+void PumpMaster::write(uint8_t index, const std::vector<uint8_t> &data) {
+  this->queue_.push_back(Transaction{index, data, 0, nullptr});
+  this->kick();
+}
+
+void PumpMaster::read(uint8_t index, size_t count, ReadDone done) {
+  this->queue_.push_back(Transaction{index, {}, count, std::move(done)});
+  this->kick();
+}
+
+void PumpMaster::kick() {
+  if (this->busy_ || this->queue_.empty())
+    return;
+  this->busy_ = true;
+  schedule(now() + this->gap_, [this] { this->step(0); });
+}
+
+// Ett steg per bussfas. Skrivbytes levereras när nionde klockan (ACK) är klar,
+// läsbytes när de lämnar TXB i början av byten, som i I2C1-modulen.
+void PumpMaster::step(size_t pos) {
+  const Transaction &t = this->queue_.front();
+  size_t write_bytes = 1 + t.data.size();  // Index + data
+  Time next = this->bit_time_;
+
+  if (pos == 0) {
+    this->read_data_.clear();
+    i2c_start(false);
+    next = this->byte_time();
+  } else if (pos == 1) {
+    if (!i2c_address(this->addr7_, false)) {
+      this->nacks_++;
+      schedule(now() + this->bit_time_, [this] { this->step(STEP_STOP); });
+      return;
+    }
+    next = this->byte_time();
+  } else if (pos < 2 + write_bytes) {
+    size_t i = pos - 2;
+    i2c_write(i == 0 ? t.index : t.data[i - 1]);
+    next = (pos + 1 < 2 + write_bytes || t.read_count > 0) ? this->byte_time() : this->bit_time_;
+  } else if (t.read_count > 0 && pos == 2 + write_bytes) {
+    i2c_start(true);
+    next = this->byte_time();
+  } else if (t.read_count > 0 && pos == 3 + write_bytes) {
+    if (!i2c_address(this->addr7_, true)) {
+      this->nacks_++;
+      schedule(now() + this->bit_time_, [this] { this->step(STEP_STOP); });
+      return;
+    }
+    next = 0;
+  } else if (t.read_count > 0 && pos < 4 + write_bytes + t.read_count) {
+    this->read_data_.push_back(i2c_read());
+    next = this->byte_time();
+  } else {
+    // STOP
+    i2c_stop();
+    Transaction done = std::move(this->queue_.front());
+    this->queue_.pop_front();
+    this->completed_++;
+    this->busy_ = false;
+    if (done.done)
+      done.done(this->read_data_);
+    this->kick();
+    return;
+  }
+  schedule(now() + next, [this, pos] { this->step(pos + 1); });
+}
+
+// --- ModbusMaster ---
+
+ModbusMaster::ModbusMaster(uint8_t slave_id, uint32_t baud) : slave_id_(slave_id), baud_(baud) {}
+
+void ModbusMaster::read_holding(uint16_t start, uint16_t count, Done done) {
+  std::vector<uint8_t> frame = {this->slave_id_, 0x03, static_cast<uint8_t>(start >> 8), static_cast<uint8_t>(start),
+                                static_cast<uint8_t>(count >> 8), static_cast<uint8_t>(count)};
+  this->send(std::move(frame), 5 + 2u * count, std::move(done));
+}
+
+void ModbusMaster::write_multiple(uint16_t start, const std::vector<uint16_t> &values, Done done) {
+  uint16_t count = static_cast<uint16_t>(values.size());
+  std::vector<uint8_t> frame = {this->slave_id_,
+                                0x10,
+                                static_cast<uint8_t>(start >> 8),
+                                static_cast<uint8_t>(start),
+                                static_cast<uint8_t>(count >> 8),
+                                static_cast<uint8_t>(count),
+                                static_cast<uint8_t>(2 * count)};
+  for (uint16_t v : values) {
+    frame.push_back(static_cast<uint8_t>(v >> 8));
+    frame.push_back(static_cast<uint8_t>(v));
+  }
+  this->send(std::move(frame), 8, std::move(done));  // Eko av adress, funktion, start och antal
+}
+
+void ModbusMaster::send(std::vector<uint8_t> frame, size_t expected, Done done) {
+  uint16_t crc = CRC16_Compute(frame.data(), frame.size());
+  frame.push_back(static_cast<uint8_t>(crc & 0xFF));
+  frame.push_back(static_cast<uint8_t>(crc >> 8));
+
+  this->busy_ = true;
+  this->done_ = std::move(done);
+  this->response_.clear();
+  this->expected_ = expected;
+  uart_send(1, frame.data(), frame.size(), this->baud_);
+  this->request_end_ = now() + frame.size() * uart_byte_time(this->baud_);
+}
+
+void ModbusMaster::on_byte(uint8_t data, uint32_t) {
+  if (!this->busy_)
+    return;
+  this->response_.push_back(data);
+  if (this->response_.size() == 2 && (data & 0x80))
+    this->expected_ = 5;  // Undantagssvar
+  if (this->response_.size() < this->expected_)
+    return;
+
+  this->busy_ = false;
+  this->last_latency_ = now() - this->request_end_;
+  bool exception = (this->response_[1] & 0x80) != 0;
+  this->last_exception_ = exception ? this->response_[2] : 0;
+  bool ok = CRC16_Compute(this->response_.data(), this->response_.size()) == 0 && !exception;
+  std::vector<uint8_t> registers;
+  if (ok)
+    registers.assign(this->response_.begin() + 3, this->response_.end() - 2);
+  Done done = std::move(this->done_);
+  done(ok, registers);
+}
+
+// --- EspPeer ---
+
+EspPeer::EspPeer(uint32_t baud) : baud_(baud) {}
+
+void EspPeer::request(uint8_t cmd, const std::vector<uint8_t> &payload, Done done) {
+  std::vector<uint8_t> frame = {LINK_SYNC, cmd, static_cast<uint8_t>(payload.size() & 0xFF),
+                                static_cast<uint8_t>(payload.size() >> 8)};
+  frame.insert(frame.end(), payload.begin(), payload.end());
+  uint16_t crc = CRC16_Compute(frame.data() + 1, frame.size() - 1);
+  frame.push_back(static_cast<uint8_t>(crc & 0xFF));
+  frame.push_back(static_cast<uint8_t>(crc >> 8));
+
+  this->busy_ = true;
+  this->done_ = std::move(done);
+  this->rx_.clear();
+  uart_send(2, frame.data(), frame.size(), this->baud_);
+  this->request_end_ = now() + frame.size() * uart_byte_time(this->baud_);
+}
+
+void EspPeer::on_byte(uint8_t data, uint32_t) {
+  if (!this->busy_)
+    return;
+  if (this->rx_.empty() && data != LINK_SYNC)
+    return;
+  this->rx_.push_back(data);
+  if (this->rx_.size() < 4)
+    return;
+  size_t length = this->rx_[2] | (this->rx_[3] << 8);
+  if (this->rx_.size() < 4 + length + 2)
+    return;
+
+  this->busy_ = false;
+  this->last_latency_ = now() - this->request_end_;
+  uint16_t crc = CRC16_Compute(this->rx_.data() + 1, 3 + length);
+  uint16_t received = static_cast<uint16_t>(this->rx_[4 + length] | (this->rx_[5 + length] << 8));
+  if (crc != received) {
+    this->crc_errors_++;
+    return;  // Anroparen ser timeout
+  }
+  std::vector<uint8_t> payload(this->rx_.begin() + 4, this->rx_.begin() + 4 + length);
+  Done done = std::move(this->done_);
+  done(this->rx_[1], payload);
+}
+
+}  // namespace sim
@@ -0,0 +1,134 @@
+// Skriptbara motparter till den simulerade PIC:en: pumpens I2C-master,
+// en Modbus RTU-master på RS485 (UART1) och ESP:n på länken (UART2).
+// Alla är asynkrona; sim::run_until() kör tills ett svar har kommit.
+
+#ifndef HOST_PEERS_H
+#define HOST_PEERS_H
+
+#include "sim.h"
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <vector>
+
+namespace sim {
+
+// --- Pumpen: I2C-master i 100 kHz ---
+class PumpMaster {
+ public:
+  using ReadDone = std::function<void(const std::vector<uint8_t> &)>;
+
+  explicit PumpMaster(uint8_t addr7, uint32_t bus_hz = 100000);
+
+  /**
+   * @brief START, adress W, index, data..., STOP (pumpens Master Write/loggning).
+   */
+  void write(uint8_t index, const std::vector<uint8_t> &data);
+
+  /**
+   * @brief START, adress W, index, RESTART, adress R, count bytes (NACK på sista), STOP.
+   */
+  void read(uint8_t index, size_t count, ReadDone done);
+
+  /**
+   * @brief Paus mellan två transaktioner (busstid, bussen är ledig).
+   */
+  void set_gap(Time gap) { this->gap_ = gap; }
+
+  bool idle() const { return this->queue_.empty() && !this->busy_; }
+  uint64_t completed() const { return this->completed_; }
+  uint64_t nacks() const { return this->nacks_; }
+
+ private:
+  struct Transaction {
+    uint8_t index;
+    std::vector<uint8_t> data;  // Skrivning
+    size_t read_count;          // > 0: läsning
+    ReadDone done;
+  };
+
+  void kick();
+  void step(size_t pos);
+  Time byte_time() const { return 9 * this->bit_time_; }
+
+  uint8_t addr7_;
+  Time bit_time_;
+  Time gap_ = 0;
+  std::deque<Transaction> queue_;
+  bool busy_ = false;
+  std::vector<uint8_t> read_data_;
+  uint64_t completed_ = 0;
+  uint64_t nacks_ = 0;
+};
+
+// --- Modbus RTU-master på UART1 ---
+class ModbusMaster : public UartPeer {
+ public:
+  using Done = std::function<void(bool ok, const std::vector<uint8_t> &registers_be)>;
+
+  ModbusMaster(uint8_t slave_id, uint32_t baud);
+
+  /**
+   * @brief FC03 Read Holding Registers. done får registren som big endian-bytes.
+   */
+  void read_holding(uint16_t start, uint16_t count, Done done);
+
+  /**
+   * @brief FC16 Write Multiple Registers. done får ok = false vid undantag (se last_exception()).
+   */
+  void write_multiple(uint16_t start, const std::vector<uint16_t> &values, Done done);
+
+  bool idle() const { return !this->busy_; }
+  // Från sista byten i förfrågan till sista byten i svaret
+  Time last_latency() const { return this->last_latency_; }
+  // Undantagskoden i senaste svaret, 0 om det inte var ett undantag
+  uint8_t last_exception() const { return this->last_exception_; }
+
+  void on_byte(uint8_t data, uint32_t baud) override;
+
+ private:
+  void send(std::vector<uint8_t> frame, size_t expected, Done done);
+
+  uint8_t slave_id_;
+  uint32_t baud_;
+  bool busy_ = false;
+  size_t expected_ = 0;
+  std::vector<uint8_t> response_;
+  Time request_end_ = 0;
+  Time last_latency_ = 0;
+  uint8_t last_exception_ = 0;
+  Done done_;
+};
+
+// --- ESP:n på länken (UART2), esp_link.h ---
+class EspPeer : public UartPeer {
+ public:
+  using Done = std::function<void(uint8_t cmd, const std::vector<uint8_t> &payload)>;
+
+  explicit EspPeer(uint32_t baud);
+
+  /**
+   * @brief Skickar en ram. done anropas med svarets CMD och payload när CRC stämmer.
+   */
+  void request(uint8_t cmd, const std::vector<uint8_t> &payload, Done done);
+
+  bool idle() const { return !this->busy_; }
+  Time last_latency() const { return this->last_latency_; }
+  uint32_t crc_errors() const { return this->crc_errors_; }
+
+  void on_byte(uint8_t data, uint32_t baud) override;
+
+ private:
+  uint32_t baud_;
+  bool busy_ = false;
+  std::vector<uint8_t> rx_;
+  Time request_end_ = 0;
+  Time last_latency_ = 0;
+  uint32_t crc_errors_ = 0;
+  Done done_;
+};
+
+}  // namespace sim
+
+#endif  // HOST_PEERS_H
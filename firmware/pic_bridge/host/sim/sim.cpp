@@ -0,0 +1,850 @@
+#include "sim.h"
+
+#include <xc.h>
+#include <ucontext.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <map>
+#include <queue>
+#include <utility>
+
+extern "C" {
+void High_Priority_ISR(void);
+void Low_Priority_ISR(void);
+void pic_main(void);  // main() i main.c, omdöpt av host/CMakeLists.txt
+}
+
+namespace sim {
+namespace {
+
+// --- SFR-lagring ---
+
+uint32_t sfr[SIM_SFR_COUNT];
+
+#define SIM_SFR_NAME(name) #name,
+const char *const SFR_NAMES[] = {SIM_SFR_LIST(SIM_SFR_NAME)};
+#undef SIM_SFR_NAME
+
+template <typename T> T &reg(sim_sfr_id_t id) { return *reinterpret_cast<T *>(&sfr[id]); }
+uint8_t &byte(sim_sfr_id_t id) { return reg<uint8_t>(id); }
+uint16_t &word(sim_sfr_id_t id) { return reg<uint16_t>(id); }
+
+[[noreturn]] void fatal(const char *what, const char *detail = "") {
+  std::fprintf(stderr, "sim: %s %s\n", what, detail);
+  std::abort();
+}
+
+// --- Virtuell tid och händelser ---
+
+struct Event {
+  Time at;
+  uint64_t seq;
+  std::function<void()> func;
+};
+
+struct Later {
+  bool operator()(const Event &a, const Event &b) const { return a.at != b.at ? a.at > b.at : a.seq > b.seq; }
+};
+
+Time t_now = 0;
+uint64_t event_seq = 0;
+std::priority_queue<Event, std::vector<Event>, Later> events;
+
+// Antal tick vid tiden t för en timer som räknar clock_hz (heltal, ingen drift)
+uint64_t ticks_at(Time t, uint64_t clock_hz) { return (t * clock_hz) / 1000000000ULL; }
+Time time_of_ticks(uint64_t ticks, uint64_t clock_hz) { return (ticks * 1000000000ULL + clock_hz - 1) / clock_hz; }
+
+// --- Skrivningar som tas om hand vid nästa åtkomst ---
+
+struct Touched {
+  sim_sfr_id_t id;
+  uint32_t before;
+};
+std::vector<Touched> touched;
+bool flags_dirty = true;
+
+// En ISR körs (inga nya avbrott levereras då, ISR:er avbryts inte i simuleringen)
+bool isr_active = false;
+// Något avbrott har levererats sedan SLEEP(): CPU:n vaknar
+bool delivered = false;
+
+// Busy-wait: samma register lästs så här många gånger i rad utan annan åtkomst
+const uint32_t SPIN_LIMIT = 1000;
+sim_sfr_id_t last_access = SIM_SFR_COUNT;
+uint32_t same_access = 0;
+
+// --- UART1-4 ---
+
+const size_t UART_FIFO_DEPTH = 2;
+
+class DebugSink : public UartPeer {
+ public:
+  void on_byte(uint8_t data, uint32_t) override {
+    if (this->bytes.size() < (1u << 20))
+      this->bytes.push_back(data);
+  }
+  std::vector<uint8_t> bytes;
+};
+
+struct Uart {
+  sim_sfr_id_t brg, con0, con1, rxb, txb, fifo, errir;
+  std::deque<std::pair<uint8_t, bool>> rx;  // Byte, ramfel
+  std::deque<uint8_t> tx;
+  bool shifting;
+  Time line_free;  // Motpartens nästa byte kan börja
+  UartPeer *peer;
+};
+
+Uart uarts[4] = {
+    {SIM_SFR_U1BRG, SIM_SFR_U1CON0, SIM_SFR_U1CON1, SIM_SFR_U1RXB, SIM_SFR_U1TXB, SIM_SFR_U1FIFO, SIM_SFR_U1ERRIR, {}, {}, false, 0, nullptr},
+    {SIM_SFR_U2BRG, SIM_SFR_U2CON0, SIM_SFR_U2CON1, SIM_SFR_U2RXB, SIM_SFR_U2TXB, SIM_SFR_U2FIFO, SIM_SFR_U2ERRIR, {}, {}, false, 0, nullptr},
+    {SIM_SFR_U3BRG, SIM_SFR_U3CON0, SIM_SFR_U3CON1, SIM_SFR_COUNT, SIM_SFR_U3TXB, SIM_SFR_U3FIFO, SIM_SFR_U3ERRIR, {}, {}, false, 0, nullptr},
+    {SIM_SFR_U4BRG, SIM_SFR_U4CON0, SIM_SFR_U4CON1, SIM_SFR_U4RXB, SIM_SFR_U4TXB, SIM_SFR_COUNT, SIM_SFR_COUNT, {}, {}, false, 0, nullptr},
+};
+
+DebugSink debug_sink;
+
+uint32_t baud_of(const Uart &u) {
+  uint32_t div = reg<sim_uart_con0_t>(u.con0).BRGS ? 4 : 16;
+  return FOSC / (div * (word(u.brg) + 1u));
+}
+
+bool uart_tx_on(const Uart &u) { return reg<sim_uart_con1_t>(u.con1).ON && reg<sim_uart_con0_t>(u.con0).TXEN; }
+bool uart_rx_on(const Uart &u) { return reg<sim_uart_con1_t>(u.con1).ON && reg<sim_uart_con0_t>(u.con0).RXEN; }
+
+void uart_kick(Uart &u) {
+  if (u.shifting || u.tx.empty())
+    return;
+  uint8_t data = u.tx.front();
+  u.tx.pop_front();
+  u.shifting = true;
+  uint32_t baud = baud_of(u);
+  Uart *up = &u;
+  schedule(t_now + uart_byte_time(baud), [up, data, baud] {
+    up->shifting = false;
+    flags_dirty = true;
+    if (up->peer != nullptr)
+      up->peer->on_byte(data, baud);
+    uart_kick(*up);
+  });
+  flags_dirty = true;
+}
+
+void uart_receive(Uart &u, uint8_t data, uint32_t baud) {
+  if (!uart_rx_on(u))
+    return;
+  uint32_t own = baud_of(u);
+  uint32_t diff = own > baud ? own - baud : baud - own;
+  bool framing_error = diff * 100 > own * 3;
+  if (u.rx.size() >= UART_FIFO_DEPTH) {
+    if (u.errir != SIM_SFR_COUNT)
+      reg<sim_uart_errir_t>(u.errir).RXFOIF = 1;
+  } else {
+    u.rx.emplace_back(framing_error ? static_cast<uint8_t>(data ^ 0x5A) : data, framing_error);
+  }
+  flags_dirty = true;
+}
+
+// --- 1-Wire-buss utan givare på UART4: linan ekar det PIC:en skickar ---
+
+class EmptyOneWireBus : public UartPeer {
+ public:
+  bool shorted = false;
+
+  void on_byte(uint8_t data, uint32_t baud) override {
+    // Ingen presence-puls (0xF0 tillbaka) och alla lästa bitar blir 1.
+    // Kortsluten mot jord läses varje slot som 0.
+    uart_receive(uarts[3], this->shorted ? 0x00 : data, baud);
+  }
+};
+EmptyOneWireBus one_wire_bus;
+
+// --- I2C1 ---
+
+struct I2c {
+  bool rx_full, tx_full, read_phase;
+  uint8_t rx_byte, tx_byte;
+  I2cErrors errors;
+} i2c;
+
+bool i2c_enabled() { return reg<I2C1CON0bits_t>(SIM_SFR_I2C1CON0).EN; }
+
+// --- Timrar ---
+
+const uint64_t FOSC4 = FOSC / 4;
+const uint64_t MFINTOSC_HZ = 31250;
+
+uint32_t tmr0_gen = 0, tmr2_gen = 0, tmr3_gen = 0;
+uint16_t tmr3_base = 0;
+Time tmr3_base_time = 0;
+
+uint64_t tmr1_hz() { return FOSC4 >> reg<T1CONbits_t>(SIM_SFR_T1CON).CKPS; }
+uint64_t tmr3_hz() { return FOSC4 >> reg<T3CONbits_t>(SIM_SFR_T3CON).CKPS; }
+
+uint16_t tmr3_now() {
+  if (!reg<T3CONbits_t>(SIM_SFR_T3CON).ON)
+    return tmr3_base;
+  uint64_t elapsed = ticks_at(t_now, tmr3_hz()) - ticks_at(tmr3_base_time, tmr3_hz());
+  return static_cast<uint16_t>(tmr3_base + elapsed);
+}
+
+void tmr3_load(uint16_t value) {
+  tmr3_base = value;
+  tmr3_base_time = t_now;
+  uint32_t gen = ++tmr3_gen;
+  if (!reg<T3CONbits_t>(SIM_SFR_T3CON).ON)
+    return;
+  Time at = time_of_ticks(ticks_at(t_now, tmr3_hz()) + (0x10000u - value), tmr3_hz());
+  schedule(at, [gen] {
+    if (gen != tmr3_gen)
+      return;
+    reg<PIR5bits_t>(SIM_SFR_PIR5).TMR3IF = 1;
+    tmr3_load(0);  // Räknar vidare från 0 efter överslaget
+  });
+}
+
+void tmr0_schedule(uint32_t gen) {
+  // 8-bitarsläge, Fosc/4: perioden är (TMR0H + 1) * förskalare * efterskalare
+  uint64_t ticks = (byte(SIM_SFR_TMR0H) + 1ull) << reg<T0CON1bits_t>(SIM_SFR_T0CON1).CKPS;
+  ticks *= reg<T0CON0bits_t>(SIM_SFR_T0CON0).OUTPS + 1ull;
+  schedule(t_now + time_of_ticks(ticks, FOSC4), [gen] {
+    if (gen != tmr0_gen)
+      return;
+    reg<PIR3bits_t>(SIM_SFR_PIR3).TMR0IF = 1;
+    tmr0_schedule(gen);
+  });
+}
+
+void tmr2_schedule(uint32_t gen) {
+  // MFINTOSC: perioden är (T2PR + 1) steg, TMR2IF varje period tills ON slås av
+  uint64_t ticks = (byte(SIM_SFR_T2PR) + 1ull) << reg<T2CONbits_t>(SIM_SFR_T2CON).CKPS;
+  ticks *= reg<T2CONbits_t>(SIM_SFR_T2CON).OUTPS + 1ull;
+  schedule(t_now + time_of_ticks(ticks, MFINTOSC_HZ), [gen] {
+    if (gen != tmr2_gen)
+      return;
+    reg<PIR3bits_t>(SIM_SFR_PIR3).TMR2IF = 1;
+    tmr2_schedule(gen);
+  });
+}
+
+void tmr2_restart() {
+  uint32_t gen = ++tmr2_gen;
+  if (reg<T2CONbits_t>(SIM_SFR_T2CON).ON)
+    tmr2_schedule(gen);
+}
+
+// --- ADCC (burst-medelvärde) ---
+
+const uint32_t ADC_CONVERSION_TAD = 15;
+std::map<uint8_t, std::function<uint16_t()>> adc_sources;
+
+void adc_start_burst() {
+  uint64_t tad_ns = 2ull * (byte(SIM_SFR_ADCLK) + 1u) * 1000000000ULL / FOSC;
+  uint64_t samples = byte(SIM_SFR_ADRPT) ? byte(SIM_SFR_ADRPT) : 1;
+  Time duration = (word(SIM_SFR_ADACQ) + samples * ADC_CONVERSION_TAD) * tad_ns;
+  schedule(t_now + duration, [] {
+    auto found = adc_sources.find(byte(SIM_SFR_ADPCH));
+    word(SIM_SFR_ADFLTR) = found != adc_sources.end() ? found->second() : 0x2000;
+    reg<ADCON0bits_t>(SIM_SFR_ADCON0).ADGO = 0;
+    reg<PIR1bits_t>(SIM_SFR_PIR1).ADTIF = 1;
+  });
+}
+
+// --- SPI2 + MCP4251 ---
+
+Mcp4251 pot = {{128, 128}, {0, 0}};
+bool pot_in_command = false;
+uint8_t pot_command = 0;
+
+uint8_t pot_transfer(uint8_t data) {
+  if (!pot_in_command) {
+    pot_command = data;
+    uint8_t op = (data >> 2) & 0x03;
+    if (op == 0 || op == 3)
+      pot_in_command = true;
+    // Kommandobyten svarar med D8 i bit 0 vid läsning
+    return op == 3 ? static_cast<uint8_t>(0xFE | ((pot.wiper[(data >> 4) & 1] >> 8) & 1)) : 0xFF;
+  }
+  pot_in_command = false;
+  uint8_t address = (pot_command >> 4) & 0x0F;
+  if (address > 1)
+    return 0xFF;  // TCON/STATUS modelleras inte
+  if (((pot_command >> 2) & 0x03) == 3)
+    return static_cast<uint8_t>(pot.wiper[address] & 0xFF);
+  pot.wiper[address] = static_cast<uint16_t>(((pot_command & 0x01) << 8) | data);
+  pot.writes[address]++;
+  return 0xFF;
+}
+
+void spi2_transfer() {
+  uint8_t rx = 0xFF;
+  if (reg<SSP2CON1bits_t>(SIM_SFR_SSP2CON1).SSPEN && !reg<LATAbits_t>(SIM_SFR_LATA).LATA4)
+    rx = pot_transfer(byte(SIM_SFR_SSP2BUF));
+  byte(SIM_SFR_SSP2BUF) = rx;
+  reg<SSP2STATbits_t>(SIM_SFR_SSP2STAT).BF = 1;
+}
+
+// --- Data-EEPROM ---
+
+const uint32_t EEPROM_BASE = 0x380000;
+const uint8_t NVM_CMD_READ = 0b000;
+const uint8_t NVM_CMD_WRITE = 0b011;
+const uint64_t EEPROM_WRITE_US = 4000;  // Typisk skrivtid för en byte (radering ingår)
+
+std::vector<uint8_t> eeprom_data(EEPROM_SIZE, 0xFF);  // Raderad
+uint32_t eeprom_write_count = 0;
+uint8_t nvm_unlock = 0;  // 0x55 och 0xAA skrivna i följd till NVMLOCK
+
+void nvm_lock_written(uint8_t value) {
+  if (value == 0x55)
+    nvm_unlock = 1;
+  else if (value == 0xAA && nvm_unlock == 1)
+    nvm_unlock = 2;
+  else
+    nvm_unlock = 0;
+}
+
+void nvm_go() {
+  uint32_t address = (byte(SIM_SFR_NVMADRU) << 16) | (byte(SIM_SFR_NVMADRH) << 8) | byte(SIM_SFR_NVMADRL);
+  bool unlocked = nvm_unlock == 2;
+  nvm_unlock = 0;
+  if (address < EEPROM_BASE || address >= EEPROM_BASE + EEPROM_SIZE)
+    fatal("NVM-åtkomst utanför data-EEPROM:en");
+  uint32_t offset = address - EEPROM_BASE;
+  auto &con1 = reg<NVMCON1bits_t>(SIM_SFR_NVMCON1);
+
+  if (con1.CMD == NVM_CMD_READ) {
+    byte(SIM_SFR_NVMDATL) = eeprom_data[offset];
+    reg<NVMCON0bits_t>(SIM_SFR_NVMCON0).GO = 0;
+    return;
+  }
+  if (con1.CMD != NVM_CMD_WRITE)
+    fatal("NVM-kommandot modelleras inte");
+  if (!unlocked) {
+    con1.WRERR = 1;
+    reg<NVMCON0bits_t>(SIM_SFR_NVMCON0).GO = 0;
+    return;
+  }
+  uint8_t data = byte(SIM_SFR_NVMDATL);
+  schedule(t_now + us(EEPROM_WRITE_US), [offset, data] {
+    eeprom_data[offset] = data;
+    eeprom_write_count++;
+    reg<NVMCON0bits_t>(SIM_SFR_NVMCON0).GO = 0;
+  });
+}
+
+// --- Flaggor som följer kringenhetens tillstånd ---
+
+void update_uart_flags(Uart &u) {
+  if (u.fifo != SIM_SFR_COUNT) {
+    auto &fifo = reg<sim_uart_fifo_t>(u.fifo);
+    fifo.RXBE = u.rx.empty();
+    fifo.RXBF = u.rx.size() >= UART_FIFO_DEPTH;
+    fifo.TXBE = u.tx.empty();
+    fifo.TXBF = u.tx.size() >= UART_FIFO_DEPTH;
+  }
+  if (u.errir != SIM_SFR_COUNT) {
+    auto &errir = reg<sim_uart_errir_t>(u.errir);
+    errir.TXMTIF = u.tx.empty() && !u.shifting;
+    errir.FERIF = !u.rx.empty() && u.rx.front().second;
+  }
+}
+
+bool uart_txif(const Uart &u) { return uart_tx_on(u) && u.tx.size() < UART_FIFO_DEPTH; }
+
+void update_flags() {
+  flags_dirty = false;
+  for (Uart &u : uarts)
+    update_uart_flags(u);
+
+  auto &pir4 = reg<PIR4bits_t>(SIM_SFR_PIR4);
+  pir4.U1RXIF = !uarts[0].rx.empty();
+  pir4.U1TXIF = uart_txif(uarts[0]);
+  pir4.U1EIF = (byte(SIM_SFR_U1ERRIE) & byte(SIM_SFR_U1ERRIR)) != 0;
+  auto &pir8 = reg<PIR8bits_t>(SIM_SFR_PIR8);
+  pir8.U2RXIF = !uarts[1].rx.empty();
+  pir8.U2TXIF = uart_txif(uarts[1]);
+  reg<PIR9bits_t>(SIM_SFR_PIR9).U3TXIF = uart_txif(uarts[2]);
+  reg<PIR12bits_t>(SIM_SFR_PIR12).U4RXIF = !uarts[3].rx.empty();
+
+  auto &pir7 = reg<PIR7bits_t>(SIM_SFR_PIR7);
+  pir7.I2C1RXIF = i2c.rx_full;
+  pir7.I2C1TXIF = i2c.read_phase && !i2c.tx_full;
+  pir7.I2C1IF = (byte(SIM_SFR_I2C1PIR) & byte(SIM_SFR_I2C1PIE)) != 0;
+  uint8_t err = byte(SIM_SFR_I2C1ERR);
+  pir7.I2C1EIF = ((err >> 4) & err & 0x07) != 0;
+  auto &stat1 = reg<I2C1STAT1bits_t>(SIM_SFR_I2C1STAT1);
+  stat1.RXBF = i2c.rx_full;
+  stat1.TXBE = !i2c.tx_full;
+}
+
+// --- Skrivningar ---
+
+// Register där själva åtkomsten är en skrivning (även med samma värde)
+bool write_strobe(sim_sfr_id_t id) {
+  switch (id) {
+    case SIM_SFR_U1TXB:
+    case SIM_SFR_U2TXB:
+    case SIM_SFR_U3TXB:
+    case SIM_SFR_U4TXB:
+    case SIM_SFR_I2C1TXB:
+    case SIM_SFR_T2TMR:
+    case SIM_SFR_SSP2BUF:
+    case SIM_SFR_NVMLOCK:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Register vars skrivning har en sidoeffekt eller påverkar en härledd avbrottsflagga
+bool watched(sim_sfr_id_t id) {
+  switch (id) {
+    case SIM_SFR_I2C1PIR:
+    case SIM_SFR_I2C1PIE:
+    case SIM_SFR_I2C1ERR:
+    case SIM_SFR_U1ERRIR:
+    case SIM_SFR_U1ERRIE:
+    case SIM_SFR_I2C1STAT1:
+    case SIM_SFR_I2C1CON0:
+    case SIM_SFR_LATA:
+    case SIM_SFR_ADCON0:
+    case SIM_SFR_ADCON2:
+    case SIM_SFR_T0CON0:
+    case SIM_SFR_T2CON:
+    case SIM_SFR_T3CON:
+    case SIM_SFR_TMR3:
+    case SIM_SFR_NVMCON0:
+      return true;
+    default:
+      return write_strobe(id);
+  }
+}
+
+void on_write(sim_sfr_id_t id, uint32_t before) {
+  uint32_t after = sfr[id];
+  switch (id) {
+    case SIM_SFR_U1TXB:
+    case SIM_SFR_U2TXB:
+    case SIM_SFR_U3TXB:
+    case SIM_SFR_U4TXB: {
+      Uart &u = uarts[id == SIM_SFR_U1TXB ? 0 : id == SIM_SFR_U2TXB ? 1 : id == SIM_SFR_U3TXB ? 2 : 3];
+      if (uart_tx_on(u) && u.tx.size() < UART_FIFO_DEPTH) {
+        u.tx.push_back(static_cast<uint8_t>(after));
+        uart_kick(u);
+      }
+      break;
+    }
+    case SIM_SFR_I2C1TXB:
+      i2c.tx_full = true;
+      i2c.tx_byte = static_cast<uint8_t>(after);
+      break;
+    case SIM_SFR_I2C1STAT1:
+      if (reg<I2C1STAT1bits_t>(id).CLRBF) {
+        reg<I2C1STAT1bits_t>(id).CLRBF = 0;
+        i2c.rx_full = false;
+        i2c.tx_full = false;
+      }
+      break;
+    case SIM_SFR_I2C1CON0:
+      if (!reg<I2C1CON0bits_t>(id).EN) {
+        i2c.rx_full = i2c.tx_full = i2c.read_phase = false;
+      }
+      break;
+    case SIM_SFR_SSP2BUF:
+      spi2_transfer();
+      break;
+    case SIM_SFR_LATA:
+      if ((before & 0x10) && !(after & 0x10))
+        pot_in_command = false;  // CS ned: nytt kommando
+      break;
+    case SIM_SFR_ADCON0:
+      if (!(before & 0x01) && (after & 0x01) && reg<ADCON0bits_t>(id).ADON)
+        adc_start_burst();
+      break;
+    case SIM_SFR_ADCON2:
+      reg<ADCON2bits_t>(id).ACLR = 0;
+      break;
+    case SIM_SFR_T0CON0:
+      if ((before ^ after) & 0x80) {
+        uint32_t gen = ++tmr0_gen;
+        if (after & 0x80)
+          tmr0_schedule(gen);
+      }
+      break;
+    case SIM_SFR_T2CON:
+      if ((before ^ after) & 0x80)
+        tmr2_restart();
+      break;
+    case SIM_SFR_T2TMR:
+      tmr2_restart();
+      break;
+    case SIM_SFR_T3CON:
+      if ((before ^ after) & 0x01)
+        tmr3_load(static_cast<uint16_t>(word(SIM_SFR_TMR3)));
+      break;
+    case SIM_SFR_TMR3:
+      if (before != after)
+        tmr3_load(static_cast<uint16_t>(after));
+      break;
+    case SIM_SFR_NVMLOCK:
+      nvm_lock_written(static_cast<uint8_t>(after));
+      break;
+    case SIM_SFR_NVMCON0:
+      if (!(before & 0x01) && (after & 0x01))
+        nvm_go();
+      break;
+    default:
+      break;
+  }
+  flags_dirty = true;
+}
+
+void sync() {
+  // on_write kan inte lägga till nya poster, men kopiera ändå för säkerhets skull
+  if (!touched.empty()) {
+    std::vector<Touched> pending;
+    pending.swap(touched);
+    for (const Touched &t : pending) {
+      if (write_strobe(t.id) || sfr[t.id] != t.before)
+        on_write(t.id, t.before);
+    }
+  }
+  if (flags_dirty)
+    update_flags();
+}
+
+// --- Avbrott ---
+
+struct Source {
+  const char *name;
+  bool (*pending)();
+  bool (*high)();
+};
+
+#define SIM_SOURCE(name, PIE, PIR, IPR)                                                \
+  {                                                                                     \
+    #name, [] { return reg<PIE##bits_t>(SIM_SFR_##PIE).name##IE && reg<PIR##bits_t>(SIM_SFR_##PIR).name##IF; }, \
+        [] { return static_cast<bool>(reg<IPR##bits_t>(SIM_SFR_##IPR).name##IP); }  \
+  }
+
+const Source SOURCES[] = {
+    SIM_SOURCE(I2C1RX, PIE7, PIR7, IPR7), SIM_SOURCE(I2C1TX, PIE7, PIR7, IPR7),
+    SIM_SOURCE(I2C1, PIE7, PIR7, IPR7),   SIM_SOURCE(I2C1E, PIE7, PIR7, IPR7),
+    SIM_SOURCE(TMR3, PIE5, PIR5, IPR5),   SIM_SOURCE(TMR0, PIE3, PIR3, IPR3),
+    SIM_SOURCE(TMR2, PIE3, PIR3, IPR3),   SIM_SOURCE(U1RX, PIE4, PIR4, IPR4),
+    SIM_SOURCE(U1TX, PIE4, PIR4, IPR4),   SIM_SOURCE(U1E, PIE4, PIR4, IPR4),
+    SIM_SOURCE(U2RX, PIE8, PIR8, IPR8),   SIM_SOURCE(U2TX, PIE8, PIR8, IPR8),
+    SIM_SOURCE(U3TX, PIE9, PIR9, IPR9),   SIM_SOURCE(U4RX, PIE12, PIR12, IPR12),
+    SIM_SOURCE(ADT, PIE1, PIR1, IPR1),
+};
+
+#undef SIM_SOURCE
+
+const Source *pending_source(bool high) {
+  for (const Source &s : SOURCES) {
+    if (s.pending() && s.high() == high)
+      return &s;
+  }
+  return nullptr;
+}
+
+// Kör ISR:erna tills inget aktiverat avbrott väntar. En flagga som ISR:en aldrig
+// kvitterar skulle låsa PIC:en; det rapporteras istället för att hänga.
+void deliver_interrupts() {
+  if (isr_active)
+    return;
+  const int MAX_ROUNDS = 256;
+  const Source *last = nullptr;
+  for (int round = 0; round < MAX_ROUNDS; round++) {
+    sync();
+    const auto &intcon = reg<INTCON0bits_t>(SIM_SFR_INTCON0);
+    if (!intcon.GIEH)
+      return;
+    bool high = true;
+    last = pending_source(true);
+    if (last == nullptr && intcon.GIEL) {
+      high = false;
+      last = pending_source(false);
+    }
+    if (last == nullptr)
+      return;
+    isr_active = true;
+    if (high)
+      High_Priority_ISR();
+    else
+      Low_Priority_ISR();
+    isr_active = false;
+    delivered = true;
+  }
+  fatal("avbrottet kvitteras aldrig:", last->name);
+}
+
+void run_next_event() {
+  Event ev = events.top();
+  events.pop();
+  t_now = ev.at;
+  ev.func();
+  deliver_interrupts();
+}
+
+// --- Firmwarefibern ---
+
+ucontext_t harness_context;
+ucontext_t firmware_context;
+std::vector<char> firmware_stack(1 << 20);
+bool in_firmware = false;
+bool booted = false;
+
+void firmware_entry() {
+  pic_main();
+  fatal("main() returnerade");
+}
+
+void resume_firmware() {
+  in_firmware = true;
+  if (swapcontext(&harness_context, &firmware_context) != 0)
+    fatal("swapcontext misslyckades");
+  in_firmware = false;
+  sync();
+}
+
+// Idle: kör händelser tills ett avbrott har väckt CPU:n eller deadline nås.
+// Avbrott som blev aktiva under varvet (t.ex. TXIE) levereras direkt.
+bool idle_until_interrupt(Time deadline) {
+  delivered = false;
+  deliver_interrupts();
+  while (!delivered) {
+    if (events.empty())
+      fatal("inga händelser kvar, PIC:en sover för evigt");
+    if (events.top().at > deadline) {
+      t_now = deadline;
+      return false;
+    }
+    run_next_event();
+  }
+  return true;
+}
+
+}  // namespace
+
+// --- Publikt API ---
+
+Time now() { return t_now; }
+Time us(uint64_t n) { return n * 1000ULL; }
+Time ms(uint64_t n) { return n * 1000000ULL; }
+
+void schedule(Time at, std::function<void()> func) {
+  if (at < t_now)
+    at = t_now;
+  events.push(Event{at, event_seq++, std::move(func)});
+}
+
+void boot() {
+  if (booted)
+    fatal("boot() anropad två gånger");
+  booted = true;
+  // RD0 har pull-up: 150 Ohm-kurvan om ingen bygel sitter
+  reg<PORTDbits_t>(SIM_SFR_PORTD).RD0 = 1;
+  uarts[2].peer = &debug_sink;
+  uarts[3].peer = &one_wire_bus;
+
+  getcontext(&firmware_context);
+  firmware_context.uc_stack.ss_sp = firmware_stack.data();
+  firmware_context.uc_stack.ss_size = firmware_stack.size();
+  firmware_context.uc_link = nullptr;
+  makecontext(&firmware_context, firmware_entry, 0);
+  resume_firmware();
+}
+
+bool run_until(const std::function<bool()> &done, Time timeout) {
+  Time deadline = t_now + timeout;
+  while (!done()) {
+    if (t_now >= deadline)
+      return false;
+    if (idle_until_interrupt(deadline))
+      resume_firmware();
+  }
+  return true;
+}
+
+void run_for(Time duration) {
+  run_until([] { return false; }, duration);
+}
+
+void uart_attach(int n, UartPeer *peer) { uarts[n - 1].peer = peer; }
+
+void onewire_short(bool shorted) { one_wire_bus.shorted = shorted; }
+
+void uart_send(int n, const uint8_t *data, size_t length, uint32_t baud) {
+  Uart *u = &uarts[n - 1];
+  Time byte_time = uart_byte_time(baud);
+  for (size_t i = 0; i < length; i++) {
+    Time start = u->line_free > t_now ? u->line_free : t_now;
+    u->line_free = start + byte_time;
+    uint8_t b = data[i];
+    schedule(u->line_free, [u, b, baud] { uart_receive(*u, b, baud); });
+  }
+}
+
+uint32_t uart_baud(int n) { return baud_of(uarts[n - 1]); }
+
+Time uart_byte_time(uint32_t baud) { return (10ULL * 1000000000ULL + baud / 2) / baud; }
+
+void i2c_start(bool restart) {
+  sync();
+  if (!i2c_enabled())
+    return;
+  i2c.read_phase = false;
+  auto &pir = reg<I2C1PIRbits_t>(SIM_SFR_I2C1PIR);
+  if (restart)
+    pir.RSCIF = 1;
+  else
+    pir.SCIF = 1;
+  flags_dirty = true;
+  deliver_interrupts();
+}
+
+bool i2c_address(uint8_t addr7, bool read) {
+  sync();
+  if (!i2c_enabled() || addr7 != (byte(SIM_SFR_I2C1ADR0) >> 1))
+    return false;
+  byte(SIM_SFR_I2C1ADB0) = static_cast<uint8_t>((addr7 << 1) | (read ? 1 : 0));
+  i2c.read_phase = read;
+  flags_dirty = true;
+  deliver_interrupts();
+  return true;
+}
+
+bool i2c_write(uint8_t data) {
+  sync();
+  if (!i2c_enabled())
+    return false;
+  if (i2c.rx_full) {
+    reg<I2C1CON1bits_t>(SIM_SFR_I2C1CON1).RXO = 1;
+    i2c.errors.rx_overflow++;
+  } else {
+    i2c.rx_full = true;
+    i2c.rx_byte = data;
+  }
+  flags_dirty = true;
+  deliver_interrupts();
+  return true;
+}
+
+uint8_t i2c_read() {
+  sync();
+  if (!i2c_enabled())
+    return 0xFF;
+  uint8_t data = 0xFF;
+  if (i2c.tx_full) {
+    data = i2c.tx_byte;
+    i2c.tx_full = false;  // Till skiftregistret: TXIF, ISR:en förladdar nästa
+  } else {
+    reg<I2C1CON1bits_t>(SIM_SFR_I2C1CON1).TXU = 1;
+    i2c.errors.tx_underrun++;
+  }
+  flags_dirty = true;
+  deliver_interrupts();
+  return data;
+}
+
+void i2c_stop() {
+  sync();
+  if (!i2c_enabled())
+    return;
+  i2c.read_phase = false;
+  reg<I2C1PIRbits_t>(SIM_SFR_I2C1PIR).PCIF = 1;
+  flags_dirty = true;
+  deliver_interrupts();
+}
+
+I2cErrors i2c_errors() { return i2c.errors; }
+
+void adc_set(uint8_t channel, uint16_t filtered) {
+  adc_sources[channel] = [filtered] { return filtered; };
+}
+
+void adc_source(uint8_t channel, std::function<uint16_t()> source) { adc_sources[channel] = std::move(source); }
+
+const Mcp4251 &digipot() { return pot; }
+
+uint8_t lat_c() { return byte(SIM_SFR_LATC); }
+
+const std::vector<uint8_t> &debug_output() { return debug_sink.bytes; }
+
+uint8_t *eeprom() { return eeprom_data.data(); }
+
+uint32_t eeprom_writes() { return eeprom_write_count; }
+
+}  // namespace sim
+
+// --- Firmwarens SFR-åtkomst (host/include/xc.h) ---
+
+extern "C" volatile void *sim_sfr_access(sim_sfr_id_t id) {
+  using namespace sim;
+  sync();
+
+  // Busy-wait på en flagga: låt tiden gå så att den kan ändras
+  if (id == last_access) {
+    if (++same_access >= SPIN_LIMIT) {
+      same_access = 0;
+      if (events.empty())
+        fatal("busy-wait utan händelser på", SFR_NAMES[id]);
+      run_next_event();
+      sync();
+    }
+  } else {
+    last_access = id;
+    same_access = 0;
+  }
+
+  switch (id) {
+    case SIM_SFR_U1RXB:
+    case SIM_SFR_U2RXB:
+    case SIM_SFR_U4RXB: {
+      Uart &u = uarts[id == SIM_SFR_U1RXB ? 0 : id == SIM_SFR_U2RXB ? 1 : 3];
+      if (!u.rx.empty()) {
+        sfr[id] = u.rx.front().first;
+        u.rx.pop_front();
+        flags_dirty = true;
+      }
+      break;
+    }
+    case SIM_SFR_I2C1RXB:
+      sfr[id] = i2c.rx_byte;
+      i2c.rx_full = false;
+      flags_dirty = true;
+      break;
+    case SIM_SFR_TMR1:
+      sfr[id] = reg<T1CONbits_t>(SIM_SFR_T1CON).ON ? static_cast<uint16_t>(ticks_at(t_now, tmr1_hz())) : 0;
+      break;
+    case SIM_SFR_TMR3:
+      sfr[id] = tmr3_now();
+      break;
+    case SIM_SFR_SSP2BUF:
+      if (reg<SSP2STATbits_t>(SIM_SFR_SSP2STAT).BF) {
+        reg<SSP2STATbits_t>(SIM_SFR_SSP2STAT).BF = 0;  // Läsning av mottagen byte
+        return &sfr[id];
+      }
+      break;
+    default:
+      break;
+  }
+
+  if (watched(id))
+    touched.push_back(Touched{id, sfr[id]});
+  if (flags_dirty)
+    update_flags();
+  return &sfr[id];
+}
+
+extern "C" void sim_sleep(void) {
+  using namespace sim;
+  if (!in_firmware)
+    fatal("SLEEP() utanför firmwarefibern");
+  if (swapcontext(&firmware_context, &harness_context) != 0)
+    fatal("swapcontext misslyckades");
+}
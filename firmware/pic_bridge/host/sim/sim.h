@@ -0,0 +1,142 @@
+// Simulerad PIC18F47Q43 för värdbygget: SFR-lagring, virtuell klocka,
+// avbrottsleverans och kringenheter (I2C1-slav, UART1-4, TMR0-3, ADCC, SPI2 + MCP4251,
+// data-EEPROM).
+//
+// Firmwaren kör i en egen fiber (ucontext). Varje SLEEP() i schemaläggaren lämnar
+// tillbaka till simulatorn, som flyttar fram den virtuella klockan till nästa
+// händelse, kör ISR:erna och sedan nästa varv. Firmwarekod tar ingen virtuell tid:
+// ISR:er och varv sker vid händelsetidpunkterna. Värdtiden mäts separat (bench/).
+
+#ifndef HOST_SIM_H
+#define HOST_SIM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace sim {
+
+using Time = uint64_t;  // ns sedan start
+
+const uint32_t FOSC = 64000000;
+
+Time now();
+Time us(uint64_t n);
+Time ms(uint64_t n);
+
+/**
+ * @brief Kör func vid tidpunkten at (virtuell tid). Händelser med samma tid körs i köordning.
+ */
+void schedule(Time at, std::function<void()> func);
+
+/**
+ * @brief Startar firmwaren (main i main.c) och kör den tills första SLEEP().
+ */
+void boot();
+
+/**
+ * @brief Kör simulatorn tills done() är sann eller timeout (virtuell tid) har gått.
+ * @return false vid timeout.
+ */
+bool run_until(const std::function<bool()> &done, Time timeout);
+
+/**
+ * @brief Kör simulatorn en viss virtuell tid.
+ */
+void run_for(Time duration);
+
+// --- UART ---
+
+// Motpart på en UART-lina (ESP:n, Modbus-mastern, 1-Wire-bussen, debugporten)
+class UartPeer {
+ public:
+  virtual ~UartPeer() = default;
+  virtual void on_byte(uint8_t data, uint32_t baud) = 0;
+};
+
+/**
+ * @brief Kopplar en motpart till UART n (1-4). Motparten tar emot allt PIC:en skickar.
+ */
+void uart_attach(int n, UartPeer *peer);
+
+/**
+ * @brief Kortsluter 1-Wire-bussen på UART4 mot jord (true) eller släpper den (false).
+ */
+void onewire_short(bool shorted);
+
+/**
+ * @brief Motparten skickar bytes i baud. De läggs efter det som redan är på väg.
+ * Avviker baud mer än 3 % från PIC:ens inställning kommer byten fram med ramfel.
+ */
+void uart_send(int n, const uint8_t *data, size_t length, uint32_t baud);
+
+/**
+ * @brief PIC:ens nuvarande baudrate på UART n (från UxBRG/BRGS).
+ */
+uint32_t uart_baud(int n);
+
+/**
+ * @brief Tid för en byte (10 bitar) i baud.
+ */
+Time uart_byte_time(uint32_t baud);
+
+// --- I2C1 (slav mot pumpen) ---
+// Anropas av en simulerad master (peers.h) vid rätt tidpunkt på bussen.
+// Varje steg levererar direkt de avbrott det ger upphov till.
+void i2c_start(bool restart);
+bool i2c_address(uint8_t addr7, bool read);  // false = NACK
+bool i2c_write(uint8_t data);
+uint8_t i2c_read();                          // Byten som låg i I2C1TXB
+void i2c_stop();
+
+struct I2cErrors {
+  uint32_t rx_overflow;  // Byte kom innan RXB lästs (RXO)
+  uint32_t tx_underrun;  // Läsning med tom TXB (TXU, klockan hade sträckts)
+};
+I2cErrors i2c_errors();
+
+// --- Analogt och SPI ---
+
+/**
+ * @brief ADFLTR-värdet en burst på kanalen ADPCH = channel ger.
+ */
+void adc_set(uint8_t channel, uint16_t filtered);
+
+/**
+ * @brief Som adc_set, men värdet hämtas från source när bursten blir klar
+ * (t.ex. en nod som följer digipotten, se bench/).
+ */
+void adc_source(uint8_t channel, std::function<uint16_t()> source);
+
+struct Mcp4251 {
+  uint16_t wiper[2];
+  uint32_t writes[2];
+};
+const Mcp4251 &digipot();
+
+// --- Data-EEPROM (NVMCON0/1, NVMLOCK) ---
+
+const size_t EEPROM_SIZE = 1024;
+
+/**
+ * @brief Data-EEPROM:ens innehåll (raderat = 0xFF). Fylls i före boot() för att simulera en varmstart.
+ */
+uint8_t *eeprom();
+
+/**
+ * @brief Antal byteskrivningar firmwaren gjort till data-EEPROM:en.
+ */
+uint32_t eeprom_writes();
+
+// Relä- och andra utgångar: LATx-värde
+uint8_t lat_c();
+
+/**
+ * @brief Bytes firmwaren skickat på UART3 (tokeniserad logg/bussfångst).
+ */
+const std::vector<uint8_t> &debug_output();
+
+}  // namespace sim
+
+#endif  // HOST_SIM_H
@@ -1,9 +1,13 @@
 #include "i2c.h"
 #include "globals.h"
+#include "regmap.h"
+#include "events.h"
+#include "capture.h"
+#include "perf.h"
 #include <xc.h>
-#include <stdio.h> 
 
 // Intern variabel för att hålla koll på vilket register master vill läsa/skriva till.
+// Vid läsning pekar den på byten som redan ligger förladdad i I2C1TXB.
 static volatile uint8_t register_index = 0;
 
 // Tillståndsvariabel för att hantera den flerstegade Master Write-sekvensen
@@ -11,174 +15,300 @@ typedef enum {
     STATE_WAITING_FOR_INDEX = 0,
     STATE_WAITING_FOR_SUB_COMMAND = 1,
     STATE_WAITING_FOR_TARGET_ADDR = 2,
-    STATE_WAITING_FOR_DATA_HI = 3,
-    STATE_WAITING_FOR_DATA_LO = 4
+    STATE_WAITING_FOR_DATA = 3,
+    STATE_WAITING_FOR_COMMAND_HI = 4,
+    STATE_WAITING_FOR_COMMAND_LO = 5
 } i2c_write_state_t;
 
-static i2c_write_state_t i2c_write_state = STATE_WAITING_FOR_INDEX;
+static volatile i2c_write_state_t i2c_write_state = STATE_WAITING_FOR_INDEX;
+
+// En Master Write pågår (registerMapSeq är udda) tills STOP
+static volatile bool write_open = false;
+
+// Byten i I2C1TXB kommer från Polling Hook och ska kvitteras när den skickats
+static volatile bool tx_hook_loaded = false;
+
+// Senast laddade byte i I2C1TXB, det är den pumpen läser när TXIF kommer (bussfångst)
+static volatile uint8_t tx_loaded = 0xFF;
 
 // Kommando-ID som Mastern skickar FÖRST (0xFE)
 #define COMMAND_ID_START 0xFE
 // Sub-kommando som Mastern skickar EFTER 0xFE (t.ex. 0x5D)
-#define COMMAND_ID_SUB   0x5D 
+#define COMMAND_ID_SUB   0x5D
+
+// TMR1 räknar fritt med Fosc/4 / 8 = 2 MHz (0.5 us) för mätning av klocksträckning
+#define STRETCH_TICKS_PER_US 2
 
 void I2C_Init(void) {
-    SSP1CON1bits.SSPEN = 0; 
-    SSP1CON1bits.SSPM = 0b0110; // I2C Slave, 7-bitars Adress med Start/Stop-avbrott
-    SSP1ADD = I2C_SLAVE_ADDR; 
-    
-    PIR1bits.SSP1IF = 0;   
-    PIE1bits.SSP1IE = 1;   
-    
-    SSP1CON1bits.SSPEN = 1; 
+    I2C1CON0bits.EN = 0;
+    I2C1CON0bits.MODE = 0b000;    // Slave, 7-bitars adress
+    I2C1CON1bits.CSD = 0;         // Klocksträckning tillåten (används bara om bufferten inte hunnit fyllas)
+    I2C1CON2bits.ABD = 0;         // Adressen läggs inte i RX-bufferten
+
+    // Samma adress i alla fyra adressregistren (7-bit i bit 7:1)
+    I2C1ADR0 = I2C_SLAVE_ADDR << 1;
+    I2C1ADR1 = I2C_SLAVE_ADDR << 1;
+    I2C1ADR2 = I2C_SLAVE_ADDR << 1;
+    I2C1ADR3 = I2C_SLAVE_ADDR << 1;
+
+    // Inga "hold"-avbrott (ADRIE/WRIE/ACKTIE) - då skulle varje byte sträcka klockan.
+    // START/RESTART laddar om sändbufferten, STOP avslutar registerMapSeq-skrivningen.
+    I2C1PIE = 0;
+    I2C1PIEbits.SCIE = 1;
+    I2C1PIEbits.RSCIE = 1;
+    I2C1PIEbits.PCIE = 1;
+    I2C1PIR = 0;
+
+    // TMR1: fri 16-bitars tidsbas för klocksträckningsmätningen
+    T1CLK = 0b00001;              // Fosc/4
+    T1CONbits.CKPS = 0b11;        // 1:8
+    T1CONbits.RD16 = 1;
+    T1CONbits.ON = 1;
+
+    IPR7bits.I2C1IP = 1;          // Hög prioritet
+    IPR7bits.I2C1RXIP = 1;
+    IPR7bits.I2C1TXIP = 1;
+    IPR7bits.I2C1EIP = 1;
+    PIE7bits.I2C1IE = 1;
+    PIE7bits.I2C1RXIE = 1;
+    PIE7bits.I2C1TXIE = 1;
+    PIE7bits.I2C1EIE = 1;
+
+    I2C1CON0bits.EN = 1;
 }
 
 /**
- * @brief Hanterar Master Write (Thermia Master skriver data till PIC:en/RegisterMap).
- * Denna funktion hanterar både standard loggning och specialkommandon (0xFE).
+ * @brief Nästa byte pumpen kommer att läsa (registerMap eller Polling Hook).
+ * Kommandot kvitteras först när byten faktiskt lämnat sändbufferten.
  */
-static void handle_master_write(uint8_t received_data) {
-    // Kontrollera I2C-status (REG_I2C_ENABLE_CONTROL == 0 disablar avbrott i ISR:en)
-    
-    // 1. Master skickar Register Index/Kommando (Adresseringsfas)
-    if (!SSP1STATbits.D_nA) {
-        
-        // Återställ state-maskinen vid ny transaktion
-        i2c_write_state = STATE_WAITING_FOR_INDEX; 
-
-        // Check: Är det COMMAND_ID_START (0xFE)?
-        if (received_data == COMMAND_ID_START) {
-            i2c_write_state = STATE_WAITING_FOR_SUB_COMMAND;
-            registerMap[REG_I2C_STATUS] = 0x03; // Debug: Entered CMD mode
-            return; // Vänta på nästa byte i ISR
-        }
-        
-        // Annars, standard Master Write (Loggning)
-        register_index = received_data;
-        i2c_write_state = STATE_WAITING_FOR_DATA_HI; // Gå till datafas
-    } 
-    // 2. Master skickar Data (Datafas, hanteras av tillståndsmaskinen)
-    else {
-        switch (i2c_write_state) {
-            case STATE_WAITING_FOR_INDEX: 
-                // Fallthrough till standardloggning nedan.
-            
-            case STATE_WAITING_FOR_DATA_HI:
-                // Standard loggning: Logga data och inkrementera pekaren
-                if (register_index < TOTAL_REGS) {
-                    registerMap[register_index] = received_data;
-                    register_index++;
-                }
-                break;
-
-            // --- Kommando-logik (Specialprotokoll, t.ex. Rumstemp börvärde) ---
-            
-            case STATE_WAITING_FOR_SUB_COMMAND:
-                // Expected: 0x5D
-                if (received_data == COMMAND_ID_SUB) {
-                    i2c_write_state = STATE_WAITING_FOR_TARGET_ADDR;
-                    registerMap[REG_I2C_STATUS] = 0x04; // Debug: Got Sub CMD
-                } else {
-                    i2c_write_state = STATE_WAITING_FOR_INDEX; // Avbryt
-                }
-                break;
-                
-            case STATE_WAITING_FOR_TARGET_ADDR:
-                // Nu kommer det register (0xB2/0x0F) som ska styras. Lagra det.
-                registerMap[REG_TARGET_COMMAND_ADDR] = received_data;
-                i2c_write_state = STATE_WAITING_FOR_DATA_HI;
-                registerMap[REG_I2C_STATUS] = 0x05; // Debug: Got Target ADDR
-                break;
-                
-            case STATE_WAITING_FOR_DATA_HI:
-                // Skriv HI byte av värdet till XIAO-målregistret
-                registerMap[REG_TARGET_COMMAND_VALUE_HI] = received_data;
-                i2c_write_state = STATE_WAITING_FOR_DATA_LO;
-                registerMap[REG_I2C_STATUS] = 0x06; // Debug: Got Data HI
-                break;
-                
-            case STATE_WAITING_FOR_DATA_LO:
-                // Skriv LO byte av värdet till XIAO-målregistret
-                registerMap[REG_TARGET_COMMAND_VALUE_LO] = received_data;
-                i2c_write_state = STATE_WAITING_FOR_INDEX; // Klart
-                registerMap[REG_I2C_STATUS] = 0x07; // Debug: CMD Complete
-                break;
+static uint8_t next_read_byte(void) {
+    tx_hook_loaded = false;
+
+    // Läs önskad Polling Address från XIAO:s kontrollregister (REG_TARGET_COMMAND_ADDR)
+    uint8_t polling_address = registerMap[REG_TARGET_COMMAND_ADDR];
+
+    // 1. Polling Hook Check
+    if (registerMap[REG_I2C_STATUS] != 0x00) { // Undvik overhead om inga kommandon väntar
+
+        // Om Mastern läser från det register XIAO pekat ut som Polling Address (t.ex. 0xFE)...
+        // ... OCH XIAO har laddat ett kommando i REG_TARGET_COMMAND_VALUE_LO ...
+        if (register_index == polling_address && registerMap[REG_TARGET_COMMAND_VALUE_LO] != 0x00) {
+            // Svara med den Kommando-byte som XIAO vill skicka
+            tx_hook_loaded = true;
+            return registerMap[REG_TARGET_COMMAND_VALUE_LO]; // Använd LO-byten som kommando
         }
     }
-    
-    // Fortsätt klocka data / bekräfta mottagande (ACK)
-    SSP1CON1bits.CKP = 1;
+
+    // 2. Standard Memory Mirror
+    return registerMap[register_index];
 }
 
+// Ersätter innehållet i sändbufferten med byten för aktuellt register_index.
+// Nästa läsning hittar då data på plats och pumpens klocka sträcks inte.
+static void prefetch_reload(void) {
+    I2C1STAT1bits.CLRBF = 1; // Tömmer både RX och TX (RX är redan läst)
+    tx_loaded = next_read_byte();
+    I2C1TXB = tx_loaded;
+}
+
+/**
+ * @brief Hanterar Master Write (Thermia Master skriver data till PIC:en/RegisterMap).
+ * Första byten efter adressen är registerindex eller COMMAND_ID_START (0xFE).
+ */
+static void handle_master_write(uint8_t received_data) {
+    switch (i2c_write_state) {
+        case STATE_WAITING_FOR_INDEX:
+            // Läsare i huvudloopen väntar tills transaktionen avslutats med STOP
+            if (!write_open) {
+                write_open = true;
+                REGMAP_ISR_WRITE_BEGIN();
+            }
+
+            // Check: Är det COMMAND_ID_START (0xFE)?
+            if (received_data == COMMAND_ID_START) {
+                i2c_write_state = STATE_WAITING_FOR_SUB_COMMAND;
+                registerMap[REG_I2C_STATUS] = 0x03; // Debug: Entered CMD mode
+                return;
+            }
+
+            // Annars, standard Master Write (Loggning)
+            register_index = received_data;
+            i2c_write_state = STATE_WAITING_FOR_DATA;
+            break;
+
+        case STATE_WAITING_FOR_DATA:
+            // Standard loggning: Logga data och inkrementera pekaren (slår runt vid 255)
+            if (registerMap[register_index] != received_data) {
+                registerMap[register_index] = received_data;
+                EVENTS_Record(register_index, received_data);
+            }
+            register_index++;
+            break;
+
+        // --- Kommando-logik (Specialprotokoll, t.ex. Rumstemp börvärde) ---
+
+        case STATE_WAITING_FOR_SUB_COMMAND:
+            // Expected: 0x5D
+            if (received_data == COMMAND_ID_SUB) {
+                i2c_write_state = STATE_WAITING_FOR_TARGET_ADDR;
+                registerMap[REG_I2C_STATUS] = 0x04; // Debug: Got Sub CMD
+            } else {
+                i2c_write_state = STATE_WAITING_FOR_INDEX; // Avbryt
+            }
+            break;
+
+        case STATE_WAITING_FOR_TARGET_ADDR:
+            // Nu kommer det register (0xB2/0x0F) som ska styras. Lagra det.
+            registerMap[REG_TARGET_COMMAND_ADDR] = received_data;
+            EVENTS_Record(REG_TARGET_COMMAND_ADDR, received_data);
+            i2c_write_state = STATE_WAITING_FOR_COMMAND_HI;
+            registerMap[REG_I2C_STATUS] = 0x05; // Debug: Got Target ADDR
+            break;
+
+        case STATE_WAITING_FOR_COMMAND_HI:
+            // Skriv HI byte av värdet till XIAO-målregistret
+            registerMap[REG_TARGET_COMMAND_VALUE_HI] = received_data;
+            EVENTS_Record(REG_TARGET_COMMAND_VALUE_HI, received_data);
+            i2c_write_state = STATE_WAITING_FOR_COMMAND_LO;
+            registerMap[REG_I2C_STATUS] = 0x06; // Debug: Got Data HI
+            break;
+
+        case STATE_WAITING_FOR_COMMAND_LO:
+            // Skriv LO byte av värdet till XIAO-målregistret
+            registerMap[REG_TARGET_COMMAND_VALUE_LO] = received_data;
+            EVENTS_Record(REG_TARGET_COMMAND_VALUE_LO, received_data);
+            i2c_write_state = STATE_WAITING_FOR_INDEX; // Klart
+            registerMap[REG_I2C_STATUS] = 0x07; // Debug: CMD Complete
+            break;
+    }
+
+    // Pekaren kan ha flyttats: förladda byten för en efterföljande läsning
+    prefetch_reload();
+}
 
 /**
- * @brief Hanterar Master Read (Thermia Master läser data från PIC:en/RegisterMap).
- * Använder en konfigurerbar Polling Hook för att simulera protokollhandskakning.
+ * @brief Hanterar Master Read: byten i I2C1TXB har flyttats till skiftregistret.
+ * Förladdar direkt nästa byte så att den ligger klar innan mastern klockar den.
  */
 static void handle_master_read(void) {
-    uint8_t data_to_send;
-    
-    // Läs önskad Polling Address från XIAO:s kontrollregister (242)
-    uint8_t polling_address = registerMap[REG_TARGET_COMMAND_ADDR];
-    
-    // 1. Polling Hook Check
-    if (registerMap[REG_I2C_STATUS] != 0x00) { // Undvik overhead om inga kommandon väntar
-        
-        // Om Mastern läser från det register XIAO pekat ut som Polling Address (t.ex. 0xFE)...
-        // ... OCH XIAO har laddat ett kommando i REG_I2C_COMMAND_RESPONSE (241)...
-        if (register_index == polling_address && registerMap[REG_TARGET_COMMAND_VALUE_LO] != 0x00) {
-            
-            // Svara med den Kommando-byte som XIAO vill skicka
-            data_to_send = registerMap[REG_TARGET_COMMAND_VALUE_LO]; // Använd LO-byten som kommando
-            
-            // Återställ kommandot efter att det skickats
-            registerMap[REG_TARGET_COMMAND_VALUE_LO] = 0x00; 
-            
-            // Logga att Pollingen lyckades (för debug)
-            registerMap[REG_I2C_STATUS] = 0x02; 
-            
-        } 
+    if (tx_hook_loaded) {
+        // Återställ kommandot efter att det skickats
+        registerMap[REG_TARGET_COMMAND_VALUE_LO] = 0x00;
+        // Logga att Pollingen lyckades (för debug)
+        registerMap[REG_I2C_STATUS] = 0x02;
     }
-    
-    // 2. Standard Memory Mirror (eller fallback efter hook)
-    data_to_send = registerMap[register_index];
-    
-    // Ladda data i bufferten
-    SSP1BUF = data_to_send;
-    
-    // Inkrementera pekaren för nästa byte
+
     register_index++;
-    if (register_index >= TOTAL_REGS) register_index = TOTAL_REGS - 1;
-    
-    // Fortsätt klocka ut data
-    SSP1CON1bits.CKP = 1;
+    tx_loaded = next_read_byte();
+    I2C1TXB = tx_loaded;
 }
 
-bool I2C_Slave_ISR_Handler(void) {
-    // Kontrollera om I2C är aktiverat
-    if (registerMap[REG_I2C_ENABLE_CONTROL] == 0) {
-        return false; // I2C avstängd via Modbus
+// Sparar största uppmätta klocksträckning (us) i registerMap. XIAO nollställer genom att skriva 0.
+static void record_stretch(uint16_t start_ticks) {
+    uint16_t us = (uint16_t)(TMR1 - start_ticks) / STRETCH_TICKS_PER_US;
+    uint16_t max_us = (uint16_t)((registerMap[REG_I2C_STRETCH_MAX_US_HI] << 8)
+                                 | registerMap[REG_I2C_STRETCH_MAX_US_LO]);
+    if (us > max_us) {
+        registerMap[REG_I2C_STRETCH_MAX_US_HI] = (uint8_t)(us >> 8);
+        registerMap[REG_I2C_STRETCH_MAX_US_LO] = (uint8_t)(us & 0xFF);
+        REGMAP_ISR_TOUCH();
     }
+}
 
-    if (PIE1bits.SSP1IE && PIR1bits.SSP1IF) {
-        
-        SSP1CON1bits.WCOL = 0; 
-        SSP1CON1bits.SSPOV = 0; 
+bool I2C_Slave_ISR_Handler(void) {
+    bool handled = false;
+    uint16_t entry_ticks = TMR1;
+    bool stretching = I2C1CON0bits.CSTR;
+    bool enabled = (registerMap[REG_I2C_ENABLE_CONTROL] != 0);
 
-        uint8_t buffer_data = SSP1BUF; 
+    // 1. Mottagen byte (Slave Receive)
+    if (PIE7bits.I2C1RXIE && PIR7bits.I2C1RXIF) {
+        uint8_t buffer_data = I2C1RXB; // Läsningen nollställer RXIF
+        CAPTURE_Record(enabled ? CAPTURE_HDR(CAPTURE_WRITE, 0)
+                               : CAPTURE_HDR(CAPTURE_WRITE, CAPTURE_FLAG_IGNORED), buffer_data);
+        if (enabled) {
+            handle_master_write(buffer_data);
+        } else {
+            prefetch_reload(); // I2C avstängd via Modbus: data kastas
+        }
+        handled = true;
+    }
 
-        if (SSP1STATbits.R_nW) {
-            // Master vill LÄSA (Slave Transmit)
+    // 2. Sändbufferten tömd (Slave Transmit)
+    if (PIE7bits.I2C1TXIE && PIR7bits.I2C1TXIF) {
+        // Byten som just gick till skiftregistret är den pumpen läser nu
+        CAPTURE_Record(enabled ? CAPTURE_HDR(CAPTURE_READ, 0)
+                               : CAPTURE_HDR(CAPTURE_READ, CAPTURE_FLAG_IGNORED), tx_loaded);
+        if (enabled) {
             handle_master_read();
-
         } else {
-            // Master vill SKRIVA (Slave Receive)
-            handle_master_write(buffer_data);
+            tx_loaded = 0xFF;
+            I2C1TXB = tx_loaded;
         }
+        handled = true;
+    }
 
-        PIR1bits.SSP1IF = 0;    
-        
-        return true;
+    // 3. START/RESTART/STOP
+    if (PIE7bits.I2C1IE && PIR7bits.I2C1IF) {
+        if (I2C1PIRbits.SCIF || I2C1PIRbits.RSCIF) {
+            // Ny transaktion: färsk förladdad byte och index-fas för en eventuell skrivning
+            CAPTURE_RecordStart(I2C1PIRbits.RSCIF);
+            I2C1PIRbits.SCIF = 0;
+            I2C1PIRbits.RSCIF = 0;
+            i2c_write_state = STATE_WAITING_FOR_INDEX;
+            prefetch_reload();
+        }
+        if (I2C1PIRbits.PCIF) {
+            I2C1PIRbits.PCIF = 0;
+            CAPTURE_Record(CAPTURE_HDR(CAPTURE_STOP, 0), 0);
+            if (write_open) {
+                write_open = false;
+                REGMAP_ISR_WRITE_END();
+            }
+        }
+        handled = true;
+    }
+
+    // 4. Bussfel (kollision, timeout, NACK): nollställ och börja om vid nästa START
+    if (PIE7bits.I2C1EIE && PIR7bits.I2C1EIF) {
+        CAPTURE_Record(CAPTURE_HDR(CAPTURE_ERROR, 0), I2C1ERR & 0x70);
+        if (I2C1ERRbits.BCLIF) {
+            PERF_CountI2CError();
+        }
+        I2C1ERR &= 0x8F; // BCLIF, BTOIF, NACKIF (bit 6:4) nollställs, enable-bitarna behålls
+        i2c_write_state = STATE_WAITING_FOR_INDEX;
+        // Ingen STOP kommer efter en avbruten skrivning: stäng seqlock-fönstret här
+        if (write_open) {
+            write_open = false;
+            REGMAP_ISR_WRITE_END();
+        }
+        handled = true;
     }
-    return false;
+
+    // Mottagningsbufferten skrevs över / sändbufferten var tom när mastern klockade
+    // (motsvarar MSSP:s SSPOV/WCOL). Ska inte hända med klocksträckning på.
+    if (I2C1CON1bits.RXO || I2C1CON1bits.TXU) {
+        I2C1CON1bits.RXO = 0;
+        I2C1CON1bits.TXU = 0;
+        PERF_CountI2CError();
+    }
+
+    if (stretching && handled) {
+        I2C1CON0bits.CSTR = 0; // Släpp klockan
+        record_stretch(entry_ticks);
+    }
+    return handled;
+}
+
+void I2C_Hold(void) {
+    PIE7bits.I2C1RXIE = 0;
+    PIE7bits.I2C1TXIE = 0;
+    PIE7bits.I2C1IE = 0;
+}
+
+void I2C_Release(void) {
+    // En väntande flagga tas om hand direkt
+    PIE7bits.I2C1IE = 1;
+    PIE7bits.I2C1TXIE = 1;
+    PIE7bits.I2C1RXIE = 1;
 }
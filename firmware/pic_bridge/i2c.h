@@ -5,8 +5,9 @@
 #include <stdbool.h>
 
 /**
- * @brief Initierar MSSP1-modulen som I2C Slave.
- * Konfigurerar adress, avbrott och driftläge.
+ * @brief Initierar Q43:ans I2C1-modul som I2C Slave.
+ * Konfigurerar adress, avbrott och driftläge. Nästa byte för Master Read
+ * ligger alltid förladdad i I2C1TXB så att pumpens klocka inte sträcks.
  */
 void I2C_Init(void);
 
@@ -18,4 +19,11 @@ void I2C_Init(void);
  */
 bool I2C_Slave_ISR_Handler(void);
 
+/**
+ * @brief Håller I2C-avbrottet under en kort flerbytesskrivning från huvudloopen.
+ * Pumpens klocka sträcks av hårdvaran tills I2C_Release() anropas. Används av regmap.c.
+ */
+void I2C_Hold(void);
+void I2C_Release(void);
+
 #endif // I2C_H
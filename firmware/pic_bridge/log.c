@@ -0,0 +1,79 @@
+#include "log.h"
+#include "globals.h"
+#include "scheduler.h"
+#include "capture.h"
+#include <xc.h>
+
+#define LOG_MASK (LOG_BUFFER_SIZE - 1)
+#define LOG_FRAME_OVERHEAD 5 // Sync, ID, antal, tid LO/HI
+
+// Head skrivs av huvudloopen, tail av UART3-ISR:en (samma mönster som UART2)
+static volatile uint8_t buffer[LOG_BUFFER_SIZE];
+static volatile uint8_t head = 0;
+static volatile uint8_t tail = 0;
+
+static uint8_t dropped = 0; // Sedan senaste LOG_DROPPED
+
+void LOG_Init(void) {
+    head = 0;
+    tail = 0;
+    dropped = 0;
+}
+
+static uint8_t log_free(void) {
+    // En plats hålls alltid tom för att skilja full från tom buffert
+    return (uint8_t)(LOG_MASK - ((uint8_t)(head - tail) & LOG_MASK));
+}
+
+static void log_put(uint8_t data) {
+    buffer[head] = data;
+    head = (uint8_t)((head + 1) & LOG_MASK);
+}
+
+static void log_put_word(uint16_t value) {
+    log_put((uint8_t)(value & 0xFF));
+    log_put((uint8_t)(value >> 8));
+}
+
+static void log_frame(uint8_t id, uint8_t argc, const int16_t *args) {
+    log_put(LOG_SYNC);
+    log_put(id);
+    log_put(argc);
+    log_put_word(SCHEDULER_Millis());
+    for (uint8_t i = 0; i < argc; i++) {
+        log_put_word((uint16_t)args[i]);
+    }
+}
+
+void LOG_Event(uint8_t id, uint8_t argc, int16_t a0, int16_t a1, int16_t a2) {
+    int16_t args[LOG_MAX_ARGS] = { a0, a1, a2 };
+    uint8_t needed = (uint8_t)(LOG_FRAME_OVERHEAD + 2 * argc);
+
+    if (CAPTURE_Active()) {
+        return; // UART3 strömmar bussfångst, loggen skulle förstöra den binära strömmen
+    }
+    if (dropped != 0) {
+        // Luckan rapporteras före nästa meddelande som får plats
+        if (log_free() < (uint8_t)(needed + LOG_FRAME_OVERHEAD + 2)) {
+            if (dropped != 0xFF) dropped++;
+            return;
+        }
+        int16_t count = dropped;
+        log_frame(LOG_DROPPED, 1, &count);
+        dropped = 0;
+    } else if (log_free() < needed) {
+        dropped = 1;
+        return;
+    }
+    log_frame(id, argc, args);
+    PIE9bits.U3TXIE = 1; // UART3-ISR:en tar över sändningen
+}
+
+bool LOG_TxNext(uint8_t *out) {
+    if (tail == head || CAPTURE_Active()) {
+        return false;
+    }
+    *out = buffer[tail];
+    tail = (uint8_t)((tail + 1) & LOG_MASK);
+    return true;
+}
@@ -0,0 +1,39 @@
+#ifndef LOG_H
+#define LOG_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "log_tokens.h"
+
+// --- Tokeniserad loggning på UART3 ---
+// Istället för printf köas ett meddelande-ID och heltalsargument i en ringbuffert
+// som UART3-avbrottet skickar. Blockerar aldrig; får bufferten inte plats kastas
+// meddelandet och ett LOG_DROPPED skickas när det finns plats igen.
+// Avkodas på värddatorn med tools/detokenize.py (formatsträngar i log_tokens.h).
+//
+// Ram: LOG_SYNC, ID, antal argument, tid LO, tid HI (SCHEDULER_Millis), argument (int16 LO/HI)
+#define LOG_SYNC        0xA5
+#define LOG_BUFFER_SIZE 128 // Måste vara en tvåpotens
+#define LOG_MAX_ARGS    3
+
+// Anropas endast från huvudloopen (en producent)
+#define LOG_0(id)          LOG_Event((id), 0, 0, 0, 0)
+#define LOG_1(id, a)       LOG_Event((id), 1, (int16_t)(a), 0, 0)
+#define LOG_2(id, a, b)    LOG_Event((id), 2, (int16_t)(a), (int16_t)(b), 0)
+#define LOG_3(id, a, b, c) LOG_Event((id), 3, (int16_t)(a), (int16_t)(b), (int16_t)(c))
+
+void LOG_Init(void);
+
+/**
+ * @brief Köar ett loggmeddelande. Använd makrona LOG_0..LOG_3.
+ * Medan bussfångsten (capture.c) använder UART3 kastas meddelandena.
+ */
+void LOG_Event(uint8_t id, uint8_t argc, int16_t a0, int16_t a1, int16_t a2);
+
+/**
+ * @brief Nästa byte att skicka. Anropas från UART3-ISR:en (debug.c).
+ * @return false om inget väntar.
+ */
+bool LOG_TxNext(uint8_t *out);
+
+#endif // LOG_H
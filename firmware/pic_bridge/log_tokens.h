@@ -0,0 +1,30 @@
+#ifndef LOG_TOKENS_H
+#define LOG_TOKENS_H
+
+// --- Loggmeddelanden (tokeniserade) ---
+// Formatsträngarna finns bara här och i värddatorns tools/detokenize.py, som läser
+// denna fil: ID = radens ordning. Lägg alltid till nya meddelanden SIST så att
+// gamla loggar fortfarande kan avkodas. Argumenten är int16 (%d, %u eller %x).
+//
+//  X(namn,                      argument, "format")
+#define LOG_TOKENS(X) \
+    X(LOG_STARTUP,                2, "Thermia Bridge v%d.%d - PIC18F47Q43 Startup") \
+    X(LOG_DROPPED,                1, "%u loggmeddelanden kastade (bufferten full)") \
+    X(LOG_ONEWIRE_SEARCH_DONE,    1, "OneWire: %d DS18B20 hittade") \
+    X(LOG_ONEWIRE_ROM_CRC_ERROR,  0, "OneWire: CRC-fel i ROM-kod vid sökning") \
+    X(LOG_ONEWIRE_TEMP,           2, "OneWire: givare %d = %d (C*100)") \
+    X(LOG_ONEWIRE_READ_CRC_ERROR, 1, "OneWire: CRC-fel i scratchpad, givare %d") \
+    X(LOG_LINK_BAUD,              1, "ESP-länk: baudkod %d") \
+    X(LOG_LINK_BAUD_FALLBACK,     0, "ESP-länk: ramfel efter baudbyte, tillbaka till 115200") \
+    X(LOG_NVM_RESTORED,           2, "NVM: styrregister återställda ur post %u (plats %d)") \
+    X(LOG_NVM_WRITE_ERROR,        1, "NVM: post på plats %d lästes inte tillbaka korrekt") \
+    X(LOG_ONEWIRE_BUS_SHORT,      0, "OneWire: bussen kortsluten mot jord")
+
+#define LOG_TOKEN_ID(name, argc, format) name,
+typedef enum {
+    LOG_TOKENS(LOG_TOKEN_ID)
+    LOG_TOKEN_COUNT
+} log_token_t;
+#undef LOG_TOKEN_ID
+
+#endif // LOG_TOKENS_H
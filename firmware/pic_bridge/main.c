@@ -6,18 +6,78 @@
 #include "onewire.h"
 #include "i2c.h"
 #include "adc.h"
+#include "uart2.h"
+#include "modbus_rtu.h"
+#include "scheduler.h"
+#include "events.h"
+#include "capture.h"
+#include "log.h"
+#include "perf.h"
+#include "nvm.h"
 
 // --- HÖG PRIORITETS ISR ---
 void __interrupt(high_priority) High_Priority_ISR(void) {
+    uint16_t entry_ticks = TMR1;
+
     // 1. Hantera I2C Slave-avbrott (Högt prioriterad/realtidskritisk)
     if (I2C_Slave_ISR_Handler()) {
         // Avbrottet hanterades av I2C-modulen
+        PERF_HighIsrDone(entry_ticks);
         return;
     }
     
-    // 2. Andra avbrott (T.ex. Timer, UART, etc.)
+    // 2. Latenssond (TMR3), mäter hur länge hög prioritet får vänta
+    if (PERF_ISR_Handler()) {
+        return;
+    }
 }
 
+// --- LÅG PRIORITETS ISR ---
+void __interrupt(low_priority) Low_Priority_ISR(void) {
+    // 1. UART2 (XIAO/ESP32) RX/TX-ringbuffertar
+    if (UART2_ISR_Handler()) {
+        return;
+    }
+
+    // 2. Systemtick (TMR0)
+    if (SCHEDULER_ISR_Handler()) {
+        return;
+    }
+
+    // 3. UART1 (RS485) Modbus RTU och T3.5-timern (TMR2)
+    if (MODBUS_RTU_ISR_Handler()) {
+        return;
+    }
+
+    // 4. UART4 (OneWire) bit-slot-motor
+    if (ONEWIRE_ISR_Handler()) {
+        return;
+    }
+
+    // 5. ADCC burst klar (NTC)
+    if (ADC_ISR_Handler()) {
+        return;
+    }
+
+    // 6. UART3 (Debug): bussfångst och tokeniserad logg
+    if (DEBUG_ISR_Handler()) {
+        return;
+    }
+}
+
+// --- SCHEMALÄGGNING ---
+// Varje task deklarerar sin period. MODBUS_Task körs varje varv eftersom den
+// drivs av UART-avbrott; huvudloopen vilar i Idle mellan varven.
+static scheduler_task_t tasks[] = {
+    { MODBUS_Task,     SCHEDULER_EVERY_PASS,   0, REG_PERF_TASK_MODBUS_MAX_US_HI },  // ESP32 (UART2) och RS485 (UART1)
+    { SPOOFER_Process, SPOOFER_TASK_PERIOD_MS, 0, REG_PERF_TASK_SPOOFER_MAX_US_HI }, // Reläer och Digipot
+    { ONEWIRE_Process, ONEWIRE_TASK_PERIOD_MS, 0, REG_PERF_TASK_ONEWIRE_MAX_US_HI }, // DS18B20
+    { ADC_Process,     ADC_TASK_PERIOD_MS,     0, REG_PERF_TASK_ADC_MAX_US_HI },     // Riktiga NTC-värden
+    { CAPTURE_Process, SCHEDULER_EVERY_PASS,   0, SCHEDULER_NO_PERF_REG },           // I2C-bussfångst till UART3
+    { PERF_Process,    PERF_TASK_PERIOD_MS,    0, SCHEDULER_NO_PERF_REG },           // Instrumentering (REG_PERF_*)
+    { NVM_Process,     NVM_TASK_PERIOD_MS,     0, SCHEDULER_NO_PERF_REG },           // Styrregistren till EEPROM
+};
+
 void main(void) {
     // Initiera System (Klocka, Pinnar, PPS)
     SYSTEM_Initialize();
@@ -25,32 +85,22 @@ void main(void) {
     
     // Initiera Moduler
     DEBUG_Init();
+    LOG_Init();
+    NVM_Init();     // Före SPOOFER_Init och I2C_Init: styrregistren återställs ur EEPROM
     MODBUS_Init();
     SPOOFER_Init();
     ONEWIRE_Init();
+    EVENTS_Init();
     I2C_Init();
+    CAPTURE_Init(); // Efter I2C_Init: tidtar mot TMR1
+    PERF_Init();
     ADC_Init();
+    SCHEDULER_Init();
     
-    printf("Thermia Bridge v1.0 - PIC18F47Q43 Startup\r\n");
+    LOG_2(LOG_STARTUP, FW_VERSION_MAJOR, FW_VERSION_MINOR);
     
-    // Huvudprogramloop
+    // Huvudprogramloop: Schemaläggaren kör det som är dags och vilar sedan
     while (1) {
-        
-        // Hantera Modbus-kommunikation med ESP32 (UART2) och RS485 (UART1)
-        MODBUS_Task();
-        
-        // Uppdatera reläer och Digipot baserat på registerMap
-        SPOOFER_Process();
-        
-        // Kör icke-blockerande OneWire-mätning
-        ONEWIRE_Process();
-        
-        // Kör icke-blockerande ADC-mätning (Real NTC values)
-        ADC_Process();
-        
-        // Här kan andra lågprioriterade uppgifter läggas till
-        
-        // Lägg till en liten fördröjning (för att undvika tight loop)
-        __delay_ms(1); 
+        SCHEDULER_RunPass(tasks, sizeof(tasks) / sizeof(tasks[0]));
     }
 }
@@ -0,0 +1,358 @@
+#include "modbus_rtu.h"
+#include "globals.h"
+#include "crc.h"
+#include "regmap.h"
+#include <xc.h>
+
+// DE/RE för RS485-transceivern (RC2, hög = sändning)
+#define RS485_DE_PIN LATCbits.LATC2
+
+// Max ADU-storlek enligt Modbus RTU (adress + PDU 253 + CRC 2)
+#define RTU_FRAME_SIZE 256
+// Max antal register per läsning (FC03/04) och skrivning (FC16)
+#define RTU_MAX_READ_REGS  125
+#define RTU_MAX_WRITE_REGS 123
+// FC23: Skrivdelen begränsas av att både läs- och skrivparametrar ryms i ramen
+#define RTU_MAX_RW_WRITE_REGS 121
+
+// rtu_process_pdu: pumpen skrev mitt i läsningen, ramen tolkas om nästa varv
+#define RTU_RETRY 0xFFFF
+
+// --- Ramtiming (T3.5) med TMR2 ---
+// TMR2 klockas från MFINTOSC 31.25 kHz => 32 us per steg.
+// Ett tecken är 11 bitar (8 data + start + stopp + paritet/stopp).
+// Över 19200 Baud föreskriver specen fasta 1750 us.
+#define RTU_TIMER_TICK_US 32UL
+#if MODBUS_RTU_BAUD > 19200UL
+#define RTU_T35_US 1750UL
+#else
+#define RTU_T35_US ((11UL * 1000000UL * 7UL) / (MODBUS_RTU_BAUD * 2UL))
+#endif
+#define RTU_T35_TICKS ((uint8_t)(RTU_T35_US / RTU_TIMER_TICK_US))
+
+typedef enum {
+    RTU_STATE_IDLE = 0,        // Tar emot (eller väntar på) en ram
+    RTU_STATE_FRAME_READY = 1, // T3.5 har löpt ut, ramen väntar på MODBUS_RTU_Task()
+    RTU_STATE_TRANSMITTING = 2 // Svar skickas, DE hög
+} rtu_state_t;
+
+// Gemensam buffert för mottagning och svar (halv duplex)
+static volatile uint8_t frame[RTU_FRAME_SIZE];
+static volatile uint16_t frame_len = 0;
+static volatile bool frame_overflow = false;
+static volatile uint8_t rx_overruns = 0;
+static volatile rtu_state_t rtu_state = RTU_STATE_IDLE;
+
+static volatile uint16_t tx_len = 0;
+static volatile uint16_t tx_pos = 0;
+
+void MODBUS_RTU_Init(void) {
+    // --- UART1 (RS485 External) - 9600 Baud @ 64MHz ---
+    // U1BRG = (64000000 / (16 * 9600)) - 1 = 416.6 -> 416
+    U1BRG = (uint16_t)((_XTAL_FREQ / (16UL * MODBUS_RTU_BAUD)) - 1);
+    U1CON0bits.TXEN = 1;
+    U1CON0bits.RXEN = 1;
+    U1CON1bits.ON = 1;
+
+    RS485_DE_PIN = 0; // Lyssna
+
+    // --- TMR2: One-shot T3.5-timer, startas om vid varje mottagen byte ---
+    T2CONbits.ON = 0;
+    T2CLKCONbits.CS = 0b0110; // MFINTOSC 31.25 kHz
+    T2CONbits.CKPS = 0;       // 1:1
+    T2CONbits.OUTPS = 0;      // 1:1
+    T2HLTbits.MODE = 0;       // Fri-löpande, mjukvarustyrd
+    T2PR = RTU_T35_TICKS;
+    T2TMR = 0;
+
+    // Låg prioritet (som UART2), I2C-slaven går först
+    IPR4bits.U1RXIP = 0;
+    IPR4bits.U1TXIP = 0;
+    IPR4bits.U1EIP = 0;
+    IPR3bits.TMR2IP = 0;
+
+    PIR3bits.TMR2IF = 0;
+    PIE3bits.TMR2IE = 1;
+    PIE4bits.U1RXIE = 1;
+    PIE4bits.U1TXIE = 0;
+    U1ERRIEbits.TXMTIE = 0;
+    PIE4bits.U1EIE = 1;
+}
+
+static void rtu_start_tx(uint16_t length) {
+    tx_len = length;
+    tx_pos = 0;
+    rtu_state = RTU_STATE_TRANSMITTING;
+    RS485_DE_PIN = 1;     // Driv bussen
+    PIE4bits.U1TXIE = 1;  // ISR:en fyller TX-FIFO:n
+}
+
+bool MODBUS_RTU_ISR_Handler(void) {
+    bool handled = false;
+
+    // 1. RX: Samla bytes till en ram och starta om T3.5-timern
+    if (PIE4bits.U1RXIE && PIR4bits.U1RXIF) {
+        while (!U1FIFObits.RXBE) {
+            uint8_t rx = U1RXB;
+            // Ignorera bytes medan en ram behandlas eller ett svar skickas
+            if (rtu_state == RTU_STATE_IDLE) {
+                if (frame_len < RTU_FRAME_SIZE) {
+                    frame[frame_len++] = rx;
+                } else {
+                    frame_overflow = true;
+                }
+                T2TMR = 0;
+                T2CONbits.ON = 1;
+            }
+        }
+        if (U1ERRIRbits.RXFOIF) {
+            U1ERRIRbits.RXFOIF = 0;
+            frame_overflow = true;
+            rx_overruns++;
+        }
+        handled = true;
+    }
+
+    // 2. T3.5 löpte ut: Ramen är komplett
+    if (PIE3bits.TMR2IE && PIR3bits.TMR2IF) {
+        PIR3bits.TMR2IF = 0;
+        T2CONbits.ON = 0;
+        if (rtu_state == RTU_STATE_IDLE && frame_len > 0) {
+            if (frame_overflow) {
+                frame_len = 0; // Kasta för lång ram
+                frame_overflow = false;
+            } else {
+                rtu_state = RTU_STATE_FRAME_READY;
+            }
+        }
+        handled = true;
+    }
+
+    // 3. TX: Fyll TX-FIFO:n från svarsbufferten
+    if (PIE4bits.U1TXIE && PIR4bits.U1TXIF) {
+        while (!U1FIFObits.TXBF && tx_pos < tx_len) {
+            U1TXB = frame[tx_pos++];
+        }
+        if (tx_pos >= tx_len) {
+            // Sista byten ligger i skiftregistret, vänta på TXMTIF innan DE släpps
+            PIE4bits.U1TXIE = 0;
+            U1ERRIEbits.TXMTIE = 1;
+        }
+        handled = true;
+    }
+
+    // 4. Skiftregistret tomt: Släpp bussen och lyssna igen
+    if (PIE4bits.U1EIE && PIR4bits.U1EIF) {
+        if (U1ERRIEbits.TXMTIE && U1ERRIRbits.TXMTIF) {
+            U1ERRIEbits.TXMTIE = 0;
+            RS485_DE_PIN = 0;
+            frame_len = 0;
+            rtu_state = RTU_STATE_IDLE;
+        }
+        handled = true;
+    }
+
+    return handled;
+}
+
+// --- Ordvyer av registerMap ---
+
+// Kontrollerar att [start, start + count) ligger helt inom en vy
+static bool rtu_range_valid(uint16_t start, uint16_t count) {
+    if (start >= MODBUS_RTU_BYTE_VIEW_BASE + TOTAL_REGS) {
+        return false;
+    }
+    uint16_t end = start + count; // Exklusiv
+    if (start < MODBUS_RTU_BYTE_VIEW_BASE) {
+        // Sista ordet i ordvyn (0xFF) skulle behöva registerMap[256]
+        return end <= (MODBUS_RTU_WORD_VIEW_BASE + TOTAL_REGS - 1);
+    }
+    return end <= (MODBUS_RTU_BYTE_VIEW_BASE + TOTAL_REGS);
+}
+
+// Som rtu_range_valid för en skrivning. Ord N och N+1 delar registerMap[N+1], så en
+// skrivning av flera ord i ordvyn skulle skriva över grannarnas bytes: den kräver bytevyn.
+static bool rtu_write_range_valid(uint16_t start, uint16_t count) {
+    if (start < MODBUS_RTU_BYTE_VIEW_BASE && count > 1) {
+        return false;
+    }
+    return rtu_range_valid(start, count);
+}
+
+// Konsekvent kopia av de bytes en läsning täcker (ordvyn behöver en extra byte)
+static uint8_t read_snapshot[RTU_MAX_READ_REGS + 1];
+static regmap_wait_t snapshot_wait;
+
+static regmap_copy_t rtu_take_snapshot(uint16_t start, uint16_t count) {
+    uint16_t bytes = (start >= MODBUS_RTU_BYTE_VIEW_BASE) ? count : count + 1;
+
+    return REGMAP_SnapshotWait(&snapshot_wait, (uint8_t)start, bytes, read_snapshot);
+}
+
+// Register i ögonblicksbilden, offset räknat från läsningens start
+static uint16_t rtu_read_register(uint16_t start, uint16_t offset) {
+    if (start >= MODBUS_RTU_BYTE_VIEW_BASE) {
+        return read_snapshot[offset];
+    }
+    return (uint16_t)((read_snapshot[offset] << 8) | read_snapshot[offset + 1]);
+}
+
+// Skriver count register till svarsbufferten från position pos. Returnerar ny position,
+// RTU_RETRY (utan att röra ramen) om ögonblicksbilden inte var konsekvent ännu, eller
+// 0 med MB_EX_SLAVE_BUSY om pumpen skrev under hela REGMAP_SNAPSHOT_TIMEOUT_MS.
+static uint16_t rtu_put_registers(uint16_t pos, uint16_t start, uint16_t count, uint8_t *exception) {
+    regmap_copy_t copy = rtu_take_snapshot(start, count);
+    if (copy == REGMAP_COPY_RETRY) {
+        return RTU_RETRY;
+    }
+    if (copy == REGMAP_COPY_TIMEOUT) {
+        *exception = MB_EX_SLAVE_BUSY;
+        return 0;
+    }
+    frame[pos++] = (uint8_t)(count * 2);
+    for (uint16_t i = 0; i < count; i++) {
+        uint16_t value = rtu_read_register(start, i);
+        frame[pos++] = (uint8_t)(value >> 8);
+        frame[pos++] = (uint8_t)(value & 0xFF);
+    }
+    return pos;
+}
+
+static uint16_t rtu_get_word(uint16_t pos) {
+    return (uint16_t)((frame[pos] << 8) | frame[pos + 1]);
+}
+
+// Ett register i bytevyn är en byte: värden över 0xFF avvisas i stället för att kapas
+static bool rtu_write_values_valid(uint16_t pos, uint16_t start, uint16_t count) {
+    if (start < MODBUS_RTU_BYTE_VIEW_BASE) {
+        return true;
+    }
+    for (uint16_t i = 0; i < count; i++) {
+        if (frame[pos + i * 2] != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Bytevyns värden samlade för REGMAP_WriteBlock (ramen ska vara orörd om FC23 tolkas om)
+static uint8_t write_bytes[RTU_MAX_WRITE_REGS];
+
+// Skriver med I2C-avbrottet hållet, så att pumpen aldrig ser ett halvskrivet HI/LO-par.
+// Ordvyn skriver alltid ett ord (rtu_write_range_valid).
+static void rtu_get_registers(uint16_t pos, uint16_t start, uint16_t count) {
+    if (start < MODBUS_RTU_BYTE_VIEW_BASE) {
+        REGMAP_WriteWord((uint8_t)start, rtu_get_word(pos));
+        return;
+    }
+    for (uint16_t i = 0; i < count; i++) {
+        write_bytes[i] = frame[pos + i * 2 + 1];
+    }
+    REGMAP_WriteBlock((uint8_t)start, write_bytes, count);
+}
+
+/**
+ * @brief Tolkar PDU:n i frame[1..] och bygger svaret på samma plats.
+ * @param length Ramens längd inklusive slavadress och CRC.
+ * @return Svarslängd inklusive slavadress men utan CRC, eller 0 vid undantag
+ * (undantagskoden läggs då i *exception). RTU_RETRY om ramen ska tolkas om
+ * nästa varv; en FC23-skrivning görs då om, vilket ger samma resultat. Svarar
+ * FC23 med MB_EX_SLAVE_BUSY har skrivningen ändå gjorts.
+ */
+static uint16_t rtu_process_pdu(uint16_t length, uint8_t *exception) {
+    uint8_t function = frame[1];
+    uint16_t start, count, wr_start, wr_count;
+
+    switch (function) {
+        case MB_FC_READ_HOLDING:
+        case MB_FC_READ_INPUT:
+            // Båda funktionerna läser samma ordvyer
+            if (length != 8) { *exception = MB_EX_ILLEGAL_VALUE; return 0; }
+            start = rtu_get_word(2);
+            count = rtu_get_word(4);
+            if (count == 0 || count > RTU_MAX_READ_REGS) { *exception = MB_EX_ILLEGAL_VALUE; return 0; }
+            if (!rtu_range_valid(start, count)) { *exception = MB_EX_ILLEGAL_ADDRESS; return 0; }
+            return rtu_put_registers(2, start, count, exception);
+
+        case MB_FC_WRITE_SINGLE:
+            if (length != 8) { *exception = MB_EX_ILLEGAL_VALUE; return 0; }
+            start = rtu_get_word(2);
+            if (!rtu_range_valid(start, 1)) { *exception = MB_EX_ILLEGAL_ADDRESS; return 0; }
+            if (!rtu_write_values_valid(4, start, 1)) { *exception = MB_EX_ILLEGAL_VALUE; return 0; }
+            rtu_get_registers(4, start, 1);
+            return 6; // Eko av förfrågan
+
+        case MB_FC_WRITE_MULTIPLE:
+            start = rtu_get_word(2);
+            count = rtu_get_word(4);
+            if (count == 0 || count > RTU_MAX_WRITE_REGS || frame[6] != count * 2
+                || length != 9 + count * 2) { *exception = MB_EX_ILLEGAL_VALUE; return 0; }
+            if (!rtu_write_range_valid(start, count)) { *exception = MB_EX_ILLEGAL_ADDRESS; return 0; }
+            if (!rtu_write_values_valid(7, start, count)) { *exception = MB_EX_ILLEGAL_VALUE; return 0; }
+            rtu_get_registers(7, start, count);
+            return 6; // Adress + funktion + start + antal
+
+        case MB_FC_READ_WRITE_MULTI:
+            start = rtu_get_word(2);
+            count = rtu_get_word(4);
+            wr_start = rtu_get_word(6);
+            wr_count = rtu_get_word(8);
+            if (count == 0 || count > RTU_MAX_READ_REGS || wr_count == 0 || wr_count > RTU_MAX_RW_WRITE_REGS
+                || frame[10] != wr_count * 2 || length != 13 + wr_count * 2) { *exception = MB_EX_ILLEGAL_VALUE; return 0; }
+            if (!rtu_range_valid(start, count) || !rtu_write_range_valid(wr_start, wr_count)) { *exception = MB_EX_ILLEGAL_ADDRESS; return 0; }
+            if (!rtu_write_values_valid(11, wr_start, wr_count)) { *exception = MB_EX_ILLEGAL_VALUE; return 0; }
+            // Skrivning sker före läsning enligt specen
+            rtu_get_registers(11, wr_start, wr_count);
+            return rtu_put_registers(2, start, count, exception);
+
+        default:
+            *exception = MB_EX_ILLEGAL_FUNCTION;
+            return 0;
+    }
+}
+
+void MODBUS_RTU_Task(void) {
+    if (rtu_state != RTU_STATE_FRAME_READY) {
+        return;
+    }
+
+    uint16_t length = frame_len;
+    uint8_t address = frame[0];
+
+    // CRC över hela ramen inklusive CRC-fältet blir 0 för en korrekt ram
+    if (length < 4 || CRC16_Compute(frame, length) != 0
+        || (address != MODBUS_RTU_SLAVE_ID && address != 0)) {
+        frame_len = 0;
+        rtu_state = RTU_STATE_IDLE;
+        return;
+    }
+
+    uint8_t exception = 0;
+    uint16_t response_len = rtu_process_pdu(length, &exception);
+    if (response_len == RTU_RETRY) {
+        return; // Ramen ligger kvar (RTU_STATE_FRAME_READY)
+    }
+
+    // Broadcast (adress 0) besvaras aldrig
+    if (address == 0) {
+        frame_len = 0;
+        rtu_state = RTU_STATE_IDLE;
+        return;
+    }
+
+    if (response_len == 0) {
+        frame[1] |= 0x80;
+        frame[2] = exception;
+        response_len = 3;
+    }
+
+    uint16_t crc = CRC16_Compute(frame, response_len);
+    frame[response_len++] = (uint8_t)(crc & 0xFF); // LSB först
+    frame[response_len++] = (uint8_t)(crc >> 8);
+
+    rtu_start_tx(response_len);
+}
+
+uint8_t MODBUS_RTU_RxOverruns(void) {
+    return rx_overruns;
+}
@@ -0,0 +1,61 @@
+#ifndef MODBUS_RTU_H
+#define MODBUS_RTU_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Slav-ID på RS485-bussen (Matchar ESPHome-konfigurationen)
+#define MODBUS_RTU_SLAVE_ID 1
+#define MODBUS_RTU_BAUD     9600UL
+
+// --- Adressrymd (Ordvyer av registerMap) ---
+// 0x0000-0x00FF: Ordvy. Register N = (registerMap[N] << 8) | registerMap[N+1].
+//                Passar HI/LO-par, t.ex. 15 ord från 0x0000 ger hela temperaturblocket.
+// 0x0100-0x01FF: Bytevy. Register 0x100+N = registerMap[N] (0-255).
+//                För 1-bytes kontrollregister (t.ex. REG_I2C_ENABLE_CONTROL) så att
+//                en skrivning inte skriver över grannregistret. Värden över 0xFF
+//                avvisas med undantag 03 innan något skrivs.
+// Orden i ordvyn överlappar (ord N och N+1 delar registerMap[N+1]). FC06 skriver
+// ett ord, dvs. ett HI/LO-par. FC16/FC23 med fler än ett ord i ordvyn avvisas med
+// undantag 02; flera register i följd skrivs som bytes i bytevyn.
+#define MODBUS_RTU_WORD_VIEW_BASE 0x0000
+#define MODBUS_RTU_BYTE_VIEW_BASE 0x0100
+
+// Stödda funktionskoder
+#define MB_FC_READ_HOLDING      0x03
+#define MB_FC_READ_INPUT        0x04
+#define MB_FC_WRITE_SINGLE      0x06
+#define MB_FC_WRITE_MULTIPLE    0x10
+#define MB_FC_READ_WRITE_MULTI  0x17
+
+// Undantagskoder
+#define MB_EX_ILLEGAL_FUNCTION  0x01
+#define MB_EX_ILLEGAL_ADDRESS   0x02
+#define MB_EX_ILLEGAL_VALUE     0x03
+#define MB_EX_SLAVE_BUSY        0x06 // Pumpen skrev under hela läsningens tidsgräns (regmap.h)
+
+/**
+ * @brief Initierar UART1 (RS485) och TMR2 för 3.5-teckens ramtiming.
+ */
+void MODBUS_RTU_Init(void);
+
+/**
+ * @brief UART1/TMR2 Interrupt Service Routine Logic.
+ * Samlar mottagna bytes till en ram, avgör ramslut (T3.5) och styr DE (RC2) vid sändning.
+ * Den är designad att kallas från låg-prioritets-ISR i main.c.
+ * @return true om avbrottet hanterades, false annars.
+ */
+bool MODBUS_RTU_ISR_Handler(void);
+
+/**
+ * @brief Behandlar en färdig ram (CRC, adress, funktion) och köar svaret.
+ * Anropas från MODBUS_Task().
+ */
+void MODBUS_RTU_Task(void);
+
+/**
+ * @brief Antal gånger UART1:s HW-FIFO svämmat över (räknar runt).
+ */
+uint8_t MODBUS_RTU_RxOverruns(void);
+
+#endif // MODBUS_RTU_H
@@ -0,0 +1,185 @@
+// GENERERAD FIL - ändra inte för hand.
+// Skapad av tools/gen_ntc_table.py från kurvorna i spoofer.c.
+// Index = ADC-kod (0-1023, R_fix 10 kOhm mot VDD), värde = temperatur °C * 100.
+
+#include "ntc_table.h"
+
+// 150 Ohm NTC (REG_NTC_CURVE_SELECT = 1)
+const int16_t NTC_TABLE_150OHM[NTC_TABLE_SIZE] = {
+    -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000,
+    -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000,
+    -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000,
+    -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000,
+    -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000,
+    -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000,
+    -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000,
+    -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000,
+    -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000,
+    -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000,
+    -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000,
+    -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000,
+    -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000,
+    -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000,
+    -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000,
+    -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000,
+    -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000,
+    -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000,
+    -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000,
+    -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000,
+    -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000,
+    -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000,
+    -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000,
+    -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000,
+    -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000,
+    -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000,
+    -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000,
+    -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000,
+    -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000,
+    -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000,
+    -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000,
+    -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000,
+    -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000,
+    -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000,
+    -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000,
+    -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000,
+    -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000,
+    -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000,
+    -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000,
+    -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000,
+    -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000,
+    -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000,
+    -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000,
+    -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000,
+    -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000,
+    -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000,
+    -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000,
+    -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000,
+    -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000,
+    -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000,
+    -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000,
+    -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000,
+    -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000,
+    -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000,
+    -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000,
+    -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000,
+    -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000,
+    -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000,
+    -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000,
+    -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000,
+    -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000,
+    -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000,
+    -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000,
+    -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000,
+    -4000, -4000, -4000, -3996, -3985, -3975, -3964, -3954, -3943, -3933, -3922, -3912,
+    -3901, -3891, -3881, -3870, -3860, -3850, -3840, -3829, -3819, -3809, -3799, -3789,
+    -3779, -3769, -3759, -3749, -3739, -3729, -3719, -3709, -3699, -3689, -3679, -3670,
+    -3660, -3650, -3640, -3631, -3621, -3611, -3602, -3592, -3582, -3573, -3563, -3554,
+    -3544, -3535, -3525, -3516, -3507, -3496, -3483, -3470, -3458, -3445, -3432, -3420,
+    -3407, -3395, -3382, -3370, -3357, -3345, -3332, -3320, -3308, -3295, -3283, -3271,
+    -3258, -3246, -3234, -3222, -3210, -3198, -3186, -3174, -3162, -3150, -3138, -3126,
+    -3114, -3102, -3090, -3078, -3067, -3055, -3043, -3032, -3020, -3008, -2995, -2980,
+    -2964, -2948, -2933, -2917, -2902, -2886, -2871, -2856, -2840, -2825, -2810, -2795,
+    -2779, -2764, -2749, -2734, -2719, -2704, -2689, -2674, -2659, -2644, -2630, -2615,
+    -2600, -2585, -2571, -2556, -2541, -2527, -2512, -2496, -2477, -2458, -2438, -2419,
+    -2400, -2381, -2362, -2342, -2323, -2304, -2285, -2266, -2248, -2229, -2210, -2191,
+    -2172, -2154, -2135, -2116, -2098, -2079, -2061, -2042, -2024, -2006, -1983, -1958,
+    -1934, -1910, -1886, -1861, -1837, -1813, -1789, -1765, -1741, -1717, -1693, -1670,
+    -1646, -1622, -1599, -1575, -1551, -1528, -1505, -1475, -1444, -1414, -1383, -1353,
+    -1322, -1292, -1261, -1231, -1201, -1171, -1141, -1111, -1081, -1051, -1021, -989,
+    -950, -911, -872, -833, -795, -756, -718, -680, -641, -603, -565, -527,
+    -486, -437, -387, -338, -290, -241, -192, -143, -95, -46, 2, 65,
+    127, 189, 250, 312, 374, 435, 496, 574, 652, 730, 808, 886,
+    964, 1053, 1151, 1250, 1347, 1445, 1554, 1678, 1801, 1924, 2059, 2213,
+    2366, 2525, 2716, 2907, 3121, 3358, 3616, 3908, 4244, 4624, 5000, 5000,
+    5000, 5000, 5000, 5000
+};
+
+// 22 kOhm NTC (REG_NTC_CURVE_SELECT = 0)
+const int16_t NTC_TABLE_22KOHM[NTC_TABLE_SIZE] = {
+    -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000,
+    -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000,
+    -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000,
+    -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000,
+    -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000,
+    -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000,
+    -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000,
+    -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000,
+    -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000,
+    -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000,
+    -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000,
+    -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000,
+    -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000,
+    -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000,
+    -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000,
+    -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000,
+    -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000,
+    -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000,
+    -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000,
+    -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000,
+    -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000,
+    -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000,
+    -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000,
+    -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000,
+    -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000,
+    -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000,
+    -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000,
+    -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000,
+    -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000,
+    -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000,
+    -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000, -4000,
+    -4000, -4000, -4000, -4000, -4000, -4000, -3995, -3988, -3981, -3974, -3967, -3960,
+    -3954, -3947, -3940, -3934, -3927, -3920, -3914, -3907, -3901, -3894, -3888, -3881,
+    -3875, -3869, -3863, -3856, -3850, -3844, -3838, -3832, -3825, -3819, -3813, -3807,
+    -3801, -3795, -3789, -3783, -3778, -3772, -3766, -3760, -3754, -3749, -3743, -3737,
+    -3732, -3726, -3720, -3715, -3709, -3704, -3698, -3693, -3687, -3682, -3677, -3671,
+    -3666, -3661, -3655, -3650, -3645, -3640, -3634, -3629, -3624, -3619, -3614, -3609,
+    -3604, -3599, -3594, -3589, -3584, -3579, -3574, -3569, -3564, -3559, -3554, -3550,
+    -3545, -3540, -3535, -3531, -3526, -3521, -3516, -3512, -3507, -3503, -3497, -3490,
+    -3483, -3477, -3470, -3463, -3457, -3450, -3444, -3437, -3431, -3424, -3418, -3412,
+    -3405, -3399, -3393, -3386, -3380, -3374, -3368, -3361, -3355, -3349, -3343, -3337,
+    -3331, -3325, -3319, -3313, -3307, -3301, -3295, -3289, -3283, -3278, -3272, -3266,
+    -3260, -3254, -3249, -3243, -3237, -3232, -3226, -3220, -3215, -3209, -3204, -3198,
+    -3193, -3187, -3182, -3176, -3171, -3165, -3160, -3155, -3149, -3144, -3139, -3133,
+    -3128, -3123, -3118, -3113, -3107, -3102, -3097, -3092, -3087, -3082, -3077, -3072,
+    -3067, -3062, -3057, -3052, -3047, -3042, -3037, -3032, -3027, -3022, -3017, -3013,
+    -3008, -3003, -2997, -2991, -2984, -2977, -2971, -2964, -2958, -2951, -2945, -2938,
+    -2932, -2925, -2919, -2912, -2906, -2900, -2893, -2887, -2881, -2875, -2868, -2862,
+    -2856, -2850, -2844, -2838, -2832, -2825, -2819, -2813, -2807, -2801, -2795, -2789,
+    -2783, -2778, -2772, -2766, -2760, -2754, -2748, -2743, -2737, -2731, -2725, -2720,
+    -2714, -2708, -2702, -2697, -2691, -2686, -2680, -2674, -2669, -2663, -2658, -2652,
+    -2647, -2641, -2636, -2631, -2625, -2620, -2614, -2609, -2604, -2598, -2593, -2588,
+    -2583, -2577, -2572, -2567, -2562, -2556, -2551, -2546, -2541, -2536, -2531, -2526,
+    -2521, -2516, -2511, -2506, -2500, -2493, -2486, -2479, -2471, -2464, -2457, -2450,
+    -2442, -2435, -2428, -2421, -2414, -2407, -2400, -2393, -2386, -2379, -2372, -2365,
+    -2358, -2351, -2344, -2337, -2330, -2324, -2317, -2310, -2303, -2297, -2290, -2283,
+    -2276, -2270, -2263, -2256, -2250, -2243, -2237, -2230, -2224, -2217, -2211, -2204,
+    -2198, -2191, -2185, -2179, -2172, -2166, -2159, -2153, -2147, -2141, -2134, -2128,
+    -2122, -2116, -2109, -2103, -2097, -2091, -2085, -2079, -2073, -2067, -2061, -2055,
+    -2049, -2043, -2037, -2031, -2025, -2019, -2013, -2007, -2001, -1993, -1985, -1976,
+    -1968, -1960, -1952, -1943, -1935, -1927, -1919, -1911, -1903, -1895, -1887, -1879,
+    -1871, -1863, -1855, -1847, -1839, -1831, -1824, -1816, -1808, -1800, -1792, -1785,
+    -1777, -1769, -1762, -1754, -1746, -1739, -1731, -1723, -1716, -1708, -1701, -1693,
+    -1686, -1678, -1671, -1664, -1656, -1649, -1641, -1634, -1627, -1620, -1612, -1605,
+    -1598, -1590, -1583, -1576, -1569, -1562, -1555, -1548, -1540, -1533, -1526, -1519,
+    -1512, -1505, -1497, -1487, -1478, -1468, -1458, -1448, -1439, -1429, -1419, -1410,
+    -1400, -1390, -1381, -1371, -1362, -1352, -1343, -1333, -1324, -1315, -1305, -1296,
+    -1287, -1277, -1268, -1259, -1249, -1240, -1231, -1222, -1213, -1204, -1195, -1185,
+    -1176, -1167, -1158, -1149, -1140, -1131, -1123, -1114, -1105, -1096, -1087, -1078,
+    -1069, -1061, -1052, -1043, -1034, -1026, -1017, -1008, -999, -987, -975, -963,
+    -951, -939, -927, -915, -903, -891, -879, -867, -855, -843, -831, -820,
+    -808, -796, -784, -773, -761, -749, -738, -726, -715, -703, -692, -680,
+    -669, -657, -646, -635, -623, -612, -601, -589, -578, -567, -556, -545,
+    -533, -522, -511, -500, -485, -469, -454, -439, -423, -408, -393, -378,
+    -363, -348, -333, -318, -303, -288, -273, -258, -243, -228, -213, -199,
+    -184, -169, -155, -140, -125, -111, -96, -82, -67, -53, -39, -24,
+    -10, 6, 26, 46, 66, 85, 105, 124, 144, 163, 183, 202,
+    222, 241, 260, 280, 299, 318, 337, 356, 375, 394, 413, 432,
+    451, 470, 488, 510, 535, 560, 585, 610, 635, 660, 685, 710,
+    735, 760, 784, 809, 834, 858, 883, 907, 931, 956, 980, 1006,
+    1039, 1071, 1104, 1136, 1169, 1201, 1234, 1266, 1298, 1330, 1362, 1394,
+    1426, 1458, 1490, 1529, 1572, 1615, 1658, 1701, 1744, 1786, 1829, 1871,
+    1914, 1956, 1998, 2054, 2110, 2167, 2223, 2279, 2335, 2391, 2447, 2503,
+    2577, 2651, 2724, 2798, 2871, 2944, 3023, 3121, 3219, 3316, 3414, 3515,
+    3644, 3773, 3902, 4040, 4207, 4373, 4551, 4768, 4983, 5000, 5000, 5000,
+    5000, 5000, 5000, 5000
+};
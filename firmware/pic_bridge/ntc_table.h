@@ -0,0 +1,14 @@
+#ifndef NTC_TABLE_H
+#define NTC_TABLE_H
+
+#include <stdint.h>
+
+// En post per 10-bitars ADC-kod
+#define NTC_TABLE_SIZE 1024
+
+// Direkt uppslag ADC-kod -> temperatur (°C * 100), ligger i flash (const).
+// Genereras av tools/gen_ntc_table.py från kurvorna i spoofer.c, se ntc_table.c.
+extern const int16_t NTC_TABLE_150OHM[NTC_TABLE_SIZE];
+extern const int16_t NTC_TABLE_22KOHM[NTC_TABLE_SIZE];
+
+#endif // NTC_TABLE_H
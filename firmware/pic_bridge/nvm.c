@@ -0,0 +1,195 @@
+#include "nvm.h"
+#include "globals.h"
+#include "crc.h"
+#include "scheduler.h"
+#include "log.h"
+#include <string.h>
+
+// Registren som journalförs, i postens ordning
+static const uint8_t persisted_regs[NVM_DATA_LEN] = {
+    REG_TARGET_OUTDOOR_TEMP_HI, REG_TARGET_OUTDOOR_TEMP_LO,
+    REG_TARGET_INDOOR_TEMP_HI,  REG_TARGET_INDOOR_TEMP_LO,
+    REG_SPOOFING_ENABLED,
+    REG_RELAY_CONTROL,
+    REG_I2C_ENABLE_CONTROL
+};
+
+// NVMCON1.CMD
+#define NVM_CMD_READ    0b000
+#define NVM_CMD_WRITE   0b011 // Byte i data-EEPROM, raderas automatiskt före skrivningen
+
+typedef enum {
+    NVM_IDLE = 0,
+    NVM_WRITING = 1
+} nvm_state_t;
+
+static nvm_state_t state = NVM_IDLE;
+static uint8_t journaled[NVM_DATA_LEN]; // Innehållet i nyaste posten
+static uint8_t seen[NVM_DATA_LEN];      // Registren vid förra anropet
+static uint16_t changed_ms = 0;         // När registren senast ändrades
+static uint16_t sequence = 0;           // Löpnummer i nyaste posten
+static uint8_t next_slot = 0;           // Plats för nästa post (den äldsta)
+
+// Posten som skrivs, en byte per NVM_Process-anrop. CRC:n ligger sist och skrivs
+// sist, så en avbruten skrivning ger alltid en post som underkänns.
+static uint8_t record[NVM_RECORD_LEN];
+static uint8_t write_index = 0;
+
+static void nvm_set_address(uint16_t offset) {
+    uint32_t address = NVM_EEPROM_ADDR + offset;
+    NVMADRU = (uint8_t)(address >> 16);
+    NVMADRH = (uint8_t)(address >> 8);
+    NVMADRL = (uint8_t)(address & 0xFF);
+}
+
+static uint8_t nvm_read(uint16_t offset) {
+    nvm_set_address(offset);
+    NVMCON1bits.CMD = NVM_CMD_READ;
+    NVMCON0bits.GO = 1;
+    while (NVMCON0bits.GO); // Läsningen är klar efter en instruktionscykel
+    return NVMDATL;
+}
+
+// Startar en byteskrivning (några ms). Upplåsningssekvensen får inte avbrytas,
+// så alla avbrott hålls under de tre instruktionerna.
+static void nvm_write_start(uint16_t offset, uint8_t data) {
+    nvm_set_address(offset);
+    NVMDATL = data;
+    NVMCON1bits.CMD = NVM_CMD_WRITE;
+
+    INTCON0bits.GIE = 0;
+    NVMLOCK = 0x55;
+    NVMLOCK = 0xAA;
+    NVMCON0bits.GO = 1;
+    INTCON0bits.GIE = 1;
+}
+
+/**
+ * @brief Läser posten på en plats.
+ * @return true om CRC:n stämmer.
+ */
+static bool nvm_read_record(uint8_t slot, uint8_t *dest) {
+    uint16_t base = (uint16_t)slot * NVM_SLOT_SIZE;
+    uint16_t crc;
+    uint8_t i;
+
+    for (i = 0; i < NVM_RECORD_LEN; i++) {
+        dest[i] = nvm_read(base + i);
+    }
+    crc = CRC16_Compute(dest, NVM_RECORD_LEN - 2);
+    return dest[NVM_RECORD_LEN - 2] == (uint8_t)(crc & 0xFF)
+        && dest[NVM_RECORD_LEN - 1] == (uint8_t)(crc >> 8);
+}
+
+void NVM_Init(void) {
+    uint8_t buffer[NVM_RECORD_LEN];
+    uint8_t newest_slot = 0;
+    bool found = false;
+    uint8_t slot, i;
+
+    for (slot = 0; slot < NVM_SLOTS; slot++) {
+        if (!nvm_read_record(slot, buffer)) {
+            continue; // Tom, raderad eller avbruten post
+        }
+        uint16_t seq = (uint16_t)(buffer[0] | (buffer[1] << 8));
+        // Löpnumret slår runt; alla giltiga poster ligger inom NVM_SLOTS från varandra
+        if (!found || (int16_t)(seq - sequence) > 0) {
+            found = true;
+            sequence = seq;
+            newest_slot = slot;
+            memcpy(journaled, &buffer[2], NVM_DATA_LEN);
+        }
+    }
+
+    if (found) {
+        for (i = 0; i < NVM_DATA_LEN; i++) {
+            registerMap[persisted_regs[i]] = journaled[i];
+        }
+        next_slot = (uint8_t)((newest_slot + 1) % NVM_SLOTS);
+        registerMap[REG_NVM_STATUS] = NVM_STATUS_RESTORED;
+        LOG_2(LOG_NVM_RESTORED, sequence, newest_slot);
+    } else {
+        // Tom journal: första posten skrivs när något ändras från startvärdena
+        for (i = 0; i < NVM_DATA_LEN; i++) {
+            journaled[i] = registerMap[persisted_regs[i]];
+        }
+        sequence = 0;
+        next_slot = 0;
+        registerMap[REG_NVM_STATUS] = 0;
+    }
+
+    memcpy(seen, journaled, NVM_DATA_LEN);
+    changed_ms = 0;
+    state = NVM_IDLE;
+}
+
+// Posten ligger i EEPROM:en: läs tillbaka och godta den bara om allt stämmer
+static void nvm_finish_record(void) {
+    uint8_t check[NVM_RECORD_LEN];
+    bool ok = !NVMCON1bits.WRERR
+           && nvm_read_record(next_slot, check)
+           && memcmp(check, record, NVM_RECORD_LEN) == 0;
+
+    if (ok) {
+        sequence = (uint16_t)(record[0] | (record[1] << 8));
+        memcpy(journaled, &record[2], NVM_DATA_LEN);
+    } else {
+        NVMCON1bits.WRERR = 0;
+        registerMap[REG_NVM_STATUS] |= NVM_STATUS_WRITE_ERROR;
+        LOG_1(LOG_NVM_WRITE_ERROR, next_slot);
+    }
+    // Även efter ett fel: nästa försök görs på en annan plats
+    next_slot = (uint8_t)((next_slot + 1) % NVM_SLOTS);
+    state = NVM_IDLE;
+}
+
+void NVM_Process(void) {
+    bool pending = false;
+    uint16_t crc;
+    uint8_t i;
+
+    if (state == NVM_WRITING) {
+        if (NVMCON0bits.GO) {
+            return; // Förra byten skrivs fortfarande
+        }
+        if (write_index < NVM_RECORD_LEN) {
+            nvm_write_start((uint16_t)next_slot * NVM_SLOT_SIZE + write_index, record[write_index]);
+            write_index++;
+            return;
+        }
+        nvm_finish_record();
+        return;
+    }
+
+    // Registren skrivs av Modbus och ESP-länken i huvudloopen: varje ändring startar om väntan
+    for (i = 0; i < NVM_DATA_LEN; i++) {
+        uint8_t value = registerMap[persisted_regs[i]];
+        if (value != seen[i]) {
+            seen[i] = value;
+            changed_ms = SCHEDULER_Millis();
+        }
+        if (value != journaled[i]) {
+            pending = true;
+        }
+    }
+
+    if (!pending) {
+        registerMap[REG_NVM_STATUS] &= (uint8_t)~NVM_STATUS_PENDING;
+        return;
+    }
+    registerMap[REG_NVM_STATUS] |= NVM_STATUS_PENDING;
+    if ((uint16_t)(SCHEDULER_Millis() - changed_ms) < NVM_SETTLE_MS) {
+        return;
+    }
+
+    // Ny post med nästa löpnummer på den äldsta platsen
+    uint16_t seq = (uint16_t)(sequence + 1);
+    record[0] = (uint8_t)(seq & 0xFF);
+    record[1] = (uint8_t)(seq >> 8);
+    memcpy(&record[2], seen, NVM_DATA_LEN);
+    crc = CRC16_Compute(record, NVM_RECORD_LEN - 2);
+    record[NVM_RECORD_LEN - 2] = (uint8_t)(crc & 0xFF);
+    record[NVM_RECORD_LEN - 1] = (uint8_t)(crc >> 8);
+    write_index = 0;
+    state = NVM_WRITING;
+}
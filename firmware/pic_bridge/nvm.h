@@ -0,0 +1,48 @@
+#ifndef NVM_H
+#define NVM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// --- Journal för styrregistren i data-EEPROM ---
+// Spoofmål, spoofing på/av, reläer och I2C på/av sparas som poster i en ring av
+// platser i Q43:ans data-EEPROM (1 kB). Varje ny post skrivs på nästa plats, så
+// slitaget sprids över hela ringen. Posten bär ett löpnummer och avslutas med
+// CRC-16; en post som avbröts av ett strömavbrott underkänns och den förra gäller.
+// Vid start återställs den nyaste giltiga posten till registerMap innan
+// spoofern och I2C-slaven startar.
+
+#define NVM_EEPROM_ADDR     0x380000UL // Data-EEPROM i NVM-adressrymden
+#define NVM_EEPROM_SIZE     1024
+#define NVM_SLOT_SIZE       16
+#define NVM_SLOTS           (NVM_EEPROM_SIZE / NVM_SLOT_SIZE)
+
+// Post: löpnummer (LO, HI), registren i nvm.c:s ordning, CRC-16 (LO, HI)
+#define NVM_DATA_LEN        7
+#define NVM_RECORD_LEN      (2 + NVM_DATA_LEN + 2)
+
+// En ändring journalförs först när registren legat still så här länge,
+// så att en ramp av mål från XIAO blir en post och inte en per steg
+#define NVM_SETTLE_MS       5000
+
+// Schemaläggarens period för NVM_Process (en byte skrivs per anrop)
+#define NVM_TASK_PERIOD_MS  10
+
+// Bitar i REG_NVM_STATUS
+#define NVM_STATUS_RESTORED     0x01 // Styrregistren återställdes vid start
+#define NVM_STATUS_PENDING      0x02 // Ändring som ännu inte journalförts
+#define NVM_STATUS_WRITE_ERROR  0x04 // En post lästes inte tillbaka korrekt (sedan start)
+
+/**
+ * @brief Letar upp den nyaste giltiga posten och återställer styrregistren i registerMap.
+ * Anropas före SPOOFER_Init() och I2C_Init().
+ */
+void NVM_Init(void);
+
+/**
+ * @brief Journalför ändrade styrregister. Blockerar aldrig: väntar EEPROM:en på en
+ * pågående byteskrivning returnerar den direkt.
+ */
+void NVM_Process(void);
+
+#endif // NVM_H
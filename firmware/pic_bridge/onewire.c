@@ -1,137 +1,524 @@
 #include "onewire.h"
 #include "globals.h"
+#include "scheduler.h"
+#include "regmap.h"
+#include "log.h"
 #include <xc.h>
-#include <stdio.h>
 
 // DS18B20 Commands
+#define SEARCH_ROM 0xF0
+#define MATCH_ROM 0x55
 #define SKIP_ROM 0xCC
 #define CONVERT_T 0x44
+#define WRITE_SCRATCHPAD 0x4E
 #define READ_SCRATCHPAD 0xBE
 
+// Familjekod i ROM[0] (som DallasTemperature::validFamily() på RA4M1)
+#define DS18B20_FAMILY 0x28
+
 // Baudrates (@64MHz)
 // Reset Puls (480us) => 9600 Baud: U4BRG = 416
 #define BAUD_RESET 416
 // Bit Puls (60us) => 115200 Baud: U4BRG = 34
 #define BAUD_BITS  34
 
+// Största överföring: MATCH_ROM + ROM[8] + WRITE_SCRATCHPAD + TH + TL + CONFIG
+#define OW_BUFFER_SIZE 13
+#define OW_SCRATCHPAD_SIZE 9
+
+// TH/TL-larmgränser används inte, men skrivs alltid tillsammans med config-byten
+#define DS18B20_ALARM_TH 0x4B
+#define DS18B20_ALARM_TL 0x46
+
+// --- Bit-slot-motorn (drivs av UART4 RX-avbrottet) ---
+typedef enum {
+    OW_OP_IDLE = 0,
+    OW_OP_RESET,
+    OW_OP_WRITE,
+    OW_OP_READ,
+    OW_OP_TRIPLET
+} ow_op_t;
+
+static volatile ow_op_t ow_op = OW_OP_IDLE;
+static volatile uint8_t ow_buffer[OW_BUFFER_SIZE]; // Data att skriva / lästa bytes
+static volatile uint8_t ow_length;
+static volatile uint8_t ow_byte_index;
+static volatile uint8_t ow_bit_mask;
+static volatile bool ow_presence;
+static volatile bool ow_short; // Reset lästes tillbaka som 0x00: linan ligger låg
+
+// ROM-sökningens triplet: läs bit, läs komplement, skriv vald riktning
+static volatile uint8_t ow_triplet_step;
+static volatile uint8_t ow_triplet_id;
+static volatile uint8_t ow_triplet_cmp;
+static volatile uint8_t ow_triplet_dir; // Önskad riktning vid konflikt in, vald riktning ut
+
+// --- Sekvensen (körs av ONEWIRE_Process) ---
+typedef enum {
+    OW_SEQ_SEARCH_BEGIN = 0,
+    OW_SEQ_SEARCH_RESET,
+    OW_SEQ_SEARCH_COMMAND,
+    OW_SEQ_SEARCH_TRIPLET,
+    OW_SEQ_SEARCH_BIT,
+    OW_SEQ_CONFIG_RESET,
+    OW_SEQ_CONFIG_WRITE,
+    OW_SEQ_CONVERT_RESET,
+    OW_SEQ_CONVERT_COMMAND,
+    OW_SEQ_CONVERT_WAIT,
+    OW_SEQ_READ_RESET,
+    OW_SEQ_READ_COMMAND,
+    OW_SEQ_READ_SCRATCHPAD,
+    OW_SEQ_READ_STORE,
+    OW_SEQ_CYCLE_DONE
+} ow_seq_t;
+
+static ow_seq_t ow_seq = OW_SEQ_SEARCH_BEGIN;
+
+typedef struct {
+    uint8_t rom[8];
+    uint8_t resolution; // Upplösning som senast skrevs till givaren (9-12)
+} ow_sensor_t;
+
+static ow_sensor_t sensors[DS18B20_MAX_SENSORS];
+static uint8_t sensor_count = 0;
+static uint8_t sensor_index = 0;
+
+// Tillstånd för ROM-sökningen (Maxim AN187)
+static uint8_t search_rom[8];
+static uint8_t search_bit;               // 1..64
+static uint8_t search_last_zero;
+static uint8_t search_last_discrepancy;
+static bool search_last_device;
+
+static uint16_t cycle_start_ms = 0;
+static uint8_t cycles_since_search = 0;
+
 void ONEWIRE_Init(void) {
     // UART4 används i Single-Wire mode
+    U4BRG = BAUD_BITS;
     U4CON0bits.TXEN = 1;
     U4CON0bits.RXEN = 1;
     U4CON0bits.MODE = 0; // Asynchronous 8-bit
     U4CON1bits.ON = 1;
-}
 
-// TouchByte använder den aktuella BRG-inställningen (RESET eller BITS)
-uint8_t OW_TouchByte(uint8_t data) {
-    // Vänta tills TX-bufferten är tom
-    while(!U4ERRIRbits.TXMTIF);
-    // Läs bufferten för att rensa flaggan (om något fanns kvar)
-    U4RXB; 
-    U4TXB = data;
-    // Vänta på att ta emot data
-    while(!U4PIRbits.RXIF); 
-    return U4RXB;
+    // Låg prioritet, varje bit-slot är ~87 us så det finns gott om marginal
+    IPR12bits.U4RXIP = 0;
+    PIR12bits.U4RXIF = 0;
+    PIE12bits.U4RXIE = 1;
 }
 
-// Initierar kommunikationen (Reset/Presence)
-bool OW_Reset(void) {
+// --- Bit-slot-motorn ---
+
+static void ow_set_baud(uint16_t brg) {
     U4CON1bits.ON = 0;
-    // Sätt baudrate för Reset-puls (9600)
-    U4BRG = BAUD_RESET; 
+    U4BRG = brg;
     U4CON1bits.ON = 1;
-    // Skicka Reset Pulse (0xF0) och läs svaret
-    uint8_t response = OW_TouchByte(0xF0);
-    // Presence Pulse är allt annat än 0xF0
-    return (response != 0xF0);
 }
 
-// Skicka en bit och läs svaret
-uint8_t OW_TouchBit(uint8_t bitVal) {
-    U4CON1bits.ON = 0;
-    // Sätt baudrate för bit-puls (115200)
-    U4BRG = BAUD_BITS; 
-    U4CON1bits.ON = 1;
+// En bit-slot är en UART-byte: 0xFF = skriv '1'/läs, 0x00 = skriv '0'
+static void ow_send_slot(uint8_t bit) {
+    U4TXB = bit ? 0xFF : 0x00;
+}
 
-    // Skicka 0xFF för att läsa, 0x00 för att skriva '0'
-    uint8_t send = (bitVal) ? 0xFF : 0x00;
-    uint8_t recv = OW_TouchByte(send);
-    
-    // En bit läst som '1' om svaret är 0xFF
-    return (recv == 0xFF) ? 1 : 0;
+// Flyttar fram till nästa bit. Returnerar false när hela bufferten är klar.
+static bool ow_next_bit(void) {
+    ow_bit_mask <<= 1;
+    if (ow_bit_mask == 0) {
+        ow_bit_mask = 0x01;
+        ow_byte_index++;
+    }
+    return ow_byte_index < ow_length;
 }
 
-// Skriver en hel byte (LSB först)
-void OW_WriteByte(uint8_t val) {
-    for (uint8_t i = 0; i < 8; i++) {
-        OW_TouchBit(val & 0x01);
-        val >>= 1;
+bool ONEWIRE_ISR_Handler(void) {
+    if (!(PIE12bits.U4RXIE && PIR12bits.U4RXIF)) {
+        return false;
     }
+
+    uint8_t rx = U4RXB;
+    uint8_t bit = (rx == 0xFF) ? 1 : 0; // Läst '1' om ingen slav drog linjen låg
+
+    switch (ow_op) {
+        case OW_OP_RESET:
+            // Presence Pulse ger något mellan 0xF0 och 0x00. 0x00 betyder att linan
+            // låg låg hela resetpulsen, dvs. kortsluten mot jord.
+            ow_short = (rx == 0x00);
+            ow_presence = (rx != 0xF0) && !ow_short;
+            ow_set_baud(BAUD_BITS); // Bit-hastighet tills nästa reset
+            ow_op = OW_OP_IDLE;
+            break;
+
+        case OW_OP_WRITE:
+            if (ow_next_bit()) {
+                ow_send_slot(ow_buffer[ow_byte_index] & ow_bit_mask);
+            } else {
+                ow_op = OW_OP_IDLE;
+            }
+            break;
+
+        case OW_OP_READ:
+            if (bit) {
+                ow_buffer[ow_byte_index] |= ow_bit_mask;
+            }
+            if (ow_next_bit()) {
+                ow_send_slot(1);
+            } else {
+                ow_op = OW_OP_IDLE;
+            }
+            break;
+
+        case OW_OP_TRIPLET:
+            if (ow_triplet_step == 0) {
+                ow_triplet_id = bit;
+                ow_triplet_step = 1;
+                ow_send_slot(1);
+            } else if (ow_triplet_step == 1) {
+                ow_triplet_cmp = bit;
+                if (ow_triplet_id && ow_triplet_cmp) {
+                    ow_op = OW_OP_IDLE; // Ingen slav svarade
+                    break;
+                }
+                if (ow_triplet_id != ow_triplet_cmp) {
+                    ow_triplet_dir = ow_triplet_id; // Alla slavar har samma bit
+                }
+                ow_triplet_step = 2;
+                ow_send_slot(ow_triplet_dir);
+            } else {
+                ow_op = OW_OP_IDLE;
+            }
+            break;
+
+        default:
+            break;
+    }
+    return true;
 }
 
-// Läser en hel byte (LSB först)
-uint8_t OW_ReadByte(void) {
-    uint8_t val = 0;
-    for (uint8_t i = 0; i < 8; i++) {
-        // Skicka '1' för att trigga Read Slot
-        if (OW_TouchBit(1)) { 
-            val |= (1 << i);
+static bool ow_busy(void) {
+    return ow_op != OW_OP_IDLE;
+}
+
+static void ow_start_reset(void) {
+    ow_presence = false;
+    ow_short = false;
+    ow_op = OW_OP_RESET;
+    ow_set_baud(BAUD_RESET);
+    U4TXB = 0xF0; // Reset Pulse
+}
+
+// Bufferten ow_buffer[0..length-1] ska vara ifylld av anroparen
+static void ow_start_write(uint8_t length) {
+    ow_length = length;
+    ow_byte_index = 0;
+    ow_bit_mask = 0x01;
+    ow_op = OW_OP_WRITE;
+    ow_send_slot(ow_buffer[0] & 0x01);
+}
+
+static void ow_start_read(uint8_t length) {
+    for (uint8_t i = 0; i < length; i++) {
+        ow_buffer[i] = 0;
+    }
+    ow_length = length;
+    ow_byte_index = 0;
+    ow_bit_mask = 0x01;
+    ow_op = OW_OP_READ;
+    ow_send_slot(1);
+}
+
+static void ow_start_triplet(uint8_t preferred_dir) {
+    ow_triplet_step = 0;
+    ow_triplet_dir = preferred_dir;
+    ow_op = OW_OP_TRIPLET;
+    ow_send_slot(1);
+}
+
+// Dallas/Maxim CRC8 (x^8 + x^5 + x^4 + 1). 0 över data + CRC-byte betyder korrekt.
+static uint8_t ow_crc8(const volatile uint8_t *data, uint8_t length) {
+    uint8_t crc = 0;
+    while (length--) {
+        uint8_t in = *data++;
+        for (uint8_t i = 0; i < 8; i++) {
+            uint8_t mix = (crc ^ in) & 0x01;
+            crc >>= 1;
+            if (mix) crc ^= 0x8C;
+            in >>= 1;
         }
     }
-    return val;
-}
-
-// Icke-blockerande process för OneWire-mätning
-bool ONEWIRE_Process(void) {
-    static uint8_t state = 0;
-    // Använd en räknare för att mäta tid (måste kallas ofta)
-    static uint16_t timer = 0; 
-    
-    // Öka räknaren (antar att denna funktion anropas frekvent)
-    timer++; 
-    
-    switch(state) {
-        case 0: // Starta mätning (vänta 10000 cykler)
-            if (timer > 10000) { 
-                if (OW_Reset()) {
-                    OW_WriteByte(SKIP_ROM);
-                    OW_WriteByte(CONVERT_T); // Starta temperaturkonvertering
-                    state = 1;
-                    timer = 0;
-                }
+    return crc;
+}
+
+static void ow_load_match_rom(const uint8_t *rom) {
+    ow_buffer[0] = MATCH_ROM;
+    for (uint8_t i = 0; i < 8; i++) {
+        ow_buffer[1 + i] = rom[i];
+    }
+}
+
+// --- Upplösning ---
+
+static uint8_t ow_requested_resolution(uint8_t index) {
+    uint8_t bits = registerMap[REG_DS18B20_RESOLUTION_BASE + index];
+    return (bits >= 9 && bits <= 12) ? bits : 12;
+}
+
+// Konfigurationsbyte: 0 R1 R0 1 1 1 1 1
+static uint8_t ow_config_byte(uint8_t bits) {
+    return (uint8_t)(((bits - 9) << 5) | 0x1F);
+}
+
+// Konverteringstid: 93.75 ms vid 9 bit, fördubblas per extra bit (750 ms vid 12 bit)
+static uint16_t ow_conversion_ms(uint8_t bits) {
+    return (uint16_t)(94U << (bits - 9));
+}
+
+static bool ow_config_pending(void) {
+    for (uint8_t i = 0; i < sensor_count; i++) {
+        if (sensors[i].resolution != ow_requested_resolution(i)) return true;
+    }
+    return false;
+}
+
+static void ow_store_temperature(uint8_t index) {
+    // Scratchpad: [0] LSB, [1] MSB, [4] config, [8] CRC
+    int16_t raw = (int16_t)((ow_buffer[1] << 8) | ow_buffer[0]);
+
+    // Odefinierade LSB vid lägre upplösning nollas
+    raw &= (int16_t)(0xFFFF << (12 - sensors[index].resolution));
+
+    // 1/16 grad -> °C * 100 utan flyttal: raw * 100 / 16 = raw * 25 / 4
+    int16_t stored = (int16_t)(((int32_t)raw * 25) / 4);
+
+    REGMAP_WriteWord(REG_DS18B20_SENSOR_BASE + index * 2, (uint16_t)stored);
+    LOG_2(LOG_ONEWIRE_TEMP, index, stored);
+
+    if (index == 0) {
+        REGMAP_WriteWord(REG_DS18B20_TEMP_HI, (uint16_t)stored);
+    }
+}
+
+// Icke-blockerande process för OneWire-mätning.
+// Varje anrop tar hand om resultatet av föregående 1-Wire-operation och startar nästa.
+// Medan en sekvens pågår körs tasken om nästa varv; väntan på konverteringen och
+// tiden till nästa cykel läggs som deadlines (SCHEDULER_Defer).
+void ONEWIRE_Process(void) {
+    if (ow_busy()) {
+        SCHEDULER_Defer(0);
+        return;
+    }
+
+    switch (ow_seq) {
+        // --- 1. ROM-sökning (SEARCH_ROM, upp till DS18B20_MAX_SENSORS givare) ---
+        case OW_SEQ_SEARCH_BEGIN:
+            sensor_count = 0;
+            search_last_discrepancy = 0;
+            search_last_device = false;
+            cycles_since_search = 0;
+            ow_seq = OW_SEQ_SEARCH_RESET;
+            // Fallthrough
+
+        case OW_SEQ_SEARCH_RESET:
+            ow_start_reset();
+            ow_seq = OW_SEQ_SEARCH_COMMAND;
+            break;
+
+        case OW_SEQ_SEARCH_COMMAND:
+            if (!ow_presence) {
+                if (ow_short) LOG_0(LOG_ONEWIRE_BUS_SHORT);
+                registerMap[REG_DS18B20_COUNT] = sensor_count;
+                ow_seq = OW_SEQ_CYCLE_DONE; // Inga givare på bussen
+                break;
+            }
+            ow_buffer[0] = SEARCH_ROM;
+            ow_start_write(1);
+            search_bit = 1;
+            search_last_zero = 0;
+            ow_seq = OW_SEQ_SEARCH_TRIPLET;
+            break;
+
+        case OW_SEQ_SEARCH_TRIPLET: {
+            // Vid konflikt: samma väg som förra gången före senaste avvikelsen,
+            // '1' på den, annars '0'
+            uint8_t byte = (search_bit - 1) >> 3;
+            uint8_t mask = (uint8_t)(1 << ((search_bit - 1) & 0x07));
+            uint8_t preferred;
+            if (search_bit < search_last_discrepancy) {
+                preferred = (search_rom[byte] & mask) ? 1 : 0;
+            } else {
+                preferred = (search_bit == search_last_discrepancy) ? 1 : 0;
+            }
+            ow_start_triplet(preferred);
+            ow_seq = OW_SEQ_SEARCH_BIT;
+            break;
+        }
+
+        case OW_SEQ_SEARCH_BIT: {
+            if (ow_triplet_id && ow_triplet_cmp) {
+                registerMap[REG_DS18B20_COUNT] = sensor_count;
+                ow_seq = OW_SEQ_CONFIG_RESET; // Slaven försvann mitt i sökningen
+                sensor_index = 0;
+                break;
+            }
+            uint8_t byte = (search_bit - 1) >> 3;
+            uint8_t mask = (uint8_t)(1 << ((search_bit - 1) & 0x07));
+            if (!ow_triplet_id && !ow_triplet_cmp && !ow_triplet_dir) {
+                search_last_zero = search_bit;
+            }
+            if (ow_triplet_dir) search_rom[byte] |= mask;
+            else search_rom[byte] &= (uint8_t)~mask;
+
+            if (search_bit < 64) {
+                search_bit++;
+                ow_seq = OW_SEQ_SEARCH_TRIPLET;
+                break;
+            }
+
+            // Hel ROM-kod mottagen
+            search_last_discrepancy = search_last_zero;
+            if (search_last_discrepancy == 0) search_last_device = true;
+
+            // En lina som dras låg mitt i sökningen ger ROM 0, som också har CRC 0
+            if (ow_crc8(search_rom, 8) != 0) {
+                registerMap[REG_DS18B20_CRC_ERRORS]++;
+                LOG_0(LOG_ONEWIRE_ROM_CRC_ERROR);
+            } else if (search_rom[0] == DS18B20_FAMILY) {
+                for (uint8_t i = 0; i < 8; i++) sensors[sensor_count].rom[i] = search_rom[i];
+                sensors[sensor_count].resolution = 0; // Okänd, konfigureras nedan
+                sensor_count++;
+            }
+
+            if (search_last_device || sensor_count >= DS18B20_MAX_SENSORS) {
+                registerMap[REG_DS18B20_COUNT] = sensor_count;
+                LOG_1(LOG_ONEWIRE_SEARCH_DONE, sensor_count);
+                sensor_index = 0;
+                ow_seq = OW_SEQ_CONFIG_RESET;
+            } else {
+                ow_seq = OW_SEQ_SEARCH_RESET;
             }
             break;
-            
-        case 1: // Vänta på konvertering (DS18B20 tar ca 750ms vid 12-bit)
-            if (timer > 50000) { // Exempel: 50,000 cykler (måste kalibreras)
-                state = 2;
-            }
-            break;
-            
-        case 2: // Läs resultat
-            if (OW_Reset()) {
-                OW_WriteByte(SKIP_ROM);
-                OW_WriteByte(READ_SCRATCHPAD);
-                
-                uint8_t lo = OW_ReadByte(); // Läs LSB
-                uint8_t hi = OW_ReadByte(); // Läs MSB (Sign)
-                
-                // Konvertera rådata till temperatur
-                int16_t raw = (hi << 8) | lo;
-                float temp = raw / 16.0f; // Upplösning 1/16 grad
-                
-                // Lagra i registerMap som int16_t * 100
-                int16_t stored = (int16_t)(temp * 100.0f);
-                
-                registerMap[REG_DS18B20_TEMP_HI] = (stored >> 8) & 0xFF;
-                registerMap[REG_DS18B20_TEMP_LO] = stored & 0xFF;
-                
-                // Debug-utskrift
-                printf("Temp: %.2f C\r\n", temp);
-            }
-            state = 0; // Gå tillbaka till start
-            timer = 0;
-            return true; // Mätning slutförd
+        }
+
+        // --- 2. Upplösning per givare (endast när den ändrats) ---
+        case OW_SEQ_CONFIG_RESET:
+            while (sensor_index < sensor_count
+                   && sensors[sensor_index].resolution == ow_requested_resolution(sensor_index)) {
+                sensor_index++;
+            }
+            if (sensor_index >= sensor_count) {
+                ow_seq = OW_SEQ_CONVERT_RESET;
+                break;
+            }
+            ow_start_reset();
+            ow_seq = OW_SEQ_CONFIG_WRITE;
+            break;
+
+        case OW_SEQ_CONFIG_WRITE: {
+            uint8_t bits = ow_requested_resolution(sensor_index);
+            ow_load_match_rom(sensors[sensor_index].rom);
+            ow_buffer[9] = WRITE_SCRATCHPAD;
+            ow_buffer[10] = DS18B20_ALARM_TH;
+            ow_buffer[11] = DS18B20_ALARM_TL;
+            ow_buffer[12] = ow_config_byte(bits);
+            ow_start_write(13);
+            sensors[sensor_index].resolution = bits;
+            sensor_index++;
+            ow_seq = OW_SEQ_CONFIG_RESET;
+            break;
+        }
+
+        // --- 3. En gemensam CONVERT_T för alla givare ---
+        case OW_SEQ_CONVERT_RESET:
+            if (sensor_count == 0) {
+                ow_seq = OW_SEQ_CYCLE_DONE;
+                break;
+            }
+            ow_start_reset();
+            ow_seq = OW_SEQ_CONVERT_COMMAND;
+            break;
+
+        case OW_SEQ_CONVERT_COMMAND:
+            if (!ow_presence) {
+                ow_seq = OW_SEQ_CYCLE_DONE;
+                break;
+            }
+            ow_buffer[0] = SKIP_ROM;
+            ow_buffer[1] = CONVERT_T; // Alla givare konverterar samtidigt
+            ow_start_write(2);
+            ow_seq = OW_SEQ_CONVERT_WAIT;
+            break;
+
+        case OW_SEQ_CONVERT_WAIT: {
+            // Vänta på den långsammaste givaren
+            uint16_t wait_ms = 0;
+            for (uint8_t i = 0; i < sensor_count; i++) {
+                uint16_t t = ow_conversion_ms(sensors[i].resolution);
+                if (t > wait_ms) wait_ms = t;
+            }
+            sensor_index = 0;
+            ow_seq = OW_SEQ_READ_RESET;
+            SCHEDULER_Defer(wait_ms);
+            return;
+        }
+
+        // --- 4. Läs scratchpad per givare (MATCH_ROM) ---
+        case OW_SEQ_READ_RESET:
+            if (sensor_index >= sensor_count) {
+                ow_seq = OW_SEQ_CYCLE_DONE;
+                break;
+            }
+            ow_start_reset();
+            ow_seq = OW_SEQ_READ_COMMAND;
+            break;
+
+        case OW_SEQ_READ_COMMAND:
+            if (!ow_presence) {
+                ow_seq = OW_SEQ_CYCLE_DONE;
+                break;
+            }
+            ow_load_match_rom(sensors[sensor_index].rom);
+            ow_buffer[9] = READ_SCRATCHPAD;
+            ow_start_write(10);
+            ow_seq = OW_SEQ_READ_SCRATCHPAD;
+            break;
+
+        case OW_SEQ_READ_SCRATCHPAD:
+            ow_start_read(OW_SCRATCHPAD_SIZE);
+            ow_seq = OW_SEQ_READ_STORE;
+            break;
+
+        case OW_SEQ_READ_STORE:
+            if (ow_crc8(ow_buffer, OW_SCRATCHPAD_SIZE) == 0) {
+                ow_store_temperature(sensor_index);
+            } else {
+                // Behåll förra värdet; en frånkopplad givare läser 0xFF överallt
+                registerMap[REG_DS18B20_CRC_ERRORS]++;
+                LOG_1(LOG_ONEWIRE_READ_CRC_ERROR, sensor_index);
+            }
+            sensor_index++;
+            ow_seq = OW_SEQ_READ_RESET;
+            break;
+
+        // --- 5. Vänta till nästa cykel, sök om ROM-koder ibland ---
+        case OW_SEQ_CYCLE_DONE: {
+            cycles_since_search++;
+            if (sensor_count == 0 || cycles_since_search >= ONEWIRE_RESCAN_CYCLES) {
+                ow_seq = OW_SEQ_SEARCH_BEGIN;
+            } else {
+                ow_seq = ow_config_pending() ? OW_SEQ_CONFIG_RESET : OW_SEQ_CONVERT_RESET;
+                sensor_index = 0;
+            }
+            // Fast takt räknat från förra cykelns start; har vi halkat efter startar vi om takten
+            uint16_t now = SCHEDULER_Millis();
+            cycle_start_ms += ONEWIRE_TASK_PERIOD_MS;
+            if ((int16_t)(cycle_start_ms - now) < 0) {
+                cycle_start_ms = now;
+            }
+            SCHEDULER_Defer(cycle_start_ms - now);
+            return;
+        }
     }
-    return false; // Fortfarande i väntan
+
+    // Sekvensen fortsätter: kör om nästa varv (UART4-avbrottet väcker CPU:n när
+    // bit-slot-motorn är klar)
+    SCHEDULER_Defer(0);
 }
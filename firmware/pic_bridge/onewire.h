@@ -1,11 +1,28 @@
-#ifndef ONEWIRE_H
+#ifndef	ONEWIRE_H
 #define	ONEWIRE_H
 
 #include <stdint.h>
 #include <stdbool.h>
 
+// Mätintervall för DS18B20 (schemaläggarens period för ONEWIRE_Process)
+#define ONEWIRE_TASK_PERIOD_MS 10000
+
+// Ny ROM-sökning var N:e mätcykel (och alltid när inga givare hittats)
+#define ONEWIRE_RESCAN_CYCLES  6
+
 void ONEWIRE_Init(void);
-// Returnerar true om en mätning slutfördes och lagrades i registerMap
-bool ONEWIRE_Process(void); 
+
+/**
+ * @brief UART4 Interrupt Service Routine Logic (1-Wire bit-slot-motor).
+ * Varje mottagen byte avslutar en bit-slot och startar nästa, så huvudloopen
+ * väntar aldrig inne i en 1-Wire-transaktion.
+ * Den är designad att kallas från låg-prioritets-ISR i main.c.
+ * @return true om avbrottet hanterades, false annars.
+ */
+bool ONEWIRE_ISR_Handler(void);
+
+// Driver ROM-sökning, konfiguration, CONVERT_T och avläsning av alla givare.
+// Lagrar resultaten per givare i registerMap.
+void ONEWIRE_Process(void);
 
 #endif	/* ONEWIRE_H */
@@ -0,0 +1,121 @@
+#include "perf.h"
+#include "globals.h"
+#include "regmap.h"
+#include "scheduler.h"
+#include "uart2.h"
+#include "modbus_rtu.h"
+#include <xc.h>
+
+// TMR1 och TMR3: Fosc/4 / 8 = 2 MHz
+#define PERF_TICKS_PER_US 2
+#define PERF_PROBE_TICKS  2000 // Sonden var 1 ms
+
+// Glidande medel (1/16) lagras som us * 16, så medel över 4095 us mättar
+#define PERF_AVG_SHIFT    4
+#define PERF_AVG_MAX_US   (0xFFFF >> PERF_AVG_SHIFT)
+
+// Längre än så kan inte mätas med TMR1 utan att den slår runt
+#define PERF_TMR1_SPAN_MS 30
+
+// Skrivs av hög-prioritets-ISR:en, läses av PERF_Process med GIEH avslaget
+static volatile uint16_t latency_avg16 = 0;
+static volatile uint16_t duration_avg16 = 0;
+static volatile uint8_t i2c_errors = 0;
+
+void PERF_Init(void) {
+    for (uint8_t reg = REG_PERF_HP_LATENCY_MAX_US_HI; reg <= REG_PERF_I2C_ERRORS; reg++) {
+        registerMap[reg] = 0;
+    }
+
+    // TMR3: samma 2 MHz som TMR1, avbrott vid överslag
+    T3CLK = 0b00001;              // Fosc/4
+    T3CONbits.CKPS = 0b11;        // 1:8
+    T3CONbits.RD16 = 1;
+    TMR3 = (uint16_t)(0 - PERF_PROBE_TICKS);
+
+    IPR5bits.TMR3IP = 1;          // Hög prioritet: väntar bakom I2C och GIEH-sektioner
+    PIR5bits.TMR3IF = 0;
+    PIE5bits.TMR3IE = 1;
+    T3CONbits.ON = 1;
+}
+
+static uint16_t perf_average(uint16_t avg16, uint16_t us) {
+    // avg += (us - avg) / 16, i 16-bitars aritmetik (ISR)
+    if (us > PERF_AVG_MAX_US) us = PERF_AVG_MAX_US;
+    uint16_t sample16 = (uint16_t)(us << PERF_AVG_SHIFT);
+    if (sample16 >= avg16) {
+        return (uint16_t)(avg16 + ((sample16 - avg16) >> PERF_AVG_SHIFT));
+    }
+    return (uint16_t)(avg16 - ((avg16 - sample16) >> PERF_AVG_SHIFT));
+}
+
+// Maxvärde från hög-prioritets-ISR:en. Sällsynt; pågående ögonblicksbilder görs om.
+static void perf_raise_max_isr(uint8_t hi_reg, uint16_t us) {
+    uint16_t max_us = (uint16_t)((registerMap[hi_reg] << 8) | registerMap[hi_reg + 1]);
+    if (us > max_us) {
+        registerMap[hi_reg] = (uint8_t)(us >> 8);
+        registerMap[hi_reg + 1] = (uint8_t)(us & 0xFF);
+        REGMAP_ISR_TOUCH();
+    }
+}
+
+bool PERF_ISR_Handler(void) {
+    if (!(PIE5bits.TMR3IE && PIR5bits.TMR3IF)) {
+        return false;
+    }
+    // TMR3 räknar vidare från 0 efter överslaget: det är väntetiden (inkl. kontextsparning)
+    uint16_t late_ticks = TMR3;
+    TMR3 -= PERF_PROBE_TICKS;
+    PIR5bits.TMR3IF = 0;
+
+    uint16_t us = late_ticks / PERF_TICKS_PER_US;
+    perf_raise_max_isr(REG_PERF_HP_LATENCY_MAX_US_HI, us);
+    latency_avg16 = perf_average(latency_avg16, us);
+    return true;
+}
+
+void PERF_HighIsrDone(uint16_t entry_ticks) {
+    uint16_t us = (uint16_t)(TMR1 - entry_ticks) / PERF_TICKS_PER_US;
+    perf_raise_max_isr(REG_PERF_HP_DURATION_MAX_US_HI, us);
+    duration_avg16 = perf_average(duration_avg16, us);
+}
+
+void PERF_CountI2CError(void) {
+    i2c_errors++;
+}
+
+void PERF_Stamp(perf_stamp_t *stamp) {
+    stamp->ms = SCHEDULER_Millis();
+    stamp->ticks = TMR1;
+}
+
+uint16_t PERF_ElapsedUs(const perf_stamp_t *stamp) {
+    uint16_t ticks = TMR1;
+    uint16_t ms = (uint16_t)(SCHEDULER_Millis() - stamp->ms);
+    if (ms >= PERF_TMR1_SPAN_MS) {
+        return (ms >= 65) ? 0xFFFF : (uint16_t)(ms * 1000);
+    }
+    return (uint16_t)(ticks - stamp->ticks) / PERF_TICKS_PER_US;
+}
+
+void PERF_RaiseMax(uint8_t hi_reg, uint16_t us) {
+    uint16_t max_us = (uint16_t)((registerMap[hi_reg] << 8) | registerMap[hi_reg + 1]);
+    if (us > max_us) {
+        REGMAP_WriteWord(hi_reg, us);
+    }
+}
+
+void PERF_Process(void) {
+    // 16-bitarsvärdena skrivs av hög-prioritets-ISR:en
+    INTCON0bits.GIEH = 0;
+    uint16_t latency = latency_avg16;
+    uint16_t duration = duration_avg16;
+    INTCON0bits.GIEH = 1;
+
+    REGMAP_WriteWord(REG_PERF_HP_LATENCY_AVG_US_HI, latency >> PERF_AVG_SHIFT);
+    REGMAP_WriteWord(REG_PERF_HP_DURATION_AVG_US_HI, duration >> PERF_AVG_SHIFT);
+
+    // Räknar runt, ESP:n tittar på skillnaden
+    registerMap[REG_PERF_UART_OVERRUNS] = (uint8_t)(UART2_RxOverruns() + MODBUS_RTU_RxOverruns());
+    registerMap[REG_PERF_I2C_ERRORS] = i2c_errors;
+}
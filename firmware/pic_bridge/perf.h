@@ -0,0 +1,59 @@
+#ifndef PERF_H
+#define PERF_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// --- Instrumentering av hot paths (REG_PERF_*, läses i ett block av ESP:n) ---
+// Tidsbas: TMR1 (fri, 2 MHz, startas av I2C_Init). Latensen för hög prioritet mäts
+// med en sond: TMR3 ger ett hög-prioritets-avbrott varje ms och räknar vidare från
+// överslaget, så TMR3 vid ingången = hur länge avbrottet fick vänta.
+// Maxvärden nollställs genom att skriva 0 till registret (som REG_I2C_STRETCH_MAX_US).
+
+#define PERF_TASK_PERIOD_MS 100 // Publicering av medelvärden och räknare
+
+// Tidsstämpel för huvudloopen. TMR1 slår runt efter 32.8 ms, ms-ticken tar över därefter.
+typedef struct {
+    uint16_t ticks;
+    uint16_t ms;
+} perf_stamp_t;
+
+/**
+ * @brief Startar latenssonden (TMR3) och nollställer REG_PERF_*. Anropas efter I2C_Init().
+ */
+void PERF_Init(void);
+
+/**
+ * @brief TMR3 latenssond. Den är designad att kallas från hög-prioritets-ISR i main.c.
+ * @return true om avbrottet hanterades, false annars.
+ */
+bool PERF_ISR_Handler(void);
+
+/**
+ * @brief Anropas sist i hög-prioritets-ISR:en med TMR1 från ingången (varaktighet max/medel).
+ */
+void PERF_HighIsrDone(uint16_t entry_ticks);
+
+/**
+ * @brief Räknar en I2C-kollision eller över-/underskrivning av bufferten. Anropas från I2C-ISR:en.
+ */
+void PERF_CountI2CError(void);
+
+void PERF_Stamp(perf_stamp_t *stamp);
+
+/**
+ * @brief Mikrosekunder sedan stamp (mättar vid 65535).
+ */
+uint16_t PERF_ElapsedUs(const perf_stamp_t *stamp);
+
+/**
+ * @brief Skriver us till hi_reg/hi_reg + 1 om det är större än det som står där. Endast huvudloopen.
+ */
+void PERF_RaiseMax(uint8_t hi_reg, uint16_t us);
+
+/**
+ * @brief Publicerar medelvärden och fel-räknare i registerMap.
+ */
+void PERF_Process(void);
+
+#endif // PERF_H
@@ -0,0 +1,111 @@
+// GENERERAD FIL - ändra inte för hand.
+// Skapad av tools/gen_registers.cpp från tools/registers.schema (firmware/pic_bridge).
+// Adresser i registerMap. Modbus: ordvy N = (N << 8 | N+1), bytevy 0x100+N.
+// Hot-registren läses i 4 block (start+antal register): 0x0000+26, 0x0080+27, 0x00E6+3, 0x01EA+3
+
+#ifndef REGISTERS_H
+#define REGISTERS_H
+
+// --- THERMIQ (Pumpens I2C Master Write, 1 byte per register) ---
+#define REG_T_OUTDOOR                      0 // Outdoor (°C)
+#define REG_T_INDOOR                       1 // Indoor (°C, heltal). Heltal (1) + tiondelar (2)
+#define REG_T_INDOOR_DEC                   2 // Tiondelar (0-9)
+#define REG_T_SUPPLY                       5 // Supply Line (°C)
+#define REG_T_RETURN                       6 // Return Line (°C)
+#define REG_T_HOTWATER                     7 // Hotwater (°C)
+#define REG_S_STATUS                       16 // Status 16. Bit 0 brine, 1 kompressor, 2 cirk., 3 VV, 7 tillsats
+#define REG_I_INTEGRAL                     25 // Integral
+#define REG_SET_ROOM_TARGET                50 // Rum Börvärde (°C) [rw]
+#define REG_P_CURVE                        52 // Kurva [rw]
+
+// --- PIC (128-255, hot-registren först) ---
+// Hot: läses varje uppdatering
+#define REG_DS18B20_TEMP_HI                128 // DS18B20 (°C * 100)
+#define REG_DS18B20_TEMP_LO                129
+#define REG_ADC_NTC_OUTDOOR_HI             130 // NTC Ute (°C * 100)
+#define REG_ADC_NTC_OUTDOOR_LO             131
+#define REG_ADC_NTC_INDOOR_HI              132 // NTC Inne (°C * 100)
+#define REG_ADC_NTC_INDOOR_LO              133
+#define REG_SPOOF_ACTUAL_OUTDOOR_HI        134 // Spoofad Ute Faktisk (°C * 100)
+#define REG_SPOOF_ACTUAL_OUTDOOR_LO        135
+#define REG_SPOOF_ACTUAL_INDOOR_HI         136 // Spoofad Inne Faktisk (°C * 100)
+#define REG_SPOOF_ACTUAL_INDOOR_LO         137
+#define REG_DS18B20_SENSOR_BASE            138 // DS18B20 Givare (°C * 100), 8 x HI/LO
+#define REG_DS18B20_SENSOR_LEN             8
+#define REG_EVENT_FIFO_LEVEL               154 // Händelser i kö
+
+// Cold: läses var 10:e uppdatering
+#define REG_ADC_NTC_RAW_HI                 155 // NTC Rådata
+#define REG_ADC_NTC_RAW_LO                 156
+#define REG_ADC_OUTDOOR_OVERSAMPLED_HI     157 // ADC Ute Medel
+#define REG_ADC_OUTDOOR_OVERSAMPLED_LO     158
+#define REG_ADC_INDOOR_OVERSAMPLED_HI      159 // ADC Inne Medel
+#define REG_ADC_INDOOR_OVERSAMPLED_LO      160
+#define REG_ADC_OUTDOOR_NOISE_HI           161 // ADC Ute Brus
+#define REG_ADC_OUTDOOR_NOISE_LO           162
+#define REG_ADC_INDOOR_NOISE_HI            163 // ADC Inne Brus
+#define REG_ADC_INDOOR_NOISE_LO            164
+#define REG_DS18B20_COUNT                  165 // DS18B20 Antal. Vid senaste ROM-sökningen
+#define REG_DS18B20_CRC_ERRORS             166 // DS18B20 CRC-fel. Räknar runt
+#define REG_SPOOF_WIPER_VERIFY_ERRORS      167 // Wiper Verifieringsfel. SPOOFER_VERIFY_WIPERS, räknar runt
+#define REG_EVENT_OVERFLOWS                168 // Händelser Kastade. FIFO:n full, räknar runt
+#define REG_PERF_HP_LATENCY_MAX_US_HI      169 // ISR Latens Max (us). TMR3-sond
+#define REG_PERF_HP_LATENCY_MAX_US_LO      170
+#define REG_PERF_HP_LATENCY_AVG_US_HI      171 // ISR Latens Medel (us)
+#define REG_PERF_HP_LATENCY_AVG_US_LO      172
+#define REG_PERF_HP_DURATION_MAX_US_HI     173 // ISR Körtid Max (us). High_Priority_ISR (I2C)
+#define REG_PERF_HP_DURATION_MAX_US_LO     174
+#define REG_PERF_HP_DURATION_AVG_US_HI     175 // ISR Körtid Medel (us)
+#define REG_PERF_HP_DURATION_AVG_US_LO     176
+#define REG_PERF_TASK_MODBUS_MAX_US_HI     177 // Task Modbus Max (us)
+#define REG_PERF_TASK_MODBUS_MAX_US_LO     178
+#define REG_PERF_TASK_SPOOFER_MAX_US_HI    179 // Task Spoofer Max (us)
+#define REG_PERF_TASK_SPOOFER_MAX_US_LO    180
+#define REG_PERF_TASK_ONEWIRE_MAX_US_HI    181 // Task OneWire Max (us)
+#define REG_PERF_TASK_ONEWIRE_MAX_US_LO    182
+#define REG_PERF_TASK_ADC_MAX_US_HI        183 // Task ADC Max (us)
+#define REG_PERF_TASK_ADC_MAX_US_LO        184
+#define REG_PERF_LOOP_PERIOD_MAX_US_HI     185 // Huvudloop Period Max (us)
+#define REG_PERF_LOOP_PERIOD_MAX_US_LO     186
+#define REG_PERF_UART_OVERRUNS             187 // UART Överskridningar. UART1 + UART2, räknar runt
+#define REG_PERF_I2C_ERRORS                188 // I2C Fel. Kollisioner, RX/TX-överskridningar
+#define REG_I2C_STRETCH_MAX_US_HI          189 // I2C Klocksträckning Max (us). Från ISR-ingången, latensen i PERF_HP_LATENCY_*
+#define REG_I2C_STRETCH_MAX_US_LO          190
+
+// Exporteras inte till klienterna
+#define REG_SPOOF_ERROR_OUTDOOR_HI         191 // Spoofad Ute Fel (°C * 100)
+#define REG_SPOOF_ERROR_OUTDOOR_LO         192
+#define REG_SPOOF_ERROR_INDOOR_HI          193 // Spoofad Inne Fel (°C * 100)
+#define REG_SPOOF_ERROR_INDOOR_LO          194
+#define REG_SPOOF_SETTLE_OUTDOOR_MS_HI     195 // Spoofad Ute Insvängning (ms)
+#define REG_SPOOF_SETTLE_OUTDOOR_MS_LO     196
+#define REG_SPOOF_SETTLE_INDOOR_MS_HI      197 // Spoofad Inne Insvängning (ms)
+#define REG_SPOOF_SETTLE_INDOOR_MS_LO      198
+#define REG_I2C_CAPTURE_LOST               199 // I2C Fångst Kastade
+#define REG_I2C_CAPTURE_CYCLES             200 // I2C Fångst Cykler. ISR-kostnad per post
+
+// Hot: läses varje uppdatering
+#define REG_TARGET_OUTDOOR_TEMP_HI         230 // Spoofad Ute Mål (°C * 100). Pot 1 [rw]
+#define REG_TARGET_OUTDOOR_TEMP_LO         231
+#define REG_TARGET_INDOOR_TEMP_HI          232 // Spoofad Inne Mål (°C * 100). Pot 0 [rw]
+#define REG_TARGET_INDOOR_TEMP_LO          233
+#define REG_SPOOFING_ENABLED               234 // Spoofing. Styr digipottarna [rw]
+#define REG_RELAY_CONTROL                  235 // Reläer. Bit 0 EVU, 1 pump 1, 2 pump 2 [rw]
+#define REG_I2C_ENABLE_CONTROL             236 // I2C Kommunikation Aktiv [rw]
+
+// Exporteras inte till klienterna
+#define REG_I2C_CAPTURE_CONTROL            237 // I2C Fångst [rw]
+#define REG_TARGET_COMMAND_ADDR            238 // Kommando Adress [rw]
+#define REG_TARGET_COMMAND_VALUE_HI        239 // Kommando Värde [rw]
+#define REG_TARGET_COMMAND_VALUE_LO        240
+#define REG_DS18B20_RESOLUTION_BASE        241 // DS18B20 Upplösning. 9-12 bit, 0 = 12 bit [rw], 8 x 1 byte
+#define REG_DS18B20_RESOLUTION_LEN         8
+
+// Cold: läses var 10:e uppdatering
+#define REG_FW_MAJOR_VERSION               250 // Firmware Major
+#define REG_FW_MINOR_VERSION               251 // Firmware Minor
+#define REG_I2C_STATUS                     252 // I2C Status. Kommandotillstånd i i2c.c
+#define REG_NTC_CURVE_SELECT               253 // NTC Kurva. RD0: 1 = 150 Ohm, 0 = 22 kOhm
+#define REG_NVM_STATUS                     254 // NVM Status. nvm.c: NVM_STATUS_* (återställd, väntar, skrivfel)
+
+#endif /* REGISTERS_H */
@@ -0,0 +1,55 @@
+#include "regmap.h"
+#include "globals.h"
+#include "i2c.h"
+#include "scheduler.h"
+
+// Udda = pumpen skriver. Endast 8 bitar: läsaren jämför före/efter en kort kopiering.
+volatile uint8_t registerMapSeq = 0;
+
+bool REGMAP_Snapshot(uint8_t start, uint16_t count, uint8_t *dest) {
+    uint8_t seq = registerMapSeq;
+
+    for (uint16_t i = 0; i < count; i++) {
+        dest[i] = registerMap[(uint8_t)(start + i)];
+    }
+    return !(seq & 0x01) && seq == registerMapSeq;
+}
+
+regmap_copy_t REGMAP_SnapshotWait(regmap_wait_t *wait, uint8_t start, uint16_t count, uint8_t *dest) {
+    if (REGMAP_Snapshot(start, count, dest)) {
+        wait->waiting = false;
+        return REGMAP_COPY_OK;
+    }
+    if (!wait->waiting) {
+        wait->waiting = true;
+        wait->since_ms = SCHEDULER_Millis();
+        return REGMAP_COPY_RETRY;
+    }
+    if ((uint16_t)(SCHEDULER_Millis() - wait->since_ms) < REGMAP_SNAPSHOT_TIMEOUT_MS) {
+        return REGMAP_COPY_RETRY;
+    }
+    wait->waiting = false;
+    return REGMAP_COPY_TIMEOUT;
+}
+
+void REGMAP_WriteWord(uint8_t hi_reg, uint16_t value) {
+    I2C_Hold();
+    registerMap[hi_reg] = (uint8_t)(value >> 8);
+    registerMap[(uint8_t)(hi_reg + 1)] = (uint8_t)(value & 0xFF);
+    I2C_Release();
+}
+
+void REGMAP_WriteBlock(uint8_t start, const uint8_t *src, uint16_t count) {
+    uint16_t i = 0;
+
+    while (i < count) {
+        uint16_t end = i + REGMAP_WRITE_CHUNK;
+        if (end > count) end = count;
+
+        I2C_Hold();
+        for (; i < end; i++) {
+            registerMap[(uint8_t)(start + i)] = src[i];
+        }
+        I2C_Release();
+    }
+}
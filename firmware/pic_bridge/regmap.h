@@ -0,0 +1,67 @@
+#ifndef REGMAP_H
+#define REGMAP_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// --- Konsekvent åtkomst till registerMap ---
+// Skrivare i I2C-ISR:en (pumpens Master Write) omges av en sekvensräknare
+// (seqlock): udda = skrivning pågår. Läsare i huvudloopen kopierar ett block och
+// godtar kopian bara om räknaren var jämn och oförändrad under kopieringen.
+// Huvudloopens egna flerbytesskrivningar håller I2C-avbrottet under ett fåtal
+// instruktioner så att pumpen aldrig ser ett halvt skrivet ord.
+
+// Längsta väntan på en konsekvent kopia. Pumpens längsta Master Write (index + 256
+// bytes vid 100 kHz) tar ~24 ms och läsaren försöker direkt efter varje STOP, så
+// tiden räcker för två hela transaktioner. Skriver pumpen längre än så utan paus
+// svarar läsaren "upptagen" i stället för att skicka en blandad kopia.
+#define REGMAP_SNAPSHOT_TIMEOUT_MS 50
+
+// Största block som skrivs med I2C-avbrottet hållet (~15 us)
+#define REGMAP_WRITE_CHUNK      16
+
+extern volatile uint8_t registerMapSeq;
+
+// Anropas endast från I2C-ISR:en, runt en Master Write-transaktion
+#define REGMAP_ISR_WRITE_BEGIN() (registerMapSeq++)
+#define REGMAP_ISR_WRITE_END()   (registerMapSeq++)
+
+// ISR:en skrev ett ord utanför en Master Write (t.ex. ett maxvärde):
+// pågående kopior görs om, pariteten behålls
+#define REGMAP_ISR_TOUCH()       (registerMapSeq += 2)
+
+typedef enum {
+    REGMAP_COPY_OK = 0,  // dest är en konsekvent kopia
+    REGMAP_COPY_RETRY,   // Pumpen skriver, försök igen nästa varv
+    REGMAP_COPY_TIMEOUT  // Ingen konsekvent kopia inom REGMAP_SNAPSHOT_TIMEOUT_MS
+} regmap_copy_t;
+
+// Väntetillstånd för en läsare som försöker om över flera varv (en per anropare)
+typedef struct {
+    bool waiting;
+    uint16_t since_ms; // SCHEDULER_Millis() vid första försöket
+} regmap_wait_t;
+
+/**
+ * @brief Kopierar registerMap[start .. start + count - 1] till dest (index slår runt vid 255).
+ * @return true om kopian är konsekvent, false om pumpen skrev under tiden.
+ */
+bool REGMAP_Snapshot(uint8_t start, uint16_t count, uint8_t *dest);
+
+/**
+ * @brief REGMAP_Snapshot() med tidsgräns: anropas varje varv tills resultatet inte är
+ * REGMAP_COPY_RETRY. Vid REGMAP_COPY_TIMEOUT är dest inte konsekvent och ska inte skickas.
+ */
+regmap_copy_t REGMAP_SnapshotWait(regmap_wait_t *wait, uint8_t start, uint16_t count, uint8_t *dest);
+
+/**
+ * @brief Skriver ett 16-bitars värde (HI på hi_reg, LO på hi_reg + 1) atomiskt mot I2C-ISR:en.
+ */
+void REGMAP_WriteWord(uint8_t hi_reg, uint16_t value);
+
+/**
+ * @brief Skriver ett block atomiskt mot I2C-ISR:en, REGMAP_WRITE_CHUNK bytes åt gången.
+ */
+void REGMAP_WriteBlock(uint8_t start, const uint8_t *src, uint16_t count);
+
+#endif // REGMAP_H
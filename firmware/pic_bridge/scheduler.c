@@ -0,0 +1,101 @@
+#include "scheduler.h"
+#include "globals.h"
+#include "perf.h"
+#include <xc.h>
+
+static volatile uint16_t ticks_ms = 0;
+
+// Task som körs just nu (för SCHEDULER_Defer)
+static scheduler_task_t *current_task = 0;
+static bool current_deferred = false;
+
+// Början av förra varvet (REG_PERF_LOOP_PERIOD_MAX_US)
+static perf_stamp_t pass_start;
+static bool pass_started = false;
+
+void SCHEDULER_Init(void) {
+    // TMR0: 8-bitars läge, Fosc/4 = 16 MHz, 1:64 => 250 kHz, period 250 => 1 kHz
+    T0CON0bits.EN = 0;
+    T0CON0bits.MD16 = 0;
+    T0CON0bits.OUTPS = 0;      // 1:1
+    T0CON1bits.CS = 0b010;     // Fosc/4
+    T0CON1bits.CKPS = 0b0110;  // 1:64
+    TMR0H = 249;               // Period (8-bitars läge)
+    TMR0L = 0;
+
+    IPR3bits.TMR0IP = 0;       // Låg prioritet, I2C-slaven går först
+    PIR3bits.TMR0IF = 0;
+    PIE3bits.TMR0IE = 1;
+    T0CON0bits.EN = 1;
+
+    // SLEEP() stoppar bara CPU:n, kringenheter och avbrott fortsätter (Idle-läge)
+    CPUDOZEbits.IDLEN = 1;
+}
+
+bool SCHEDULER_ISR_Handler(void) {
+    if (PIE3bits.TMR0IE && PIR3bits.TMR0IF) {
+        PIR3bits.TMR0IF = 0;
+        // I2C-ISR:en (hög prioritet) läser ticken, så 16-bitarsökningen får inte avbrytas
+        INTCON0bits.GIEH = 0;
+        ticks_ms++;
+        INTCON0bits.GIEH = 1;
+        return true;
+    }
+    return false;
+}
+
+uint16_t SCHEDULER_Millis(void) {
+    // 16-bitars läsning är inte atomisk på PIC18, läs om tills två läsningar stämmer
+    uint16_t now;
+    do {
+        now = ticks_ms;
+    } while (now != ticks_ms);
+    return now;
+}
+
+void SCHEDULER_RunPass(scheduler_task_t *tasks, uint8_t count) {
+    if (pass_started) {
+        PERF_RaiseMax(REG_PERF_LOOP_PERIOD_MAX_US_HI, PERF_ElapsedUs(&pass_start));
+    }
+    PERF_Stamp(&pass_start);
+    pass_started = true;
+
+    for (uint8_t i = 0; i < count; i++) {
+        scheduler_task_t *task = &tasks[i];
+        uint16_t now = SCHEDULER_Millis();
+
+        if (task->period_ms != SCHEDULER_EVERY_PASS && (int16_t)(now - task->next_run_ms) < 0) {
+            continue; // Inte dags än
+        }
+
+        current_task = task;
+        current_deferred = false;
+        perf_stamp_t run_start;
+        PERF_Stamp(&run_start);
+        task->run();
+        if (task->perf_reg != SCHEDULER_NO_PERF_REG) {
+            PERF_RaiseMax(task->perf_reg, PERF_ElapsedUs(&run_start));
+        }
+        current_task = 0;
+
+        if (!current_deferred && task->period_ms != SCHEDULER_EVERY_PASS) {
+            // Fast takt utan drift: räkna från förra deadline, inte från nu.
+            // Har vi hamnat mer än en period efter hoppar vi ikapp istället för att köra i kö.
+            task->next_run_ms += task->period_ms;
+            if ((int16_t)(now - task->next_run_ms) >= 0) {
+                task->next_run_ms = now + task->period_ms;
+            }
+        }
+    }
+
+    // Inget mer att göra: vila tills nästa avbrott (senast nästa tick om 1 ms).
+    // Ett avbrott precis före SLEEP() kan fördröja nästa varv med som mest en tick.
+    SLEEP();
+}
+
+void SCHEDULER_Defer(uint16_t delay_ms) {
+    if (current_task != 0) {
+        current_task->next_run_ms = SCHEDULER_Millis() + delay_ms;
+        current_deferred = true;
+    }
+}
@@ -0,0 +1,54 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Tasken körs varje varv i huvudloopen (händelsestyrd, t.ex. UART-tolkning)
+#define SCHEDULER_EVERY_PASS 0
+
+// Taskens körtid publiceras inte
+#define SCHEDULER_NO_PERF_REG 0
+
+typedef void (*scheduler_fn_t)(void);
+
+typedef struct {
+    scheduler_fn_t run;
+    uint16_t period_ms;   // Ordinarie period, eller SCHEDULER_EVERY_PASS
+    uint16_t next_run_ms; // Nästa deadline (sköts av schemaläggaren)
+    uint8_t perf_reg;     // Längsta körtid (us) skrivs till perf_reg/perf_reg + 1, eller SCHEDULER_NO_PERF_REG
+} scheduler_task_t;
+
+/**
+ * @brief Initierar TMR0 som 1 ms systemtick och aktiverar Idle-läge för huvudloopen.
+ */
+void SCHEDULER_Init(void);
+
+/**
+ * @brief TMR0 Interrupt Service Routine Logic (räknar upp systemticken).
+ * Den är designad att kallas från låg-prioritets-ISR i main.c.
+ * @return true om avbrottet hanterades, false annars.
+ */
+bool SCHEDULER_ISR_Handler(void);
+
+/**
+ * @brief Millisekunder sedan start (slår runt efter 65.5 s, jämför alltid med differens).
+ * Får även anropas från hög-prioritets-ISR:en (tidsstämplar för I2C-händelser).
+ */
+uint16_t SCHEDULER_Millis(void);
+
+/**
+ * @brief Kör alla tasks vars deadline har passerat och lägger sedan CPU:n i Idle
+ * tills nästa avbrott (tick, UART, I2C). Anropas i en evig loop från main().
+ * Tiden mellan två varv och taskernas körtider publiceras via perf.c.
+ */
+void SCHEDULER_RunPass(scheduler_task_t *tasks, uint8_t count);
+
+/**
+ * @brief Flyttar nästa körning för den task som körs just nu till delay_ms från nu.
+ * Används av tillståndsmaskiner som väntar på hårdvara (t.ex. DS18B20-konvertering)
+ * istället för att räkna anrop.
+ */
+void SCHEDULER_Defer(uint16_t delay_ms);
+
+#endif // SCHEDULER_H
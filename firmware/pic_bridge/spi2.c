@@ -65,3 +65,20 @@ void SPI2_WriteWiper_Pot1(uint8_t wiper_value) {
     
     DP_CS_PIN = 1; // Deaktivera Chip Select (CS High)
 }
+
+
+// Läser wiper-värdet (0-256) från angiven Digipot. Kräver inkopplad SDI2.
+uint16_t SPI2_ReadWiper(uint8_t pot_address) {
+    uint8_t command = pot_address | CMD_READ_DATA;
+    uint8_t high, low;
+    
+    DP_CS_PIN = 0; // Aktivera Chip Select (CS Low)
+    
+    // Kommando-byten returnerar D8 i bit 0, dummy-byten D7..D0
+    high = SPI2_Write_Byte(command);
+    low = SPI2_Write_Byte(0xFF);
+    
+    DP_CS_PIN = 1; // Deaktivera Chip Select (CS High)
+    
+    return (uint16_t)(((high & 0x01) << 8) | low);
+}
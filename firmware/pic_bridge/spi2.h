@@ -13,4 +13,7 @@ uint8_t SPI2_Write_Byte(uint8_t data);
 void SPI2_WriteWiper_Pot0(uint8_t wiper_value); // Innegivare
 void SPI2_WriteWiper_Pot1(uint8_t wiper_value); // Utetgivare
 
+// Läser tillbaka wiper-värdet (0-256) från en Digipot (ADDR_POT_0 / ADDR_POT_1)
+uint16_t SPI2_ReadWiper(uint8_t pot_address);
+
 #endif // SPI2_H
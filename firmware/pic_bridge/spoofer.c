@@ -1,19 +1,9 @@
 #include "spoofer.h"
 #include "globals.h"
 #include "spi2.h" // Använd HW SPI2
-
-/* Funktionen SPOOFER_Write är inte längre nödvändig då spi2.c exponerar Pot0 och Pot1 direkt */
-    
-    DP_CS_PIN = 0; // Aktivera Chip Select (CS Low)
-    
-    // Skriv Kommando-byte
-    SPI_Write_Byte(command); 
-    
-    // Skriv Data-byte (värde 0-255)
-    SPI_Write_Byte(value); 
-    
-    DP_CS_PIN = 1; // Deaktivera Chip Select (CS High)
-}
+#include "regmap.h"
+#include "scheduler.h"
+#include "adc.h"
 
 // --- NTC LOOKUP TABELLER (Motstånd i Ohm * 100) ---
 
@@ -25,20 +15,22 @@ const int32_t RES_150OHM_100X[] = {328900L, 247800L, 188400L, 144400L, 111500L,
 // Interpolationsdata (förenklad kurva baserat på 22k NTC Beta=3950K)
 const int32_t RES_22KOHM_100X[] = {1715000L, 1200000L, 850000L, 600000L, 430000L, 310000L, 225000L, 165000L, 122000L, 91000L, 68000L, 51000L, 38500L, 29200L, 22200L, 17000L, 13100L, 10100L, 7800L};
 
-// Konverterar motstånd (Ohm * 100) till temperatur (°C * 100)
-int16_t ResistanceToTemp_100x(int32_t resistance_100x) {
-    const int32_t *res_table;
-    uint8_t i;
-    
-    // Välj kurva baserat på globalt register
-    if (registerMap[REG_NTC_CURVE_SELECT] == 0) { // 0 = 22 kOhm
-        res_table = RES_22KOHM_100X;
-    } else { // 1 = 150 Ohm (Default)
-        res_table = RES_150OHM_100X;
+#define NTC_POINTS (sizeof(TEMP_INDEX) / sizeof(TEMP_INDEX[0]))
+
+// Väljer kurva baserat på globalt register
+static const int32_t *ntc_curve(uint8_t curve_select) {
+    if (curve_select == 0) { // 0 = 22 kOhm
+        return RES_22KOHM_100X;
     }
+    return RES_150OHM_100X; // 1 = 150 Ohm (Default)
+}
+
+// Linjär interpolation i en fallande motståndstabell
+static int16_t ntc_resistance_to_temp_100x(int32_t resistance_100x, const int32_t *res_table) {
+    uint8_t i;
 
     // Leta upp motståndet i tabellen (tabellen är fallande)
-    for (i = 0; i < sizeof(TEMP_INDEX) / sizeof(TEMP_INDEX[0]) - 1; i++) {
+    for (i = 0; i < NTC_POINTS - 1; i++) {
         if (resistance_100x >= res_table[i+1] && resistance_100x <= res_table[i]) {
             // Linjär interpolation mellan index i och i+1
             int16_t t1 = TEMP_INDEX[i];
@@ -60,96 +52,333 @@ int16_t ResistanceToTemp_100x(int32_t resistance_100x) {
     // Utanför intervall (-40.00C)
     if (resistance_100x > res_table[0]) return TEMP_INDEX[0];
     // Utanför intervall (+50.00C)
-    if (resistance_100x < res_table[sizeof(TEMP_INDEX) / sizeof(TEMP_INDEX[0]) - 1]) return TEMP_INDEX[sizeof(TEMP_INDEX) / sizeof(TEMP_INDEX[0]) - 1];
+    if (resistance_100x < res_table[NTC_POINTS - 1]) return TEMP_INDEX[NTC_POINTS - 1];
 
     return 9999; // Felvärde
 }
 
-// Konverterar temperatur (°C * 100) till Wiper-värde (0-255)
-// Använder omvänd interpolation för att hitta motsvarande motstånd
-// Antar en 10kOhm Digipot (256 steg) i spänningsdelare mot 10kOhm (R_fix)
+// Konverterar motstånd (Ohm * 100) till temperatur (°C * 100)
+int16_t ResistanceToTemp_100x(int32_t resistance_100x) {
+    return ntc_resistance_to_temp_100x(resistance_100x, ntc_curve(registerMap[REG_NTC_CURVE_SELECT]));
+}
+
+// --- WIPER -> TEMPERATUR (MCP4251) ---
+// Tabellen anger vilken temperatur pumpen ser för varje wiper-värde med vald
+// NTC-kurva. Den byggs om (i delar, se SPOOFER_Process) bara när
+// REG_NTC_CURVE_SELECT ändras; varje uppslag blir sedan en binärsökning.
+#define WIPER_STEPS             256
+#define WIPER_TABLE_CHUNK       32   // Poster som beräknas per SPOOFER_Process-anrop
+#define WIPER_TABLE_INVALID     0xFF // Ingen kurva byggd ännu
+
+static int16_t wiper_temp_100x[WIPER_STEPS]; // Icke-stigande med wiper-värdet
+static uint8_t wiper_table_curve = WIPER_TABLE_INVALID;
+static uint16_t wiper_table_fill = 0; // Antal färdiga poster i pågående bygge
+static uint8_t wiper_table_building_curve = WIPER_TABLE_INVALID;
+
+// Resistansen pumpen ser (Ohm * 100) vid ett visst wiper-värde
+static int32_t wiper_resistance_100x(uint8_t wiper) {
+    // Reostat B-W: R_BW = R_W + R_AB * N / 256
+    int32_t r = SPOOF_POT_R_WIPER_100X + (SPOOF_POT_R_AB_100X * wiper) / WIPER_STEPS;
+
+#if SPOOF_R_PARALLEL_100X > 0
+    // Räknas i hela Ohm så att produkten ryms i 32 bitar
+    r = ((r / 100) * (SPOOF_R_PARALLEL_100X / 100) / ((r + SPOOF_R_PARALLEL_100X) / 100)) * 100;
+#endif
+    return r + SPOOF_R_SERIES_100X;
+}
+
+// Bygger tabellen stegvis. Returnerar true när tabellen för vald kurva är klar.
+static bool wiper_table_update(void) {
+    uint8_t curve = registerMap[REG_NTC_CURVE_SELECT] ? 1 : 0;
+
+    if (curve == wiper_table_curve) {
+        return true;
+    }
+    if (curve != wiper_table_building_curve) {
+        // Ny kurva (eller kurvan byttes mitt i ett bygge): börja om
+        wiper_table_building_curve = curve;
+        wiper_table_fill = 0;
+    }
+
+    const int32_t *res_table = ntc_curve(curve);
+    uint16_t end = wiper_table_fill + WIPER_TABLE_CHUNK;
+    if (end > WIPER_STEPS) end = WIPER_STEPS;
+    for (; wiper_table_fill < end; wiper_table_fill++) {
+        uint8_t w = (uint8_t)wiper_table_fill;
+        wiper_temp_100x[w] = ntc_resistance_to_temp_100x(wiper_resistance_100x(w), res_table);
+    }
+    if (wiper_table_fill >= WIPER_STEPS) {
+        wiper_table_curve = curve;
+        return true;
+    }
+    return false;
+}
+
+// Konverterar temperatur (°C * 100) till Wiper-värde (0-255).
+// Binärsökning i wiper_temp_100x: närmaste wiper-värde till måltemperaturen.
 static uint8_t TempToWiper(int16_t temp_100x) {
-    const int32_t R_FIX_OHM = 10000;
-    int32_t target_res_100x;
-    const int32_t *res_table;
-    
-    // Välj kurva baserat på globalt register
-    if (registerMap[REG_NTC_CURVE_SELECT] == 0) { // 0 = 22 kOhm
-        res_table = RES_22KOHM_100X;
-    } else { // 1 = 150 Ohm (Default)
-        res_table = RES_150OHM_100X;
+    uint16_t lo = 0;
+    uint16_t hi = WIPER_STEPS - 1;
+
+    // Minsta wiper-värde vars temperatur är <= målet
+    if (temp_100x < wiper_temp_100x[WIPER_STEPS - 1]) {
+        return WIPER_STEPS - 1; // Kallare än potten klarar
+    }
+    while (lo < hi) {
+        uint16_t mid = (lo + hi) >> 1;
+        if (wiper_temp_100x[mid] <= temp_100x) {
+            hi = mid;
+        } else {
+            lo = mid + 1;
+        }
     }
 
-    // Använd interpolationslogiken från ResistanceToTemp_100x (med temp_100x som input)
-    // Denna del är förenklad för att undvika dubbel interpolation och använder en direkt lookup:
-    
-    // Sök efter motståndet som matchar måltemperaturen (förenklat)
-    target_res_100x = 15000L; // <-- Plachållare, kräver full omvänd interpolation
+    // Grannen under kan ligga närmare målet
+    if (lo > 0 && (wiper_temp_100x[lo - 1] - temp_100x) < (temp_100x - wiper_temp_100x[lo])) {
+        lo--;
+    }
+    return (uint8_t)lo;
+}
 
-    // Antag att digipoten simulerar NTC-givaren direkt (R_ntc = R_pot).
-    // R_pot = 10000 Ohm. Wiper_Value = R_target * 256 / 10000 Ohm
-    
-    // WIPER_VALUE = R_target_ohm * 256 / 10000
-    // Eftersom R_target är *100, blir formeln:
-    // WIPER_VALUE = (R_target_100x / 100) * 256 / 10000
-    // WIPER_VALUE = (R_target_100x * 256) / 1000000
-    
-    // *Observera: Denna fullständiga omvända interpolation saknas fortfarande.*
-    // För att få igång funktionen används en linjär approximation för 150 Ohm NTC (max 1000 Ohm @ -20C)
-    // Wiper value = (10000 - R_target) / 10000 * 255.
-    // Enkel Approximation:
-    int32_t wiper_val = 128; // Standard 25C (150 Ohm)
-    
-    return (uint8_t)wiper_val;
+// Lagrar temperaturen som pumpen faktiskt ser med valt wiper-värde
+static void store_spoofed_temp(uint8_t hi_reg, uint8_t wiper) {
+    REGMAP_WriteWord(hi_reg, (uint16_t)wiper_temp_100x[wiper]);
+}
+
+// --- UTGÅNGSSTEG ---
+// Senast skrivna värden cachas så att SPI2 och reläerna bara rörs när målet
+// ändras. WIPER_UNKNOWN tvingar fram en skrivning (efter start eller fel vid
+// verifiering).
+#define WIPER_UNKNOWN   0xFFFF
+#define RELAYS_UNKNOWN  0xFF
+#define WIPER_DEFAULT   128 // 50% resistans
+
+static uint16_t committed_wiper_in = WIPER_UNKNOWN;  // Pot 0
+static uint16_t committed_wiper_out = WIPER_UNKNOWN; // Pot 1
+static uint8_t committed_relays = RELAYS_UNKNOWN;
+
+static void output_write_wiper(uint8_t pot_address, uint8_t value) {
+    if (pot_address == ADDR_POT_0) {
+        SPI2_WriteWiper_Pot0(value);
+    } else {
+        SPI2_WriteWiper_Pot1(value);
+    }
+}
+
+// Skriver wipern om den skiljer sig från senast bekräftade värde
+static void output_set_wiper(uint16_t *committed, uint8_t pot_address, uint8_t value) {
+    if (*committed == value) {
+        return;
+    }
+    output_write_wiper(pot_address, value);
+#if SPOOFER_VERIFY_WIPERS
+    if (SPI2_ReadWiper(pot_address) != value) {
+        registerMap[REG_SPOOF_WIPER_VERIFY_ERRORS]++;
+        *committed = WIPER_UNKNOWN; // Försök igen nästa anrop
+        return;
+    }
+#endif
+    *committed = value;
+}
+
+static void output_set_relays(uint8_t relay_state) {
+    relay_state &= 0x07;
+    if (relay_state == committed_relays) {
+        return;
+    }
+    RELAY_HEAT_PUMP_ON = (relay_state & 0x01);
+    RELAY_PUMP_1_ON    = (relay_state & 0x02) >> 1;
+    RELAY_PUMP_2_ON    = (relay_state & 0x04) >> 2;
+    committed_relays = relay_state;
+}
+
+// --- SLUTEN REGLERING (SPOOFER_CLOSED_LOOP) ---
+// PI-regulatorn arbetar i temperatur: trimmen läggs på målet före tabelluppslaget,
+// så tabellen ger det snabba hoppet vid ett målbyte och trimmen tar bort det som
+// skiljer tabellen från verkligheten (pottens tolerans, ledningar, pumpens ingång).
+// Trimmen behålls över målbyten eftersom felet mest beror på hårdvaran.
+#if SPOOFER_CLOSED_LOOP
+
+#if SPOOFER_PI_PERIOD_MS < 3 * ADC_TASK_PERIOD_MS
+#error "SPOOFER_PI_PERIOD_MS måste vara minst 3 * ADC_TASK_PERIOD_MS"
+#endif
+
+typedef struct {
+    uint8_t measured_hi_reg; // REG_ADC_NTC_*_HI
+    uint8_t error_hi_reg;    // REG_SPOOF_ERROR_*_HI
+    uint8_t settle_hi_reg;   // REG_SPOOF_SETTLE_*_MS_HI
+    int16_t target;          // Mål vid förra anropet (°C * 100)
+    int32_t integral;        // °C * 100 * 256
+    int16_t trim;            // Läggs på målet före TempToWiper
+    uint16_t stamp_ms;       // Senaste tidpunkt som räknats in i elapsed_ms
+    uint16_t elapsed_ms;     // Sedan målet ändrades, stannar på 0xFFFF
+    bool tracking;           // false efter loop_reset: nästa mål räknas som nytt
+    bool settled;
+} spoof_loop_t;
+
+static spoof_loop_t loop_out = { REG_ADC_NTC_OUTDOOR_HI, REG_SPOOF_ERROR_OUTDOOR_HI, REG_SPOOF_SETTLE_OUTDOOR_MS_HI, 0, 0, 0, 0, 0, false, false };
+static spoof_loop_t loop_in  = { REG_ADC_NTC_INDOOR_HI,  REG_SPOOF_ERROR_INDOOR_HI,  REG_SPOOF_SETTLE_INDOOR_MS_HI,  0, 0, 0, 0, 0, false, false };
+static uint16_t loop_last_ms = 0;
+
+static int32_t clamp32(int32_t value, int32_t limit) {
+    if (value > limit) return limit;
+    if (value < -limit) return -limit;
+    return value;
+}
+
+// Felmarginal vid ett wiper-värde: 3/4 av steget till grannen (bättre än så kan
+// potten inte träffa, och då står integratorn still i stället för att pendla)
+static int16_t loop_tolerance(uint8_t wiper) {
+    int16_t step = (wiper < WIPER_STEPS - 1)
+                   ? wiper_temp_100x[wiper] - wiper_temp_100x[wiper + 1]
+                   : wiper_temp_100x[wiper - 1] - wiper_temp_100x[wiper];
+    int16_t tolerance = (int16_t)((step * 3) / 4);
+    return (tolerance < SPOOFER_PI_TOLERANCE) ? SPOOFER_PI_TOLERANCE : tolerance;
+}
+
+// Nytt mål (eller spoofingen slogs på igen): insvängningstiden mäts om, trimmen behålls.
+// Wipern flyttas nu, så nästa reglersteg väntar en hel period på en mätning som är
+// tagen efter skrivningen.
+static void loop_track_target(spoof_loop_t *loop, int16_t target) {
+    if (loop->tracking && target == loop->target) {
+        return;
+    }
+    loop->tracking = true;
+    loop->target = target;
+    loop->stamp_ms = SCHEDULER_Millis();
+    loop->elapsed_ms = 0;
+    loop->settled = false;
+    loop_last_ms = loop->stamp_ms;
+}
+
+// Tiden sedan målbytet. Räknas upp i steg om en reglerperiod så att den mättar i
+// stället för att slå runt med SCHEDULER_Millis() efter 65.5 s.
+static uint16_t loop_elapsed(spoof_loop_t *loop) {
+    uint16_t now = SCHEDULER_Millis();
+    uint16_t step = (uint16_t)(now - loop->stamp_ms);
+
+    loop->stamp_ms = now;
+    loop->elapsed_ms = (step > UINT16_MAX - loop->elapsed_ms) ? UINT16_MAX : loop->elapsed_ms + step;
+    return loop->elapsed_ms;
+}
+
+static void loop_update(spoof_loop_t *loop, uint16_t wiper) {
+    int16_t measured = (int16_t)((registerMap[loop->measured_hi_reg] << 8) | registerMap[loop->measured_hi_reg + 1]);
+    int32_t error = (int32_t)loop->target - measured;
+    uint16_t elapsed = loop_elapsed(loop);
+
+    REGMAP_WriteWord(loop->error_hi_reg, (uint16_t)clamp32(error, INT16_MAX));
+    if (wiper == WIPER_UNKNOWN) {
+        return; // Wipern skrevs inte (verifieringsfel): mätningen hör inte till något känt läge
+    }
+
+    if (error <= loop_tolerance((uint8_t)wiper) && error >= -loop_tolerance((uint8_t)wiper)) {
+        if (!loop->settled) {
+            loop->settled = true;
+            REGMAP_WriteWord(loop->settle_hi_reg, elapsed);
+        }
+        return;
+    }
+    if (!loop->settled) {
+        REGMAP_WriteWord(loop->settle_hi_reg, elapsed); // Räknar tills felet är inom marginalen
+    }
+
+    // Varmare (lägre wiper) eller kallare än potten klarar: integrera inte vidare (anti-windup)
+    bool saturated = (error > 0 && wiper == 0) || (error < 0 && wiper == WIPER_STEPS - 1);
+    if (!saturated) {
+        loop->integral = clamp32(loop->integral + error * SPOOFER_PI_KI_Q8, (int32_t)SPOOFER_PI_TRIM_MAX << 8);
+    }
+    loop->trim = (int16_t)clamp32((error * SPOOFER_PI_KP_Q8 + loop->integral) >> 8, SPOOFER_PI_TRIM_MAX);
+}
+
+static void loop_reset(spoof_loop_t *loop) {
+    loop->integral = 0;
+    loop->trim = 0;
+    loop->tracking = false;
+    loop->settled = false;
+}
+
+// Mål + trim, begränsat till int16
+static int16_t loop_setpoint(const spoof_loop_t *loop) {
+    return (int16_t)clamp32((int32_t)loop->target + loop->trim, INT16_MAX);
 }
 
+#endif // SPOOFER_CLOSED_LOOP
+
 void SPOOFER_Init(void) {
     SPI2_Init(); // Initiera HW SPI2
     
-    RELAY_HEAT_PUMP_ON = 0;
-    RELAY_PUMP_1_ON = 0;
-    RELAY_PUMP_2_ON = 0;
+    // Reläer och mål kommer från NVM_Init (nollor om journalen är tom)
+    committed_relays = RELAYS_UNKNOWN;
+    output_set_relays(registerMap[REG_RELAY_CONTROL]);
     
     DP_SHDN_PIN = 0; // Shutdown Low (Normal drift)
     DP_CS_PIN = 1;   // CS High (Inaktiv)
     
-    // Sätt initiala värden (50% resistans)
-    SPI2_WriteWiper_Pot0(128);
-    SPI2_WriteWiper_Pot1(128);
+    committed_wiper_in = WIPER_UNKNOWN;
+    committed_wiper_out = WIPER_UNKNOWN;
+    if (registerMap[REG_SPOOFING_ENABLED] == 1) {
+        // Återställd spoofing: hela tabellen byggs nu (före I2C_Init) så att
+        // pumpen ser målen från start och inte 50% under uppbyggnaden
+        while (!wiper_table_update());
+        SPOOFER_Process();
+    } else {
+        // Sätt initiala värden (50% resistans)
+        output_set_wiper(&committed_wiper_in, ADDR_POT_0, WIPER_DEFAULT);
+        output_set_wiper(&committed_wiper_out, ADDR_POT_1, WIPER_DEFAULT);
+    }
 }
 
 void SPOOFER_Process(void) {
     uint8_t wiper_out, wiper_in;
     int16_t target_out_temp, target_in_temp;
     
-    // --- 1. Uppdatera Reläer ---
-    uint8_t relay_state = registerMap[REG_RELAY_CONTROL];
-    
-    RELAY_HEAT_PUMP_ON = (relay_state & 0x01);
-    RELAY_PUMP_1_ON    = (relay_state & 0x02) >> 1;
-    RELAY_PUMP_2_ON    = (relay_state & 0x04) >> 2;
+    // --- 1. Uppdatera Reläer (endast vid ändring) ---
+    output_set_relays(registerMap[REG_RELAY_CONTROL]);
     
     // --- 2. Uppdatera Spoofing (Digipots) ---
     if (registerMap[REG_SPOOFING_ENABLED] == 1) {
+        // Medan tabellen byggs om ligger potarna kvar på sina gamla värden
+        if (!wiper_table_update()) {
+            return;
+        }
         
         // Hämta måltemperaturer (16-bitars, * 100)
         target_out_temp = (registerMap[REG_TARGET_OUTDOOR_TEMP_HI] << 8) | registerMap[REG_TARGET_OUTDOOR_TEMP_LO];
         target_in_temp = (registerMap[REG_TARGET_INDOOR_TEMP_HI] << 8) | registerMap[REG_TARGET_INDOOR_TEMP_LO];
 
+#if SPOOFER_CLOSED_LOOP
+        loop_track_target(&loop_out, target_out_temp);
+        loop_track_target(&loop_in, target_in_temp);
+        // Fast takt: mätningen från ADC:n hör till förra periodens wiper-värden
+        if ((uint16_t)(SCHEDULER_Millis() - loop_last_ms) >= SPOOFER_PI_PERIOD_MS) {
+            loop_last_ms = SCHEDULER_Millis();
+            loop_update(&loop_out, committed_wiper_out);
+            loop_update(&loop_in, committed_wiper_in);
+        }
+        target_out_temp = loop_setpoint(&loop_out);
+        target_in_temp = loop_setpoint(&loop_in);
+#endif
+
         // Konvertera temperatur till wiper-värde
-        // *OBS: TempToWiper behöver fullständig implementering*
         wiper_out = TempToWiper(target_out_temp);
         wiper_in  = TempToWiper(target_in_temp);
+        store_spoofed_temp(REG_SPOOF_ACTUAL_OUTDOOR_HI, wiper_out);
+        store_spoofed_temp(REG_SPOOF_ACTUAL_INDOOR_HI, wiper_in);
         
-        // Skriv till Digipots
-        SPI2_WriteWiper_Pot1(wiper_out); // Utetemp (Pot 1)
-        SPI2_WriteWiper_Pot0(wiper_in);  // Innetemp (Pot 0)
+        // Skriv till Digipots (endast vid ändring)
+        output_set_wiper(&committed_wiper_out, ADDR_POT_1, wiper_out); // Utetemp (Pot 1)
+        output_set_wiper(&committed_wiper_in, ADDR_POT_0, wiper_in);   // Innetemp (Pot 0)
     } else {
         // Om Spoofing är av, sätt Digipots till max resistans för att 
         // minimera påverkan (eller sätt dem till ett säkert defaultvärde)
         // Eller, om hårdvaran tillåter: koppla bort Digipots helt
         // För nu: sätt till säkert default
-        SPI2_WriteWiper_Pot1(128); 
-        SPI2_WriteWiper_Pot0(128);
+        output_set_wiper(&committed_wiper_out, ADDR_POT_1, WIPER_DEFAULT);
+        output_set_wiper(&committed_wiper_in, ADDR_POT_0, WIPER_DEFAULT);
+#if SPOOFER_CLOSED_LOOP
+        loop_reset(&loop_out);
+        loop_reset(&loop_in);
+#endif
     }
 }
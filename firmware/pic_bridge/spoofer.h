@@ -17,15 +17,48 @@
 // --- MCP4251 Kommandon ---
 #define CMD_WRITE_DATA      0b00000000
 #define CMD_WRITE_TCON      0b01000000
-// Övriga kommandon (läs) behövs inte för skrivoperationer
+#define CMD_READ_DATA       0b00001100 // Används för verifiering av wiper (SPOOFER_VERIFY_WIPERS)
 
 // --- Adresser för Potentiometrar ---
 #define ADDR_POT_0          0b00000000 // Potentiometer 0 (Wiper 0)
 #define ADDR_POT_1          0b00010000 // Potentiometer 1 (Wiper 1)
 
+// --- Resistansnät mot pumpens NTC-ingång (Ohm * 100) ---
+// Potten används som reostat (B-W): R = R_W + R_AB * N / 256.
+// Valfritt parallellmotstånd över potten och seriemotstånd mot pumpen (0 = ej monterat).
+#define SPOOF_POT_R_AB_100X     1000000L // MCP4251-103: 10 kOhm
+#define SPOOF_POT_R_WIPER_100X  7500L    // Typisk wiper-resistans 75 Ohm
+#define SPOOF_R_PARALLEL_100X   0L
+#define SPOOF_R_SERIES_100X     0L
+
+// Läs tillbaka wipern efter varje skrivning och skriv om vid avvikelse.
+// Kräver att SDO från MCP4251 är inkopplad och mappad till SDI2 (SSP2DATPPS).
+#define SPOOFER_VERIFY_WIPERS   0
+
+// Sluten spoofing: en PI-regulator trimmar målet som slås upp i wiper-tabellen tills
+// temperaturen som mäts på ADC-kanalen (adc.c) når målet. Kräver att ADC-ingångarna
+// mäter den spoofade givarnoden (potten mot R_FIX i adc.c) i stället för de riktiga
+// NTC:erna. Fel och insvängningstid publiceras i REG_SPOOF_ERROR_* och REG_SPOOF_SETTLE_*_MS.
+#ifndef SPOOFER_CLOSED_LOOP
+#define SPOOFER_CLOSED_LOOP     0
+#endif
+
+// Reglerperiod: minst 3 * ADC_TASK_PERIOD_MS, så att varje mätning är tagen efter
+// förra wiper-skrivningen (kanalerna mäts växelvis, resultatet läses en period senare)
+#define SPOOFER_PI_PERIOD_MS    1000
+#define SPOOFER_PI_KP_Q8        64    // 0.25 (fel -> trim, 1/256)
+#define SPOOFER_PI_KI_Q8        128   // 0.5 per period
+#define SPOOFER_PI_TRIM_MAX     1000  // Största trim, °C * 100
+#define SPOOFER_PI_TOLERANCE    10    // Minsta felmarginal (°C * 100); annars 3/4 wiper-steg
+
+// Schemaläggarens period för SPOOFER_Process
+#define SPOOFER_TASK_PERIOD_MS 20
+
 // --- Funktioner ---
 void SPOOFER_Init(void);
 void SPOOFER_Process(void);
-void SPOOFER_Write(uint8_t address, uint8_t value);
+
+// Konverterar motstånd (Ohm * 100) till temperatur (°C * 100) med vald NTC-kurva
+int16_t ResistanceToTemp_100x(int32_t resistance_100x);
 
 #endif // SPOOFER_H
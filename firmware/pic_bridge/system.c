@@ -5,6 +5,8 @@ void SYSTEM_Initialize(void) {
     OSCFRQ = 0x08;  // 64 MHz
     OSCCON1 = 0x60; // HFINTOSC (Internal Oscillator)
     PIN_MANAGER_Initialize();
+    INTCON0bits.IPEN = 1; // Två prioritetsnivåer: I2C hög, UART/Timer låg
+    INTCON0bits.GIEL = 1; // Low Priority Interrupt Enable
     INTCON0bits.GIE = 1; // Global Interrupt Enable
 }
 
@@ -0,0 +1,123 @@
+#!/usr/bin/env python3
+"""
+Avkodar den tokeniserade loggen från UART3 (log.c) till text.
+
+Meddelande-ID och formatsträngar läses ur log_tokens.h (ID = radens ordning i
+LOG_TOKENS), så verktyget följer alltid firmwaren i samma checkout.
+
+    python3 tools/detokenize.py logg.bin             (från firmware/pic_bridge)
+    python3 tools/detokenize.py /dev/ttyUSB0         (läser tills Ctrl-C; sätt 115200 raw med stty)
+
+Ram: 0xA5, ID, antal argument, tid LO, tid HI (ms), argument (int16 LO/HI).
+"""
+import os
+import re
+import sys
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+TOKENS_H = os.path.join(os.path.dirname(HERE), "log_tokens.h")
+
+LOG_SYNC = 0xA5
+FRAME_OVERHEAD = 5
+
+TOKEN_RE = re.compile(r'X\(\s*(\w+)\s*,\s*(\d+)\s*,\s*"((?:[^"\\]|\\.)*)"\s*\)')
+SPEC_RE = re.compile(r"%[-+ 0#]*\d*([dux])")
+
+
+def load_tokens(path):
+    with open(path, encoding="utf-8") as f:
+        source = f.read()
+    m = re.search(r"#define\s+LOG_TOKENS\(X\)(.*?)\n\s*\n", source, re.S)
+    if not m:
+        sys.exit("detokenize: hittar inte LOG_TOKENS i %s" % path)
+    tokens = [(name, int(argc), fmt) for name, argc, fmt in TOKEN_RE.findall(m.group(1))]
+    if not tokens:
+        sys.exit("detokenize: inga meddelanden i LOG_TOKENS")
+    return tokens
+
+
+def format_message(fmt, args):
+    """Sätter in int16-argumenten; %u och %x visas osignerade."""
+    values = []
+    for spec, value in zip(SPEC_RE.finditer(fmt), args):
+        if spec.group(1) in "ux":
+            value &= 0xFFFF
+        values.append(value)
+    try:
+        return fmt % tuple(values)
+    except (TypeError, ValueError):
+        return "%s %s" % (fmt, args)
+
+
+def int16(lo, hi):
+    value = lo | (hi << 8)
+    return value - 0x10000 if value & 0x8000 else value
+
+
+class Decoder:
+    def __init__(self, tokens):
+        self.tokens = tokens
+        self.buf = bytearray()
+        self.ms = None      # Förlängd millisekundtick (slår runt efter 65.5 s i PIC:en)
+        self.last_tick = 0
+        self.skipped = 0
+
+    def feed(self, data):
+        self.buf += data
+        lines = []
+        while True:
+            start = self.buf.find(LOG_SYNC)
+            if start < 0:
+                self.skipped += len(self.buf)
+                self.buf.clear()
+                break
+            self.skipped += start
+            del self.buf[:start]
+            if len(self.buf) < FRAME_OVERHEAD:
+                break
+            msg_id, argc = self.buf[1], self.buf[2]
+            # Ogiltig ram (t.ex. bussfångst eller avbruten ram): synka om på nästa 0xA5
+            if msg_id >= len(self.tokens) or argc != self.tokens[msg_id][1]:
+                self.skipped += 1
+                del self.buf[:1]
+                continue
+            size = FRAME_OVERHEAD + 2 * argc
+            if len(self.buf) < size:
+                break
+            tick = self.buf[3] | (self.buf[4] << 8)
+            args = [int16(self.buf[FRAME_OVERHEAD + 2 * i], self.buf[FRAME_OVERHEAD + 2 * i + 1])
+                    for i in range(argc)]
+            del self.buf[:size]
+            lines.append(self.line(tick, msg_id, args))
+        return lines
+
+    def line(self, tick, msg_id, args):
+        if self.ms is None:
+            self.ms = tick
+        else:
+            self.ms += (tick - self.last_tick) & 0xFFFF
+        self.last_tick = tick
+        name, _, fmt = self.tokens[msg_id]
+        return "[%10.3f] %s" % (self.ms / 1000.0, format_message(fmt, args))
+
+
+def main():
+    if len(sys.argv) != 2:
+        sys.exit("Användning: detokenize.py logg.bin|/dev/ttyX")
+    decoder = Decoder(load_tokens(TOKENS_H))
+    try:
+        with open(sys.argv[1], "rb", buffering=0) as f:
+            while True:
+                chunk = f.read(256)
+                if not chunk:
+                    break
+                for line in decoder.feed(chunk):
+                    print(line, flush=True)
+    except KeyboardInterrupt:
+        pass
+    if decoder.skipped:
+        print("detokenize: %d bytes utan giltig ram hoppades över" % decoder.skipped, file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,124 @@
+#!/usr/bin/env python3
+"""
+Genererar ntc_table.c: ADC-kod (0-1023) -> temperatur (°C * 100) per NTC-kurva.
+
+Kurvpunkterna (TEMP_INDEX, RES_150OHM_100X, RES_22KOHM_100X) läses direkt ur
+spoofer.c så att tabellerna alltid följer samma data. Varje tabellpost räknas
+fram med exakt samma heltalsaritmetik som calculate_ntc_resistance() (adc.c)
+och ResistanceToTemp_100x() (spoofer.c), så resultatet är bitidentiskt med den
+gamla beräkningen. Värdbänkens scenario ntc_table (host/, pic_bridge_bench ntc_table)
+kontrollerar alla koder för båda kurvorna mot ResistanceToTemp_100x() och mäter
+tiden per sampel för båda vägarna.
+
+Kör om efter ändringar i kurvorna eller spänningsdelaren:
+    python3 tools/gen_ntc_table.py            (från firmware/pic_bridge)
+    python3 tools/gen_ntc_table.py --check    (avvikelse mot genererad fil -> exit 1)
+"""
+import os
+import re
+import sys
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+SRC_DIR = os.path.dirname(HERE)
+SPOOFER_C = os.path.join(SRC_DIR, "spoofer.c")
+OUTPUT_C = os.path.join(SRC_DIR, "ntc_table.c")
+
+# Måste matcha adc.c
+R_FIX_OHM_100X = 1000000
+ADC_CODES = 1024
+RESISTANCE_MAX_100X = 5000000
+
+
+def c_div(a, b):
+    """Heltalsdivision med C-semantik (trunkering mot noll)."""
+    q = abs(a) // abs(b)
+    return q if (a >= 0) == (b >= 0) else -q
+
+
+def parse_array(source, name):
+    m = re.search(r"\b" + name + r"\[\]\s*=\s*\{([^}]*)\}", source)
+    if not m:
+        sys.exit("gen_ntc_table: hittar inte %s i spoofer.c" % name)
+    return [int(v.strip().rstrip("Ll")) for v in m.group(1).split(",") if v.strip()]
+
+
+def calculate_ntc_resistance(adc_raw):
+    if adc_raw == 0:
+        return RESISTANCE_MAX_100X
+    resistance_100x = c_div(R_FIX_OHM_100X * 1024, adc_raw) - R_FIX_OHM_100X
+    return min(resistance_100x, RESISTANCE_MAX_100X)
+
+
+def resistance_to_temp_100x(resistance_100x, temps, res_table):
+    for i in range(len(temps) - 1):
+        if res_table[i + 1] <= resistance_100x <= res_table[i]:
+            t1, t2 = temps[i], temps[i + 1]
+            r1, r2 = res_table[i], res_table[i + 1]
+            if r2 == r1:
+                return t1
+            return t1 + c_div((t2 - t1) * (resistance_100x - r1), r2 - r1)
+    if resistance_100x > res_table[0]:
+        return temps[0]
+    return temps[-1]
+
+
+def build_table(temps, res_table):
+    return [resistance_to_temp_100x(calculate_ntc_resistance(code), temps, res_table)
+            for code in range(ADC_CODES)]
+
+
+def format_table(name, comment, values):
+    lines = ["// " + comment, "const int16_t %s[NTC_TABLE_SIZE] = {" % name]
+    for row in range(0, len(values), 12):
+        chunk = values[row:row + 12]
+        lines.append("    " + ", ".join("%d" % v for v in chunk) + ",")
+    lines[-1] = lines[-1].rstrip(",")
+    lines.append("};")
+    return "\n".join(lines)
+
+
+def generate():
+    with open(SPOOFER_C, encoding="utf-8") as f:
+        source = f.read()
+    temps = parse_array(source, "TEMP_INDEX")
+    res_150 = parse_array(source, "RES_150OHM_100X")
+    res_22k = parse_array(source, "RES_22KOHM_100X")
+
+    parts = [
+        "// GENERERAD FIL - ändra inte för hand.",
+        "// Skapad av tools/gen_ntc_table.py från kurvorna i spoofer.c.",
+        "// Index = ADC-kod (0-1023, R_fix 10 kOhm mot VDD), värde = temperatur °C * 100.",
+        "",
+        "#include \"ntc_table.h\"",
+        "",
+        format_table("NTC_TABLE_150OHM", "150 Ohm NTC (REG_NTC_CURVE_SELECT = 1)",
+                     build_table(temps, res_150)),
+        "",
+        format_table("NTC_TABLE_22KOHM", "22 kOhm NTC (REG_NTC_CURVE_SELECT = 0)",
+                     build_table(temps, res_22k)),
+        "",
+    ]
+    return "\n".join(parts)
+
+
+def main():
+    content = generate()
+    if "--check" in sys.argv[1:]:
+        try:
+            with open(OUTPUT_C, encoding="utf-8") as f:
+                current = f.read()
+        except FileNotFoundError:
+            current = ""
+        if current != content:
+            print("ntc_table.c är inte aktuell, kör tools/gen_ntc_table.py")
+            return 1
+        print("ntc_table.c är aktuell")
+        return 0
+    with open(OUTPUT_C, "w", encoding="utf-8", newline="\n") as f:
+        f.write(content)
+    print("Skrev %s" % os.path.relpath(OUTPUT_C))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
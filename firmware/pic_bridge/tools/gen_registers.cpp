@@ -0,0 +1,998 @@
+// Genererar registerlayouten för båda bryggorna och deras klienter ur tools/registers.schema:
+// REG_* för PIC:en och RA4M1:an, ESPHome-paket och Home Assistant-konfigurationen.
+//
+// Bygg:   g++ -std=c++17 -O2 -o gen_registers tools/gen_registers.cpp
+// Kör:    gen_registers            (från firmware/pic_bridge) skriver alla genererade filer
+//         gen_registers --check    avvikelse mot genererade filer -> exit 1
+//
+// PIC-register utan fast adress läggs i ordningen hot, cold, övriga så att det en klient
+// läser varje uppdatering hamnar i så få Modbus-blockläsningar som möjligt.
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+const char *SCHEMA_PATH = "tools/registers.schema";
+const char *PIC_HEADER_PATH = "registers.h";
+const char *RA4M1_HEADER_PATH = "../ra4m1_bridge/registers.h";
+const char *ESPHOME_PIC_PATH = "../../esphome/config/generated/pic_registers.yaml";
+const char *ESPHOME_RA4M1_PATH = "../../esphome/config/generated/ra4m1_registers.yaml";
+const char *HOME_ASSISTANT_PATH = "../../home_assistant/modbus_thermia.yaml";
+
+// --- Måste matcha modbus_rtu.h ---
+const int WORD_VIEW_BASE = 0x0000;
+const int BYTE_VIEW_BASE = 0x0100;
+const int MAX_READ_REGS = 125;
+
+// En ny förfrågan kostar ungefär 20 teckentider (8 bytes fråga, 5 bytes svarsram, 2 x T3.5),
+// ett extra register 2. Luckor upp till så här många register läses hellre över.
+const int MAX_GAP_REGS = 10;
+
+const int UPDATE_INTERVAL_S = 10;
+const int COLD_EVERY = 10;  // cold läses var tionde uppdatering
+
+enum class Section { Thermiq, Pic, Ra4m1 };
+enum class Sync { Hot, Cold, None };
+
+struct Register {
+  std::string name;
+  int count = 0;  // > 0: array
+  int addr = -1;
+  int bytes = 1;
+  char type = 'u';
+  double scale = 1.0;
+  bool writable = false;
+  Sync sync = Sync::None;
+  std::string unit;
+  std::string label;
+  std::string comment;
+  int line = 0;
+
+  int entries() const { return this->count > 0 ? this->count : 1; }
+  int size() const { return this->entries() * this->bytes; }
+};
+
+// Registerbank i RA4M1:an: en egen array från start till bankens sista register
+struct Bank {
+  std::string name;
+  int start;
+};
+
+struct SectionInfo {
+  bool present = false;
+  int start = 0;
+  int end = 0;
+  int slave = 0;
+  long baud = 0;
+  char parity = 'N';  // N, E eller O
+  std::string prefix;
+  std::vector<Bank> banks;  // [ra4m1]: stigande start, första på sektionens start
+  std::vector<Register> registers;
+};
+
+struct Schema {
+  SectionInfo sections[3];
+  SectionInfo &operator[](Section s) { return this->sections[static_cast<int>(s)]; }
+  const SectionInfo &operator[](Section s) const { return this->sections[static_cast<int>(s)]; }
+};
+
+class SchemaError : public std::runtime_error {
+ public:
+  SchemaError(int line, const std::string &what) : std::runtime_error("rad " + std::to_string(line) + ": " + what) {}
+};
+
+// --- Inläsning ---
+
+// Delar upp en rad i ord; "..." blir ett ord. # utanför citat inleder en kommentar.
+std::vector<std::string> tokenize(const std::string &line, std::string *comment) {
+  std::vector<std::string> tokens;
+  size_t i = 0;
+  while (i < line.size()) {
+    char c = line[i];
+    if (c == ' ' || c == '\t' || c == '\r') {
+      i++;
+    } else if (c == '#') {
+      size_t text = line.find_first_not_of(" #", i);
+      if (comment != nullptr && text != std::string::npos)
+        *comment = line.substr(text);
+      break;
+    } else if (c == '"') {
+      size_t close = line.find('"', i + 1);
+      if (close == std::string::npos)
+        throw std::runtime_error("citattecken saknas");
+      tokens.push_back(line.substr(i + 1, close - i - 1));
+      i = close + 1;
+    } else {
+      size_t end = i;
+      while (end < line.size() && line[end] != ' ' && line[end] != '\t' && line[end] != '#') {
+        if (line[end] == '"') {
+          size_t close = line.find('"', end + 1);
+          if (close == std::string::npos)
+            throw std::runtime_error("citattecken saknas");
+          end = close;
+        }
+        end++;
+      }
+      tokens.push_back(line.substr(i, end - i));
+      i = end;
+    }
+  }
+  return tokens;
+}
+
+std::string unquote(const std::string &s) {
+  if (s.size() >= 2 && s.front() == '"' && s.back() == '"')
+    return s.substr(1, s.size() - 2);
+  return s;
+}
+
+int parse_int(const std::string &s, int line) {
+  size_t used = 0;
+  int value = 0;
+  try {
+    value = std::stoi(s, &used, 0);
+  } catch (const std::exception &) {
+    used = 0;
+  }
+  if (used != s.size())
+    throw SchemaError(line, "ogiltigt tal '" + s + "'");
+  return value;
+}
+
+// "NAMN=start NAMN=start ..."
+std::vector<Bank> parse_banks(const std::string &text, int line) {
+  std::vector<Bank> banks;
+  std::istringstream in(text);
+  std::string word;
+  while (in >> word) {
+    size_t eq = word.find('=');
+    if (eq == std::string::npos || eq == 0)
+      throw SchemaError(line, "väntade NAMN=start i banks, fick '" + word + "'");
+    Bank bank{word.substr(0, eq), parse_int(word.substr(eq + 1), line)};
+    if (!banks.empty() && bank.start <= banks.back().start)
+      throw SchemaError(line, "bankerna måste ligga i stigande ordning");
+    banks.push_back(bank);
+  }
+  return banks;
+}
+
+void parse_section(const std::vector<std::string> &tokens, int line, Schema &schema, Section *current) {
+  std::string head = tokens[0].substr(1);
+  std::vector<std::string> args(tokens.begin() + 1, tokens.end());
+  if (args.empty() || args.back().empty() || args.back().back() != ']') {
+    if (!head.empty() && head.back() == ']')
+      head.pop_back();
+    else
+      throw SchemaError(line, "sektionen saknar ]");
+  } else {
+    args.back().pop_back();
+    if (args.back().empty())
+      args.pop_back();
+  }
+
+  if (head == "thermiq")
+    *current = Section::Thermiq;
+  else if (head == "pic")
+    *current = Section::Pic;
+  else if (head == "ra4m1")
+    *current = Section::Ra4m1;
+  else
+    throw SchemaError(line, "okänd sektion '" + head + "'");
+
+  SectionInfo &info = schema[*current];
+  if (info.present)
+    throw SchemaError(line, "sektionen " + head + " finns redan");
+  info.present = true;
+  for (const std::string &arg : args) {
+    size_t eq = arg.find('=');
+    if (eq == std::string::npos)
+      throw SchemaError(line, "väntade nyckel=värde, fick '" + arg + "'");
+    std::string key = arg.substr(0, eq);
+    std::string value = unquote(arg.substr(eq + 1));
+    if (key == "start")
+      info.start = parse_int(value, line);
+    else if (key == "end")
+      info.end = parse_int(value, line);
+    else if (key == "slave")
+      info.slave = parse_int(value, line);
+    else if (key == "baud")
+      info.baud = parse_int(value, line);
+    else if (key == "parity") {
+      if (value != "N" && value != "E" && value != "O")
+        throw SchemaError(line, "parity måste vara N, E eller O");
+      info.parity = value[0];
+    }
+    else if (key == "prefix")
+      info.prefix = value;
+    else if (key == "banks")
+      info.banks = parse_banks(value, line);
+    else
+      throw SchemaError(line, "okänd nyckel '" + key + "'");
+  }
+}
+
+Register parse_register(const std::vector<std::string> &tokens, const std::string &comment, int line) {
+  if (tokens.size() != 9)
+    throw SchemaError(line, "väntade 9 kolumner, fick " + std::to_string(tokens.size()));
+
+  Register r;
+  r.line = line;
+  r.name = tokens[0];
+  size_t bracket = r.name.find('[');
+  if (bracket != std::string::npos) {
+    if (r.name.back() != ']')
+      throw SchemaError(line, "ogiltigt arraynamn '" + r.name + "'");
+    r.count = parse_int(r.name.substr(bracket + 1, r.name.size() - bracket - 2), line);
+    r.name = r.name.substr(0, bracket);
+    if (r.count < 1)
+      throw SchemaError(line, "arrayen måste ha minst en post");
+  }
+  for (char c : r.name) {
+    if (!(std::isupper(static_cast<unsigned char>(c)) || std::isdigit(static_cast<unsigned char>(c)) || c == '_'))
+      throw SchemaError(line, "namnet '" + r.name + "' får bara innehålla A-Z, 0-9 och _");
+  }
+
+  if (tokens[1] != "-")
+    r.addr = parse_int(tokens[1], line);
+  r.bytes = parse_int(tokens[2], line);
+  if (r.bytes != 1 && r.bytes != 2)
+    throw SchemaError(line, "bytes måste vara 1 eller 2");
+  if (tokens[3].size() != 1 || std::string("usbd").find(tokens[3][0]) == std::string::npos)
+    throw SchemaError(line, "typ måste vara u, s, b eller d");
+  r.type = tokens[3][0];
+  try {
+    r.scale = std::stod(tokens[4]);
+  } catch (const std::exception &) {
+    throw SchemaError(line, "ogiltig skala '" + tokens[4] + "'");
+  }
+  if (tokens[5] == "rw")
+    r.writable = true;
+  else if (tokens[5] != "r")
+    throw SchemaError(line, "åtkomst måste vara r eller rw");
+  if (tokens[6] == "hot")
+    r.sync = Sync::Hot;
+  else if (tokens[6] == "cold")
+    r.sync = Sync::Cold;
+  else if (tokens[6] != "-")
+    throw SchemaError(line, "takt måste vara hot, cold eller -");
+  r.unit = tokens[7] == "-" ? "" : tokens[7];
+  r.label = tokens[8];
+  r.comment = comment;
+  return r;
+}
+
+Schema read_schema(const std::string &path) {
+  std::ifstream in(path);
+  if (!in)
+    throw std::runtime_error("kan inte öppna " + path);
+
+  Schema schema;
+  bool have_section = false;
+  Section current = Section::Thermiq;
+  std::string text;
+  int line = 0;
+  while (std::getline(in, text)) {
+    line++;
+    std::string comment;
+    std::vector<std::string> tokens;
+    try {
+      tokens = tokenize(text, &comment);
+    } catch (const std::runtime_error &e) {
+      throw SchemaError(line, e.what());
+    }
+    if (tokens.empty())
+      continue;
+    if (tokens[0][0] == '[') {
+      parse_section(tokens, line, schema, &current);
+      have_section = true;
+      continue;
+    }
+    if (!have_section)
+      throw SchemaError(line, "register före första sektionen");
+    Register r = parse_register(tokens, comment, line);
+    if (current == Section::Thermiq && r.addr < 0)
+      throw SchemaError(line, "ThermIQ-register måste ha fast adress");
+    if (current == Section::Pic && r.writable && r.addr < 0)
+      throw SchemaError(line, "skrivbara PIC-register måste ha fast adress");
+    if (r.type == 'd' && (current != Section::Thermiq || r.bytes != 2 || r.count > 0 || r.writable))
+      throw SchemaError(line, "typ d är ett läsbart ThermIQ-värde i 2 bytes (heltal + tiondelar)");
+    if (current == Section::Ra4m1 && r.bytes != 2)
+      throw SchemaError(line, "RA4M1-register är 16-bitars ord (bytes = 2)");
+    schema[current].registers.push_back(r);
+  }
+
+  for (Section s : {Section::Thermiq, Section::Pic, Section::Ra4m1}) {
+    if (!schema[s].present)
+      throw std::runtime_error("sektion saknas i " + path);
+  }
+  const SectionInfo &ra = schema[Section::Ra4m1];
+  if (ra.banks.empty() || ra.banks.front().start != ra.start)
+    throw std::runtime_error("[ra4m1] behöver banks= med första banken på start=" + std::to_string(ra.start));
+  return schema;
+}
+
+// --- Adresser ---
+
+// Storlek i adressrymden: bytes för PIC/ThermIQ, ord för RA4M1
+int span(const Register &r, Section s) { return s == Section::Ra4m1 ? r.entries() : r.size(); }
+
+void check_overlaps(std::vector<const Register *> regs, Section s, const std::string &what) {
+  std::sort(regs.begin(), regs.end(), [](const Register *a, const Register *b) { return a->addr < b->addr; });
+  for (size_t i = 1; i < regs.size(); i++) {
+    if (regs[i - 1]->addr + span(*regs[i - 1], s) > regs[i]->addr)
+      throw SchemaError(regs[i]->line, regs[i]->name + " överlappar " + regs[i - 1]->name + " i " + what);
+  }
+}
+
+// Banken en RA4M1-adress ligger i (sektionens adresser börjar i första banken)
+const Bank *bank_of(const SectionInfo &info, int addr) {
+  const Bank *found = &info.banks.front();
+  for (const Bank &bank : info.banks) {
+    if (bank.start <= addr)
+      found = &bank;
+  }
+  return found;
+}
+
+// Tilldelar adresser till register med "-" och kontrollerar att inget överlappar
+void assign_addresses(Schema &schema) {
+  for (Section s : {Section::Thermiq, Section::Pic, Section::Ra4m1}) {
+    SectionInfo &info = schema[s];
+    std::vector<const Register *> fixed;
+    for (const Register &r : info.registers) {
+      if (r.addr >= 0)
+        fixed.push_back(&r);
+    }
+    check_overlaps(fixed, s, "sektionen");
+
+    int cursor = info.start;
+    for (Sync sync : {Sync::Hot, Sync::Cold, Sync::None}) {
+      for (Register &r : info.registers) {
+        if (r.addr >= 0 || r.sync != sync)
+          continue;
+        for (bool moved = true; moved;) {
+          moved = false;
+          for (const Register *f : fixed) {
+            if (cursor < f->addr + span(*f, s) && f->addr < cursor + span(r, s)) {
+              cursor = f->addr + span(*f, s);
+              moved = true;
+            }
+          }
+        }
+        r.addr = cursor;
+        cursor += span(r, s);
+      }
+    }
+
+    for (const Register &r : info.registers) {
+      if (r.addr < info.start || r.addr + span(r, s) - 1 > info.end)
+        throw SchemaError(r.line, r.name + " hamnar utanför sektionen (" + std::to_string(info.start) + "-" +
+                                      std::to_string(info.end) + ")");
+    }
+  }
+
+  // Modbus-förfrågningar får inte spänna över två banker i RA4M1:an
+  for (const Register &r : schema[Section::Ra4m1].registers) {
+    const Bank *bank = bank_of(schema[Section::Ra4m1], r.addr);
+    const Bank *last = bank_of(schema[Section::Ra4m1], r.addr + r.entries() - 1);
+    if (bank != last)
+      throw SchemaError(r.line, r.name + " spänner över banken " + bank->name + " och " + last->name);
+  }
+  for (const Bank &bank : schema[Section::Ra4m1].banks) {
+    const std::vector<Register> &regs = schema[Section::Ra4m1].registers;
+    if (std::none_of(regs.begin(), regs.end(), [&](const Register &r) { return bank_of(schema[Section::Ra4m1], r.addr) == &bank; }))
+      throw std::runtime_error("banken " + bank.name + " saknar register");
+  }
+
+  // ThermIQ och PIC delar registerMap
+  std::vector<const Register *> pic_map;
+  for (Section s : {Section::Thermiq, Section::Pic}) {
+    for (const Register &r : schema[s].registers)
+      pic_map.push_back(&r);
+  }
+  check_overlaps(pic_map, Section::Pic, "registerMap");
+}
+
+// --- Klientposter ---
+
+// En post som en klient läser: ett register, eller en post i en array
+struct Item {
+  const Register *reg;
+  int index;          // -1 = inte array
+  int address;        // Modbus-adress
+  std::string mask;   // ESPHome bitmask för 1-bytesvärden i ett ord, tom = hela ordet
+  bool sign_byte;     // 8-bitars tvåkomplement i ett ord som läses osignerat
+  bool decimal_word;  // Ordet är heltal << 8 | tiondelar (typ d i PIC:ens ordvy)
+  int register_count; // Överbryggar luckan till nästa post i samma block
+};
+
+std::string label_of(const Item &item, const std::string &prefix) {
+  std::string label = item.reg->label;
+  size_t pos = label.find("%d");
+  if (pos != std::string::npos)
+    label.replace(pos, 2, std::to_string(item.index + 1));
+  return prefix.empty() ? label : prefix + " " + label;
+}
+
+// Entitets-id: gemener, a-z/0-9/_. å/ä blir a, ö blir o.
+std::string slug(const std::string &text) {
+  std::string out;
+  for (size_t i = 0; i < text.size(); i++) {
+    unsigned char c = static_cast<unsigned char>(text[i]);
+    char mapped = 0;
+    if (c == 0xC3 && i + 1 < text.size()) {
+      unsigned char next = static_cast<unsigned char>(text[++i]);
+      if (next == 0xA5 || next == 0xA4 || next == 0x85 || next == 0x84)
+        mapped = 'a';
+      else if (next == 0xB6 || next == 0x96)
+        mapped = 'o';
+    } else if (std::isalnum(c)) {
+      mapped = static_cast<char>(std::tolower(c));
+    }
+    if (mapped != 0)
+      out += mapped;
+    else if (!out.empty() && out.back() != '_')
+      out += '_';
+  }
+  while (!out.empty() && out.back() == '_')
+    out.pop_back();
+  return out;
+}
+
+int decimals_of(double scale) {
+  int decimals = 0;
+  while (decimals < 6 && std::fabs(scale * std::pow(10.0, decimals) - std::round(scale * std::pow(10.0, decimals))) > 1e-9)
+    decimals++;
+  return decimals;
+}
+
+std::string format_number(double value) {
+  char buf[32];
+  std::snprintf(buf, sizeof(buf), "%.6g", value);
+  return buf;
+}
+
+// Poster för PIC:en: 2 bytes och lästa 1 bytes i ordvyn, skrivbara 1 bytes i bytevyn
+// så att en skrivning inte ändrar grannbyten (modbus_rtu.h).
+std::vector<Item> pic_items(const Schema &schema) {
+  std::vector<Item> items;
+  for (Section s : {Section::Thermiq, Section::Pic}) {
+    for (const Register &r : schema[s].registers) {
+      if (r.sync == Sync::None)
+        continue;
+      for (int i = 0; i < r.entries(); i++) {
+        int byte = r.addr + i * r.bytes;
+        Item item{&r, r.count > 0 ? i : -1, 0, "", false, false, 1};
+        if (r.bytes == 2) {
+          item.address = WORD_VIEW_BASE + byte;
+          item.decimal_word = r.type == 'd';
+        } else if (r.writable) {
+          item.address = BYTE_VIEW_BASE + byte;
+          item.sign_byte = r.type == 's';
+        } else {
+          item.address = WORD_VIEW_BASE + byte;
+          item.mask = "0xFF00";
+          item.sign_byte = r.type == 's';
+        }
+        items.push_back(item);
+      }
+    }
+  }
+  return items;
+}
+
+// Poster för RA4M1:an: ett ord per register, ThermIQ-bytes teckenutökade.
+// Ett ThermIQ-värde av typ d har RA4M1:an redan lagt ihop till ett ord (värde / skala).
+std::vector<Item> ra4m1_items(const Schema &schema) {
+  std::vector<Item> items;
+  for (Section s : {Section::Thermiq, Section::Ra4m1}) {
+    for (const Register &r : schema[s].registers) {
+      if (r.sync == Sync::None)
+        continue;
+      for (int i = 0; i < r.entries(); i++) {
+        Item item{&r, r.count > 0 ? i : -1, r.addr + i, "", false, false, 1};
+        if (s == Section::Thermiq && r.type != 's' && r.type != 'd')
+          item.mask = "0x00FF";
+        items.push_back(item);
+      }
+    }
+  }
+  return items;
+}
+
+struct Block {
+  int start;
+  int count;
+  Sync sync;
+};
+
+// Adresser där ett block måste brytas: PIC:ens bytevy, RA4M1:ans banker
+std::vector<int> block_splits(const Schema &schema, Section own) {
+  std::vector<int> splits;
+  if (own == Section::Pic) {
+    splits.push_back(BYTE_VIEW_BASE);
+  } else {
+    for (const Bank &bank : schema[Section::Ra4m1].banks)
+      splits.push_back(bank.start);
+  }
+  return splits;
+}
+
+bool same_region(const std::vector<int> &splits, int a, int b) {
+  for (int split : splits) {
+    if ((a >= split) != (b >= split))
+      return false;
+  }
+  return true;
+}
+
+// Slår ihop poster med samma takt till blockläsningar och sätter register_count så att
+// ESPHome ser blocket som sammanhängande. Returnerar blocken i adressordning.
+std::vector<Block> plan_blocks(std::vector<Item> &items, const std::vector<int> &splits) {
+  std::sort(items.begin(), items.end(), [](const Item &a, const Item &b) { return a.address < b.address; });
+  std::vector<Block> blocks;
+  for (size_t i = 0; i < items.size(); i++) {
+    Item &item = items[i];
+    Block *last = blocks.empty() ? nullptr : &blocks.back();
+    Item *prev = i > 0 ? &items[i - 1] : nullptr;
+    bool join = last != nullptr && prev != nullptr && last->sync == item.reg->sync &&
+                same_region(splits, last->start, item.address) && item.address - (last->start + last->count) <= MAX_GAP_REGS &&
+                item.address + 1 - last->start <= MAX_READ_REGS;
+    if (join) {
+      prev->register_count = item.address - prev->address;
+      last->count = item.address + 1 - last->start;
+    } else {
+      blocks.push_back(Block{item.address, 1, item.reg->sync});
+    }
+  }
+  return blocks;
+}
+
+// --- Utdata ---
+
+const char *GENERATED_C =
+    "// GENERERAD FIL - ändra inte för hand.\n"
+    "// Skapad av tools/gen_registers.cpp från tools/registers.schema (firmware/pic_bridge).\n";
+const char *GENERATED_YAML =
+    "# GENERERAD FIL - ändra inte för hand.\n"
+    "# Skapad av firmware/pic_bridge/tools/gen_registers.cpp från tools/registers.schema.\n";
+
+std::string scale_text(const Register &r) {
+  std::string unit = r.unit.empty() ? "" : " " + r.unit;
+  if (r.scale == 1.0)
+    return unit.empty() ? "" : r.unit;
+  double inverse = 1.0 / r.scale;
+  if (std::fabs(inverse - std::round(inverse)) < 1e-9)
+    return (unit.empty() ? std::string("rått") : r.unit) + " * " + format_number(std::round(inverse));
+  return "rått * " + format_number(r.scale) + unit;
+}
+
+std::string define_comment(const Register &r) {
+  std::string text = r.label;
+  size_t pos = text.find(" %d");
+  if (pos != std::string::npos)
+    text.erase(pos, 3);
+  std::string scale = scale_text(r);
+  if (!scale.empty())
+    text += " (" + scale + ")";
+  if (!r.comment.empty())
+    text += ". " + r.comment;
+  if (r.writable)
+    text += " [rw]";
+  return text;
+}
+
+void define(std::ostringstream &out, const std::string &name, int value, const std::string &comment) {
+  char buf[160];
+  std::snprintf(buf, sizeof(buf), "#define %-34s %d", name.c_str(), value);
+  out << buf;
+  if (!comment.empty())
+    out << " // " << comment;
+  out << "\n";
+}
+
+void define_register(std::ostringstream &out, const Register &r, int addr, int stride_bytes) {
+  std::string base = "REG_" + r.name;
+  if (r.count > 0) {
+    std::string layout = std::to_string(r.count) + " x " + (stride_bytes == 2 ? "HI/LO" : "1 byte");
+    define(out, base + "_BASE", addr, define_comment(r) + ", " + layout);
+    define(out, base + "_LEN", r.count, "");
+  } else if (stride_bytes == 2) {
+    define(out, base + "_HI", addr, define_comment(r));
+    define(out, base + "_LO", addr + 1, "");
+  } else {
+    define(out, base, addr, define_comment(r));
+  }
+}
+
+std::string block_summary(const std::vector<Block> &blocks, Sync sync, bool hex) {
+  std::string out;
+  for (const Block &b : blocks) {
+    if (b.sync != sync)
+      continue;
+    char buf[48];
+    std::snprintf(buf, sizeof(buf), hex ? "0x%04X+%d" : "%d+%d", b.start, b.count);
+    out += (out.empty() ? "" : ", ") + std::string(buf);
+  }
+  return out.empty() ? "-" : out;
+}
+
+int block_count(const std::vector<Block> &blocks, Sync sync) {
+  return static_cast<int>(std::count_if(blocks.begin(), blocks.end(), [sync](const Block &b) { return b.sync == sync; }));
+}
+
+std::string pic_header(const Schema &schema) {
+  std::vector<Item> items = pic_items(schema);
+  std::vector<Block> blocks = plan_blocks(items, block_splits(schema, Section::Pic));
+  const SectionInfo &pic = schema[Section::Pic];
+
+  std::ostringstream out;
+  out << GENERATED_C << "// Adresser i registerMap. Modbus: ordvy N = (N << 8 | N+1), bytevy 0x100+N.\n"
+      << "// Hot-registren läses i " << block_count(blocks, Sync::Hot) << " block (start+antal register): "
+      << block_summary(blocks, Sync::Hot, true) << "\n\n"
+      << "#ifndef REGISTERS_H\n#define REGISTERS_H\n\n"
+      << "// --- THERMIQ (Pumpens I2C Master Write, 1 byte per register) ---\n";
+
+  std::vector<const Register *> thermiq;
+  for (const Register &r : schema[Section::Thermiq].registers)
+    thermiq.push_back(&r);
+  std::sort(thermiq.begin(), thermiq.end(), [](const Register *a, const Register *b) { return a->addr < b->addr; });
+  for (const Register *r : thermiq) {
+    if (r->type == 'd') {
+      define(out, "REG_" + r->name, r->addr, r->label + " (" + r->unit + ", heltal). " + r->comment);
+      define(out, "REG_" + r->name + "_DEC", r->addr + 1, "Tiondelar (0-9)");
+    } else {
+      define_register(out, *r, r->addr, r->bytes);
+    }
+  }
+
+  out << "\n// --- PIC (" << pic.start << "-" << pic.end << ", hot-registren först) ---\n";
+  std::vector<const Register *> own;
+  for (const Register &r : pic.registers)
+    own.push_back(&r);
+  std::stable_sort(own.begin(), own.end(), [](const Register *a, const Register *b) { return a->addr < b->addr; });
+  Sync section = Sync::Hot;
+  bool first = true;
+  for (const Register *r : own) {
+    if (first || r->sync != section) {
+      section = r->sync;
+      if (!first)
+        out << "\n";
+      out << (section == Sync::Hot ? "// Hot: läses varje uppdatering\n"
+              : section == Sync::Cold ? "// Cold: läses var " + std::to_string(COLD_EVERY) + ":e uppdatering\n"
+                                      : "// Exporteras inte till klienterna\n");
+      first = false;
+    }
+    define_register(out, *r, r->addr, r->bytes);
+  }
+  out << "\n#endif /* REGISTERS_H */\n";
+  return out.str();
+}
+
+std::string ra4m1_header(const Schema &schema) {
+  const SectionInfo &ra = schema[Section::Ra4m1];
+  std::vector<Item> items = ra4m1_items(schema);
+  std::vector<Block> blocks = plan_blocks(items, block_splits(schema, Section::Ra4m1));
+
+  std::ostringstream out;
+  out << GENERATED_C << "// Modbus-adresser. Varje bank är en egen array; ThermIQ-byte N ligger i ord N, teckenutökad.\n"
+      << "// Hot-registren läses i " << block_count(blocks, Sync::Hot) << " block (start+antal register): "
+      << block_summary(blocks, Sync::Hot, false) << "\n\n"
+      << "#ifndef RA4M1_REGISTERS_H\n#define RA4M1_REGISTERS_H\n\n"
+      << "// --- THERMIQ (Pumpens I2C Master Write, ett ord per byte) ---\n";
+  define(out, "REG_THERMIQ_WORDS", 256, "Pumpens indexrymd (8-bitars index)");
+  std::vector<const Register *> thermiq;
+  for (const Register &r : schema[Section::Thermiq].registers)
+    thermiq.push_back(&r);
+  std::sort(thermiq.begin(), thermiq.end(), [](const Register *a, const Register *b) { return a->addr < b->addr; });
+  for (const Register *r : thermiq) {
+    if (r->type == 'd') {
+      define(out, "REG_" + r->name, r->addr, define_comment(*r) + ", ett ord");
+      define(out, "REG_" + r->name + "_DEC", r->addr + 1, "Tiondelarna som pumpen skrev");
+    } else {
+      define_register(out, *r, r->addr, 1);
+    }
+  }
+
+  // X-makro över heltalsadresserna: receiveEvent() lägger ihop värdet, requestEvent() delar det
+  out << "\n// Heltal + tiondelar från pumpen, ett ord på heltalsadressen: THERMIQ_DECIMAL_PAIRS(X) -> X(adress) ...\n"
+      << "#define THERMIQ_DECIMAL_PAIRS(X)";
+  for (const Register *r : thermiq) {
+    if (r->type == 'd')
+      out << " X(" << r->addr << ")";
+  }
+  out << "\n";
+
+  // Standardvärden tills annat sparats i EEPROM (MODBUS_PARITY_*: 0 ingen, 1 udda, 2 jämn)
+  out << "\n// --- Modbus (standard; baud och paritet kan ändras via konfigurationsbanken) ---\n";
+  define(out, "MODBUS_SLAVE_ID", ra.slave, "");
+  define(out, "MODBUS_DEFAULT_BAUD", static_cast<int>(ra.baud), "");
+  define(out, "MODBUS_DEFAULT_PARITY", ra.parity == 'N' ? 0 : ra.parity == 'O' ? 1 : 2, std::string("8") + ra.parity + "1");
+
+  out << "\n// --- RA4M1 ---\n";
+  for (const Register &r : ra.registers) {
+    std::string base = "REG_" + r.name;
+    if (r.count > 0) {
+      define(out, base + "_BASE", r.addr, define_comment(r) + ", " + std::to_string(r.count) + " ord");
+      define(out, base + "_LEN", r.count, "");
+    } else {
+      define(out, base, r.addr, define_comment(r));
+    }
+  }
+
+  // Bankens längd räcker till dess sista register
+  out << "\n// --- Registerbanker (Modbus-adress = BANK_<namn>_START + index i bankens array) ---\n";
+  define(out, "BANK_THERMIQ_START", 0, "Pumpens indexrymd");
+  define(out, "BANK_THERMIQ_LEN", 256, "");
+  for (const Bank &bank : ra.banks) {
+    int end = bank.start;
+    for (const Register &r : ra.registers) {
+      if (bank_of(ra, r.addr) == &bank)
+        end = std::max(end, r.addr + r.entries());
+    }
+    define(out, "BANK_" + bank.name + "_START", bank.start, "");
+    define(out, "BANK_" + bank.name + "_LEN", end - bank.start, "");
+  }
+  out << "\n#endif /* RA4M1_REGISTERS_H */\n";
+  return out.str();
+}
+
+std::string yaml_hex(int address) {
+  char buf[16];
+  std::snprintf(buf, sizeof(buf), "0x%04X", address);
+  return buf;
+}
+
+const char *value_type(const Item &item) {
+  if (!item.mask.empty() || item.sign_byte || item.decimal_word || (item.reg->type != 's' && item.reg->type != 'd'))
+    return "U_WORD";
+  return "S_WORD";
+}
+
+// Gränser för ett skrivbart tal i ESPHome, i visade enheter
+void number_range(const Item &item, double *min_value, double *max_value) {
+  const Register &r = *item.reg;
+  long lo = 0, hi = r.bytes == 2 ? 65535 : 255;
+  if (r.type == 's') {
+    lo = r.bytes == 2 ? -32768 : -128;
+    hi = r.bytes == 2 ? 32767 : 127;
+  }
+  *min_value = lo * r.scale;
+  *max_value = hi * r.scale;
+}
+
+std::string esphome_package(const Schema &schema, Section own, std::vector<Item> items, const std::string &controller,
+                            const std::string &file) {
+  const SectionInfo &info = schema[own];
+  std::vector<Block> blocks = plan_blocks(items, block_splits(schema, own));
+  const std::string &prefix_own = info.prefix;
+
+  std::ostringstream sensors, binary_sensors, numbers, switches;
+  for (const Item &item : items) {
+    const Register &r = *item.reg;
+    bool is_thermiq = std::any_of(schema[Section::Thermiq].registers.begin(), schema[Section::Thermiq].registers.end(),
+                                  [&r](const Register &t) { return &t == &r; });
+    std::string label = label_of(item, is_thermiq ? schema[Section::Thermiq].prefix : prefix_own);
+    std::ostringstream entry;
+    entry << "  - platform: modbus_controller\n"
+          << "    modbus_controller_id: " << controller << "\n"
+          << "    id: " << slug(label) << "\n"
+          << "    name: \"" << label << "\"\n"
+          << "    address: " << yaml_hex(item.address) << "\n"
+          << "    register_type: holding\n";
+
+    if (r.type == 'b') {
+      entry << "    bitmask: " << (item.mask.empty() ? "0x0001" : item.mask) << "\n";
+    } else {
+      entry << "    value_type: " << value_type(item) << "\n";
+      if (!item.mask.empty())
+        entry << "    bitmask: " << item.mask << "\n";
+    }
+    if (item.register_count > 1)
+      entry << "    register_count: " << item.register_count << "\n";
+    if (r.sync == Sync::Cold)
+      entry << "    skip_updates: " << COLD_EVERY - 1 << "\n";
+
+    bool sign = item.sign_byte || (!item.mask.empty() && r.type == 's');
+    if (r.type == 'b') {
+      (r.writable ? switches : binary_sensors) << entry.str();
+    } else if (r.writable) {
+      double min_value, max_value;
+      number_range(item, &min_value, &max_value);
+      entry << "    min_value: " << format_number(min_value) << "\n"
+            << "    max_value: " << format_number(max_value) << "\n"
+            << "    step: " << format_number(r.scale) << "\n";
+      if (!r.unit.empty())
+        entry << "    unit_of_measurement: \"" << r.unit << "\"\n";
+      if (r.scale != 1.0)
+        entry << "    multiply: " << format_number(1.0 / r.scale) << "\n";
+      if (sign)
+        entry << "    lambda: 'return x > 127 ? x - 256 : x;'\n";
+      entry << "    mode: box\n";
+      numbers << entry.str();
+    } else {
+      if (!r.unit.empty())
+        entry << "    unit_of_measurement: \"" << r.unit << "\"\n";
+      if (r.unit == "°C")
+        entry << "    device_class: temperature\n    state_class: measurement\n";
+      entry << "    accuracy_decimals: " << decimals_of(r.scale) << "\n";
+      if (item.decimal_word) {
+        // Heltalet har tecken, tiondelarna följer det
+        entry << "    filters:\n"
+              << "      - lambda: 'int w = (int) x; int whole = (int8_t) (w >> 8); float tenths = (w & 0xFF) / 10.0f; "
+                 "return whole < 0 ? whole - tenths : whole + tenths;'\n";
+      } else if (sign || r.scale != 1.0) {
+        entry << "    filters:\n";
+        if (sign)
+          entry << "      - lambda: 'return x > 127 ? x - 256 : x;'\n";
+        if (r.scale != 1.0)
+          entry << "      - multiply: " << format_number(r.scale) << "\n";
+      }
+      sensors << entry.str();
+    }
+  }
+
+  std::ostringstream out;
+  out << GENERATED_YAML << "# ESPHome-paket: packages: { registers: !include generated/" << file << " }\n"
+      << "# Kräver modbus-komponenten med id modbus_hub. Hot läses varje uppdatering i "
+      << block_count(blocks, Sync::Hot) << " block (" << block_summary(blocks, Sync::Hot, true) << "),\n"
+      << "# cold var " << COLD_EVERY << ":e i " << block_count(blocks, Sync::Cold) << " block ("
+      << block_summary(blocks, Sync::Cold, true) << ").\n\n"
+      << "modbus_controller:\n"
+      << "  - id: " << controller << "\n"
+      << "    address: " << info.slave << "\n"
+      << "    modbus_id: modbus_hub\n"
+      << "    setup_priority: -10\n"
+      << "    update_interval: " << UPDATE_INTERVAL_S << "s\n";
+  if (!sensors.str().empty())
+    out << "\nsensor:\n" << sensors.str();
+  if (!binary_sensors.str().empty())
+    out << "\nbinary_sensor:\n" << binary_sensors.str();
+  if (!numbers.str().empty())
+    out << "\nnumber:\n" << numbers.str();
+  if (!switches.str().empty())
+    out << "\nswitch:\n" << switches.str();
+  return out.str();
+}
+
+// Home Assistant läser varje entitet för sig, så här ger layouten inga blockläsningar;
+// hot/cold styr bara scan_interval.
+std::string home_assistant(const Schema &schema) {
+  const SectionInfo &ra = schema[Section::Ra4m1];
+  std::vector<Item> items = ra4m1_items(schema);
+  plan_blocks(items, block_splits(schema, Section::Ra4m1));
+
+  std::ostringstream sensors, switches;
+  for (const Item &item : items) {
+    const Register &r = *item.reg;
+    bool is_thermiq = std::any_of(schema[Section::Thermiq].registers.begin(), schema[Section::Thermiq].registers.end(),
+                                  [&r](const Register &t) { return &t == &r; });
+    std::string label = label_of(item, is_thermiq ? schema[Section::Thermiq].prefix : ra.prefix);
+    int interval = UPDATE_INTERVAL_S * (r.sync == Sync::Cold ? COLD_EVERY : 1);
+    std::ostringstream entry;
+    entry << "      - name: \"" << label << "\"\n"
+          << "        unique_id: " << slug(label) << "\n"
+          << "        slave: " << ra.slave << "\n"
+          << "        address: " << item.address << "\n";
+
+    if (r.type == 'b' && r.writable) {
+      entry << "        write_type: holding\n"
+            << "        command_on: 1\n"
+            << "        command_off: 0\n"
+            << "        verify: {}\n"
+            << "        scan_interval: " << interval << "\n";
+      switches << entry.str() << "\n";
+      continue;
+    }
+    entry << "        input_type: holding\n";
+    if (!item.mask.empty())
+      entry << "        data_type: custom\n        structure: \">xB\"\n        count: 1\n";
+    else
+      entry << "        data_type: " << (r.type == 's' || r.type == 'd' ? "int16" : "uint16") << "\n";
+    if (r.scale != 1.0)
+      entry << "        scale: " << format_number(r.scale) << "\n        precision: " << decimals_of(r.scale) << "\n";
+    if (!r.unit.empty())
+      entry << "        unit_of_measurement: \"" << r.unit << "\"\n";
+    entry << "        scan_interval: " << interval << "\n";
+    if (r.writable)
+      entry << "        # Skrivs med tjänsten modbus.write_register (hub thermia_hub, slave " << ra.slave
+            << ", address " << item.address << ")\n";
+    sensors << entry.str() << "\n";
+  }
+
+  std::ostringstream out;
+  out << GENERATED_YAML << "# Home Assistant Modbus mot RA4M1-bryggan. Home Assistant läser varje entitet för sig;\n"
+      << "# hot-register var " << UPDATE_INTERVAL_S << ":e sekund, cold var " << UPDATE_INTERVAL_S * COLD_EVERY
+      << ":e.\n\n"
+      << "modbus:\n"
+      << "  - name: \"thermia_hub\"\n"
+      << "    type: serial\n"
+      << "    # VIKTIGT: Byt ut mot din USB-ports sökväg\n"
+      << "    port: /dev/serial/by-id/usb-DIN_STICKA_HÄR\n"
+      << "    baudrate: " << ra.baud << "\n"
+      << "    bytesize: 8\n"
+      << "    method: rtu\n"
+      << "    parity: " << ra.parity << "\n"
+      << "    stopbits: 1\n";
+  std::string sensor_text = sensors.str(), switch_text = switches.str();
+  if (!sensor_text.empty())
+    out << "\n    sensors:\n" << sensor_text.substr(0, sensor_text.size() - 1);
+  if (!switch_text.empty())
+    out << "\n    switches:\n" << switch_text.substr(0, switch_text.size() - 1);
+  return out.str();
+}
+
+// --- Filer ---
+
+bool read_file(const std::string &path, std::string *content) {
+  std::ifstream in(path, std::ios::binary);
+  if (!in)
+    return false;
+  content->assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+  return true;
+}
+
+int usage() {
+  std::fprintf(stderr, "Användning: gen_registers [--check]   (körs från firmware/pic_bridge)\n");
+  return 2;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  bool check = false;
+  for (int i = 1; i < argc; i++) {
+    if (std::string(argv[i]) == "--check")
+      check = true;
+    else
+      return usage();
+  }
+
+  Schema schema;
+  try {
+    schema = read_schema(SCHEMA_PATH);
+    assign_addresses(schema);
+  } catch (const std::exception &e) {
+    std::fprintf(stderr, "%s: %s\n", SCHEMA_PATH, e.what());
+    return 1;
+  }
+
+  const std::pair<const char *, std::string> outputs[] = {
+      {PIC_HEADER_PATH, pic_header(schema)},
+      {RA4M1_HEADER_PATH, ra4m1_header(schema)},
+      {ESPHOME_PIC_PATH, esphome_package(schema, Section::Pic, pic_items(schema), "pic_modbus", "pic_registers.yaml")},
+      {ESPHOME_RA4M1_PATH, esphome_package(schema, Section::Ra4m1, ra4m1_items(schema), "thermia_device", "ra4m1_registers.yaml")},
+      {HOME_ASSISTANT_PATH, home_assistant(schema)},
+  };
+
+  int stale = 0;
+  for (const auto &output : outputs) {
+    std::string current;
+    bool exists = read_file(output.first, &current);
+    if (exists && current == output.second)
+      continue;
+    if (check) {
+      std::fprintf(stderr, "%s är inte genererad från schemat\n", output.first);
+      stale++;
+      continue;
+    }
+    std::ofstream out(output.first, std::ios::binary);
+    if (!out) {
+      std::fprintf(stderr, "kan inte skriva %s\n", output.first);
+      return 1;
+    }
+    out << output.second;
+    std::printf("skrev %s\n", output.first);
+  }
+  return stale > 0 ? 1 : 0;
+}
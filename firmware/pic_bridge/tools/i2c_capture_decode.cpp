@@ -0,0 +1,392 @@
+// Avkodar bussfångsten från capture.c (UART3) till text eller pcap.
+//
+// Bygg:   g++ -std=c++17 -O2 -o i2c_capture_decode tools/i2c_capture_decode.cpp
+// Fånga:  skriv 1 (115200) eller 3 (1 Mbaud) till REG_I2C_CAPTURE_CONTROL och spara UART3 rått, t.ex.
+//         stty -F /dev/ttyUSB0 1000000 raw && cat /dev/ttyUSB0 > fangst.bin
+// Kör:    i2c_capture_decode fangst.bin                 en rad per transaktion
+//         i2c_capture_decode --records fangst.bin       en rad per post
+//         i2c_capture_decode --pcap fangst.pcap fangst.bin
+//
+// pcap-filen använder LINKTYPE_I2C_LINUX (209) och öppnas direkt i Wireshark.
+// Formatet måste följa capture.h (CAPTURE_FORMAT_VERSION).
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace {
+
+// --- Måste matcha capture.h ---
+const uint8_t FORMAT_VERSION = 1;
+const size_t RECORD_SIZE = 4;
+const uint8_t MAGIC[] = {'I', '2', 'C', 'C', 'A', 'P'};
+const size_t HEADER_SIZE = sizeof(MAGIC) + 2;
+
+enum RecordType : uint8_t {
+  REC_TIME = 0x1,
+  REC_START = 0x2,
+  REC_RESTART = 0x3,
+  REC_STOP = 0x4,
+  REC_ADDR = 0x5,
+  REC_WRITE = 0x6,
+  REC_READ = 0x7,
+  REC_ERROR = 0x8,
+  REC_LOST = 0x9,
+};
+const uint8_t FLAG_IGNORED = 0x1;
+
+// TMR1 i PIC:en: Fosc/4 / 8 = 2 MHz
+const uint64_t TICK_NS = 500;
+// Slavadressen om adressposten gått förlorad (I2C_SLAVE_ADDR i globals.h)
+const uint8_t DEFAULT_ADDR = 0x2E;
+
+const uint32_t LINKTYPE_I2C_LINUX = 209;
+const uint32_t PCAP_FLAG_READ = 0x00000001;
+
+struct Record {
+  uint8_t type;
+  uint8_t flags;
+  uint8_t data;
+  uint64_t time_ns;  // Sedan PIC-start (millisekundticken förlängd bortom 65.5 s)
+};
+
+// Bygger absoluta tider: CAPTURE_TIME ger millisekunder, TMR1 upplösningen däremellan
+class Clock {
+ public:
+  uint64_t on_time(uint16_t ms) {
+    if (this->have_ms_)
+      this->ms_ += static_cast<uint16_t>(ms - this->last_ms_);
+    else
+      this->ms_ = ms;
+    this->last_ms_ = ms;
+    this->have_ms_ = true;
+    this->anchor_pending_ = true;
+    return this->ms_ * 1000000ULL;
+  }
+
+  uint64_t on_ticks(uint16_t ticks) {
+    if (this->anchor_pending_ || !this->have_ticks_) {
+      // Första TMR1-posten efter tidsposten ligger (nästan) på millisekunden
+      this->anchor_pending_ = false;
+      this->base_ns_ = this->ms_ * 1000000ULL;
+      this->tick_acc_ = 0;
+    } else {
+      this->tick_acc_ += static_cast<uint16_t>(ticks - this->last_ticks_);
+    }
+    this->last_ticks_ = ticks;
+    this->have_ticks_ = true;
+    return this->base_ns_ + this->tick_acc_ * TICK_NS;
+  }
+
+  void reset() { *this = Clock(); }
+
+ private:
+  uint64_t ms_ = 0;
+  uint16_t last_ms_ = 0;
+  bool have_ms_ = false;
+  bool anchor_pending_ = false;
+  uint64_t base_ns_ = 0;
+  uint64_t tick_acc_ = 0;
+  uint16_t last_ticks_ = 0;
+  bool have_ticks_ = false;
+};
+
+bool is_header(const std::vector<uint8_t> &buf, size_t pos) {
+  return pos + HEADER_SIZE <= buf.size() && std::memcmp(&buf[pos], MAGIC, sizeof(MAGIC)) == 0;
+}
+
+size_t find_header(const std::vector<uint8_t> &buf, size_t pos) {
+  for (; pos + HEADER_SIZE <= buf.size(); pos++) {
+    if (is_header(buf, pos))
+      return pos;
+  }
+  return buf.size();
+}
+
+// Delar strömmen i poster. Nytt huvud = fångsten startades om (tiden börjar om).
+std::vector<Record> parse(const std::vector<uint8_t> &buf, unsigned &sessions, unsigned &resyncs) {
+  std::vector<Record> records;
+  Clock clock;
+  size_t pos = find_header(buf, 0);
+  sessions = 0;
+  resyncs = 0;
+
+  while (pos < buf.size()) {
+    if (is_header(buf, pos)) {
+      uint8_t version = buf[pos + sizeof(MAGIC)];
+      uint8_t size = buf[pos + sizeof(MAGIC) + 1];
+      if (version != FORMAT_VERSION || size != RECORD_SIZE) {
+        std::fprintf(stderr, "okänt format (version %u, poststorlek %u) vid byte %zu\n", version, size, pos);
+        pos = find_header(buf, pos + 1);
+        continue;
+      }
+      clock.reset();
+      sessions++;
+      pos += HEADER_SIZE;
+      continue;
+    }
+    if (pos + RECORD_SIZE > buf.size())
+      break;  // Avklippt sista post
+
+    uint8_t type = buf[pos] >> 4;
+    if (type < REC_TIME || type > REC_LOST) {
+      // Tappad synk (t.ex. förlorade UART-bytes): leta upp nästa huvud
+      resyncs++;
+      pos = find_header(buf, pos + 1);
+      continue;
+    }
+
+    Record rec;
+    rec.type = type;
+    rec.flags = buf[pos] & 0x0F;
+    rec.data = buf[pos + 1];
+    uint16_t stamp = static_cast<uint16_t>(buf[pos + 2] | (buf[pos + 3] << 8));
+    rec.time_ns = (type == REC_TIME) ? clock.on_time(stamp) : clock.on_ticks(stamp);
+    records.push_back(rec);
+    pos += RECORD_SIZE;
+  }
+  return records;
+}
+
+std::string format_time(uint64_t ns) {
+  char out[32];
+  std::snprintf(out, sizeof(out), "%10llu.%06llu", static_cast<unsigned long long>(ns / 1000000000ULL),
+                static_cast<unsigned long long>((ns / 1000ULL) % 1000000ULL));
+  return out;
+}
+
+const char *type_name(uint8_t type) {
+  switch (type) {
+    case REC_TIME: return "TIME";
+    case REC_START: return "START";
+    case REC_RESTART: return "RESTART";
+    case REC_STOP: return "STOP";
+    case REC_ADDR: return "ADDR";
+    case REC_WRITE: return "WRITE";
+    case REC_READ: return "READ";
+    case REC_ERROR: return "ERROR";
+    case REC_LOST: return "LOST";
+  }
+  return "?";
+}
+
+void print_records(const std::vector<Record> &records) {
+  for (const Record &rec : records) {
+    if (rec.type == REC_TIME)
+      continue;
+    std::printf("%s  %-7s", format_time(rec.time_ns).c_str(), type_name(rec.type));
+    switch (rec.type) {
+      case REC_ADDR:
+        std::printf(" 0x%02X %c", rec.data >> 1, (rec.data & 1) ? 'R' : 'W');
+        break;
+      case REC_WRITE:
+      case REC_READ:
+      case REC_ERROR:
+        std::printf(" 0x%02X", rec.data);
+        break;
+      case REC_LOST:
+        std::printf(" %u", rec.data);
+        break;
+    }
+    if (rec.flags & FLAG_IGNORED)
+      std::printf(" (I2C avstängd)");
+    std::printf("\n");
+  }
+}
+
+// Ett segment = START/RESTART till nästa RESTART/STOP, dvs. ett I2C-meddelande
+struct Segment {
+  uint64_t time_ns = 0;
+  uint8_t addr_byte = 0;
+  bool have_addr = false;
+  bool read = false;
+  std::vector<uint8_t> data;
+};
+
+// Samlar segmenten och skriver text (en rad per transaktion) och/eller pcap
+class SegmentSink {
+ public:
+  SegmentSink(bool text, FILE *pcap) : text_(text), pcap_(pcap) {}
+
+  void feed(const Record &rec) {
+    switch (rec.type) {
+      case REC_TIME:
+        break;
+      case REC_START:
+        this->end_transaction_();
+        this->line_time_ns_ = rec.time_ns;
+        this->in_transaction_ = true;
+        this->line_ = "S";
+        this->begin_segment_(rec.time_ns);
+        break;
+      case REC_RESTART:
+        this->end_segment_();
+        this->line_ += " Sr";
+        this->begin_segment_(rec.time_ns);
+        break;
+      case REC_ADDR:
+        this->segment_.addr_byte = rec.data;
+        this->segment_.have_addr = true;
+        this->segment_.read = (rec.data & 1) != 0;
+        this->append_("%02X%c", rec.data >> 1, this->segment_.read ? 'R' : 'W');
+        break;
+      case REC_WRITE:
+      case REC_READ:
+        this->segment_.read = (rec.type == REC_READ);
+        this->segment_.data.push_back(rec.data);
+        this->append_(rec.type == REC_READ ? "<%02X" : ">%02X", rec.data);
+        break;
+      case REC_STOP:
+        this->line_ += " P";
+        this->end_transaction_();
+        break;
+      case REC_ERROR:
+        this->append_("ERR(%02X)", rec.data);
+        break;
+      case REC_LOST:
+        this->end_transaction_();
+        if (this->text_)
+          std::printf("%s  -- %u poster förlorade --\n", format_time(rec.time_ns).c_str(), rec.data);
+        break;
+    }
+  }
+
+  void finish() { this->end_transaction_(); }
+
+ private:
+  void append_(const char *fmt, unsigned a, unsigned b = 0) {
+    char part[16];
+    std::snprintf(part, sizeof(part), fmt, a, b);
+    this->line_ += ' ';
+    this->line_ += part;
+  }
+
+  void begin_segment_(uint64_t time_ns) {
+    this->segment_ = Segment();
+    this->segment_.time_ns = time_ns;
+    this->segment_open_ = true;
+  }
+
+  void end_segment_() {
+    if (!this->segment_open_)
+      return;
+    this->segment_open_ = false;
+    if (this->pcap_ != nullptr)
+      this->write_pcap_(this->segment_);
+  }
+
+  void end_transaction_() {
+    this->end_segment_();
+    if (this->in_transaction_ && this->text_)
+      std::printf("%s  %s\n", format_time(this->line_time_ns_).c_str(), this->line_.c_str());
+    this->in_transaction_ = false;
+    this->line_.clear();
+  }
+
+  // Pseudohuvud för LINKTYPE_I2C_LINUX: buss (1 byte) + flaggor (4 byte, big endian),
+  // sedan adressbyten (adress << 1 | R/W) och data
+  void write_pcap_(const Segment &seg) {
+    uint8_t addr_byte = seg.have_addr ? seg.addr_byte : static_cast<uint8_t>((DEFAULT_ADDR << 1) | (seg.read ? 1 : 0));
+    uint32_t flags = seg.read ? PCAP_FLAG_READ : 0;
+    std::vector<uint8_t> packet = {0, static_cast<uint8_t>(flags >> 24), static_cast<uint8_t>(flags >> 16),
+                                   static_cast<uint8_t>(flags >> 8), static_cast<uint8_t>(flags), addr_byte};
+    packet.insert(packet.end(), seg.data.begin(), seg.data.end());
+
+    uint32_t rec_header[4] = {static_cast<uint32_t>(seg.time_ns / 1000000000ULL),
+                              static_cast<uint32_t>((seg.time_ns / 1000ULL) % 1000000ULL),
+                              static_cast<uint32_t>(packet.size()), static_cast<uint32_t>(packet.size())};
+    std::fwrite(rec_header, sizeof(rec_header), 1, this->pcap_);
+    std::fwrite(packet.data(), packet.size(), 1, this->pcap_);
+  }
+
+  bool text_;
+  FILE *pcap_;
+  bool in_transaction_ = false;
+  bool segment_open_ = false;
+  uint64_t line_time_ns_ = 0;
+  std::string line_;
+  Segment segment_;
+};
+
+void write_pcap_header(FILE *out) {
+  // Mikrosekundsupplösning, värdens byteordning (läsaren känner igen den på magic)
+  uint32_t magic = 0xA1B2C3D4;
+  uint16_t version[2] = {2, 4};
+  int32_t thiszone = 0;
+  uint32_t sigfigs = 0, snaplen = 65535, linktype = LINKTYPE_I2C_LINUX;
+  std::fwrite(&magic, sizeof(magic), 1, out);
+  std::fwrite(version, sizeof(version), 1, out);
+  std::fwrite(&thiszone, sizeof(thiszone), 1, out);
+  std::fwrite(&sigfigs, sizeof(sigfigs), 1, out);
+  std::fwrite(&snaplen, sizeof(snaplen), 1, out);
+  std::fwrite(&linktype, sizeof(linktype), 1, out);
+}
+
+int usage() {
+  std::fprintf(stderr, "Användning: i2c_capture_decode [--records] [--pcap ut.pcap] fangst.bin\n");
+  return 2;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  bool per_record = false;
+  const char *pcap_path = nullptr;
+  const char *in_path = nullptr;
+
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "--records") {
+      per_record = true;
+    } else if (arg == "--pcap" && i + 1 < argc) {
+      pcap_path = argv[++i];
+    } else if (!arg.empty() && arg[0] != '-' && in_path == nullptr) {
+      in_path = argv[i];
+    } else {
+      return usage();
+    }
+  }
+  if (in_path == nullptr)
+    return usage();
+
+  std::ifstream in(in_path, std::ios::binary);
+  if (!in) {
+    std::fprintf(stderr, "kan inte öppna %s\n", in_path);
+    return 1;
+  }
+  std::vector<uint8_t> buf((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+  unsigned sessions = 0, resyncs = 0;
+  std::vector<Record> records = parse(buf, sessions, resyncs);
+  if (sessions == 0) {
+    std::fprintf(stderr, "inget fångsthuvud hittat i %s\n", in_path);
+    return 1;
+  }
+
+  FILE *pcap = nullptr;
+  if (pcap_path != nullptr) {
+    pcap = std::fopen(pcap_path, "wb");
+    if (pcap == nullptr) {
+      std::fprintf(stderr, "kan inte skapa %s\n", pcap_path);
+      return 1;
+    }
+    write_pcap_header(pcap);
+  }
+
+  // Text skrivs bara när ingen pcap begärts (eller per post med --records)
+  if (per_record)
+    print_records(records);
+  SegmentSink sink(!per_record && pcap == nullptr, pcap);
+  for (const Record &rec : records)
+    sink.feed(rec);
+  sink.finish();
+
+  if (pcap != nullptr)
+    std::fclose(pcap);
+  std::fprintf(stderr, "%zu poster, %u fångster, %u omsynkningar\n", records.size(), sessions, resyncs);
+  return 0;
+}
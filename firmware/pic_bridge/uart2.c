@@ -0,0 +1,121 @@
+#include "uart2.h"
+#include "globals.h"
+#include <xc.h>
+
+#define RX_MASK (UART2_RX_BUFFER_SIZE - 1)
+#define TX_MASK (UART2_TX_BUFFER_SIZE - 1)
+
+// Ringbuffertar. Head skrivs av producenten, tail av konsumenten.
+// 8-bitars index gör att läsning/skrivning är atomisk mellan ISR och huvudloop.
+static volatile uint8_t rx_buffer[UART2_RX_BUFFER_SIZE];
+static volatile uint8_t rx_head = 0; // Skrivs av ISR
+static volatile uint8_t rx_tail = 0; // Skrivs av huvudloopen
+
+static volatile uint8_t tx_buffer[UART2_TX_BUFFER_SIZE];
+static volatile uint8_t tx_head = 0; // Skrivs av huvudloopen
+static volatile uint8_t tx_tail = 0; // Skrivs av ISR
+
+static volatile uint8_t rx_overruns = 0;
+static volatile uint8_t framing_errors = 0;
+
+void UART2_Init(void) {
+    // --- UART2 (XIAO Internal) - 115200 Baud @ 64MHz ---
+    UART2_SetBaudRate(UART2_DEFAULT_BAUD);
+    U2CON0bits.TXEN = 1;
+    U2CON0bits.RXEN = 1;
+    U2CON1bits.ON = 1;
+
+    // Låg prioritet: I2C-slaven mot pumpen ska alltid gå före ESP-länken
+    IPR8bits.U2RXIP = 0;
+    IPR8bits.U2TXIP = 0;
+
+    PIR8bits.U2RXIF = 0;
+    PIE8bits.U2RXIE = 1; // RX-avbrott alltid på
+    PIE8bits.U2TXIE = 0; // TX-avbrott slås på först när det finns data att skicka
+}
+
+void UART2_SetBaudRate(uint32_t baud) {
+    // High speed mode (BRGS=1): U2BRG = (Fosc / (4 * Baud)) - 1, avrundat
+    // 115200 -> 138, 460800 -> 34, 1000000 -> 15 (exakt)
+    U2CON0bits.BRGS = 1;
+    U2BRG = (uint16_t)(((_XTAL_FREQ + 2 * baud) / (4 * baud)) - 1);
+}
+
+bool UART2_TxIdle(void) {
+    return (tx_tail == tx_head) && U2ERRIRbits.TXMTIF;
+}
+
+bool UART2_ISR_Handler(void) {
+    bool handled = false;
+
+    // 1. RX: Töm hela HW-FIFO:n till ringbufferten
+    if (PIE8bits.U2RXIE && PIR8bits.U2RXIF) {
+        while (!U2FIFObits.RXBE) {
+            if (U2ERRIRbits.FERIF) {
+                framing_errors++; // Gäller byten överst i FIFO:n
+            }
+            uint8_t rx = U2RXB;
+            uint8_t next = (uint8_t)((rx_head + 1) & RX_MASK);
+            if (next != rx_tail) {
+                rx_buffer[rx_head] = rx;
+                rx_head = next;
+            } else {
+                rx_overruns++; // Ringbufferten full, byten kastas
+            }
+        }
+        if (U2ERRIRbits.RXFOIF) {
+            // HW-FIFO:n hann svämma över innan ISR:en kördes
+            U2ERRIRbits.RXFOIF = 0;
+            rx_overruns++;
+        }
+        handled = true;
+    }
+
+    // 2. TX: Fyll HW-FIFO:n så länge det finns data
+    if (PIE8bits.U2TXIE && PIR8bits.U2TXIF) {
+        while (!U2FIFObits.TXBF && tx_tail != tx_head) {
+            U2TXB = tx_buffer[tx_tail];
+            tx_tail = (uint8_t)((tx_tail + 1) & TX_MASK);
+        }
+        if (tx_tail == tx_head) {
+            PIE8bits.U2TXIE = 0; // Inget mer att skicka
+        }
+        handled = true;
+    }
+
+    return handled;
+}
+
+uint8_t UART2_RxCount(void) {
+    return (uint8_t)((rx_head - rx_tail) & RX_MASK);
+}
+
+uint8_t UART2_Read(void) {
+    uint8_t data = rx_buffer[rx_tail];
+    rx_tail = (uint8_t)((rx_tail + 1) & RX_MASK);
+    return data;
+}
+
+uint16_t UART2_TxFree(void) {
+    // En plats hålls alltid tom för att skilja full från tom buffert
+    return (uint16_t)(TX_MASK - ((uint8_t)(tx_head - tx_tail) & TX_MASK));
+}
+
+bool UART2_Write(uint8_t data) {
+    uint8_t next = (uint8_t)((tx_head + 1) & TX_MASK);
+    if (next == tx_tail) {
+        return false; // Full
+    }
+    tx_buffer[tx_head] = data;
+    tx_head = next;
+    PIE8bits.U2TXIE = 1; // ISR:en tar över sändningen
+    return true;
+}
+
+uint8_t UART2_RxOverruns(void) {
+    return rx_overruns;
+}
+
+uint8_t UART2_FramingErrors(void) {
+    return framing_errors;
+}
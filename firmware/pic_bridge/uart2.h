@@ -0,0 +1,74 @@
+#ifndef UART2_H
+#define UART2_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Ringbuffertstorlekar (måste vara 2-potenser, max 256 p.g.a. 8-bitars index).
+// En plats hålls alltid tom för att skilja full från tom, så TX rymmer 255 bytes.
+// Ett READ_BLOCK-svar med hela registerMap (263 bytes med ram) får inte plats på en
+// gång; esp_link.c strömmar resten i den takt ISR:en tömmer bufferten, så länken går
+// ändå i linjehastighet (mäts av esp_dump_throughput i host/bench).
+#define UART2_RX_BUFFER_SIZE 64
+#define UART2_TX_BUFFER_SIZE 256
+
+// Baudrate efter reset. Högre hastigheter förhandlas av länkprotokollet (esp_link.c).
+#define UART2_DEFAULT_BAUD 115200UL
+
+/**
+ * @brief Initierar UART2 (XIAO/ESP32-länken) med avbrottsdrivna RX/TX-ringbuffertar.
+ * UART2_DEFAULT_BAUD @ 64MHz.
+ */
+void UART2_Init(void);
+
+/**
+ * @brief Byter baudrate. Ska endast anropas när UART2_TxIdle() är true.
+ * @param baud Önskad baudrate (t.ex. 115200, 460800, 1000000).
+ */
+void UART2_SetBaudRate(uint32_t baud);
+
+/**
+ * @brief true när TX-ringbufferten är tom och sista stoppbiten har lämnat skiftregistret.
+ */
+bool UART2_TxIdle(void);
+
+/**
+ * @brief UART2 Interrupt Service Routine Logic.
+ * Tömmer RX-FIFO:n till RX-ringbufferten och fyller TX-FIFO:n från TX-ringbufferten.
+ * Den är designad att kallas från låg-prioritets-ISR i main.c.
+ * @return true om avbrottet hanterades, false annars.
+ */
+bool UART2_ISR_Handler(void);
+
+/**
+ * @brief Antal mottagna bytes som väntar i RX-ringbufferten.
+ */
+uint8_t UART2_RxCount(void);
+
+/**
+ * @brief Hämtar nästa mottagna byte. Får endast anropas om UART2_RxCount() > 0.
+ */
+uint8_t UART2_Read(void);
+
+/**
+ * @brief Antal lediga platser i TX-ringbufferten.
+ */
+uint16_t UART2_TxFree(void);
+
+/**
+ * @brief Lägger en byte i TX-ringbufferten och startar sändning (blockerar inte).
+ * @return false om bufferten är full (byten kastas).
+ */
+bool UART2_Write(uint8_t data);
+
+/**
+ * @brief Antal bytes som kastats p.g.a. full RX-ringbuffert eller HW-FIFO-överskridning.
+ */
+uint8_t UART2_RxOverruns(void);
+
+/**
+ * @brief Antal mottagna bytes med ramfel (fel baudrate hos motparten).
+ */
+uint8_t UART2_FramingErrors(void);
+
+#endif // UART2_H
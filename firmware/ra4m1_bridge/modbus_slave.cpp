@@ -0,0 +1,200 @@
+#include "modbus_slave.h"
+
+// Max antal register per läsning (FC03/04) och skrivning (FC16)
+#define RTU_MAX_READ_REGS  125
+#define RTU_MAX_WRITE_REGS 123
+
+// Modbus CRC-16 (polynom 0xA001), LSB först på bussen
+static uint16_t crc16(const uint8_t *data, uint16_t length) {
+  uint16_t crc = 0xFFFF;
+  while (length--) {
+    crc ^= *data++;
+    for (uint8_t bit = 0; bit < 8; bit++) {
+      crc = (crc & 1) ? (crc >> 1) ^ 0xA001 : crc >> 1;
+    }
+  }
+  return crc;
+}
+
+ModbusSlave::ModbusSlave(uint8_t id, Stream &port, uint8_t dirPin, const RegisterBank *banks, uint8_t bankCount)
+    : id(id), port(port), dirPin(dirPin), banks(banks), bankCount(bankCount) {}
+
+void ModbusSlave::begin(unsigned long baud) {
+  // Ett tecken är 11 bitar. Över 19200 baud föreskriver specen fasta 1750 us.
+  t35Micros = (baud > 19200) ? 1750 : (11UL * 1000000UL * 7UL) / (baud * 2UL);
+  charMicros = (11UL * 1000000UL + baud - 1) / baud;
+  if (dirPin > 1) {
+    pinMode(dirPin, OUTPUT);
+    digitalWrite(dirPin, LOW); // Lyssna
+  }
+  frameLen = 0;
+  frameOverflow = false;
+}
+
+uint16_t *ModbusSlave::resolve(uint16_t address, uint16_t count, bool write) const {
+  for (uint8_t i = 0; i < bankCount; i++) {
+    const RegisterBank &bank = banks[i];
+    if (address < bank.start || address - bank.start >= bank.length) {
+      continue;
+    }
+    uint16_t offset = address - bank.start;
+    if (count > bank.length - offset || (write && !bank.writable)) {
+      return nullptr;
+    }
+    return &bank.regs[offset];
+  }
+  return nullptr;
+}
+
+void ModbusSlave::clearCounters() {
+  stats = ModbusCounters();
+  if (clearHandler != nullptr) clearHandler();
+}
+
+uint16_t ModbusSlave::getWord(uint16_t pos) const {
+  return (uint16_t)((frame[pos] << 8) | frame[pos + 1]);
+}
+
+// FC08: underfunktion i frame[2..3], data i frame[4..5]. Svaret är ett eko där
+// räknarna läggs i datafältet.
+uint16_t ModbusSlave::processDiagnostics(uint8_t *exception) {
+  if (frameLen < 8) { *exception = MB_EX_ILLEGAL_VALUE; return 0; }
+  uint16_t sub = getWord(2);
+  if (sub == MB_DIAG_RETURN_QUERY) {
+    return frameLen - 2; // Hela förfrågan tillbaka, godtycklig datalängd
+  }
+  if (frameLen != 8) { *exception = MB_EX_ILLEGAL_VALUE; return 0; }
+
+  uint16_t value;
+  switch (sub) {
+    case MB_DIAG_RESTART_COMM:
+    case MB_DIAG_CLEAR_COUNTERS:  clearCounters(); return 6;
+    case MB_DIAG_CLEAR_OVERRUNS:  stats.overruns = 0; return 6;
+    case MB_DIAG_BUS_MESSAGES:    value = stats.busMessages; break;
+    case MB_DIAG_CRC_ERRORS:      value = stats.crcErrors; break;
+    case MB_DIAG_EXCEPTIONS:      value = stats.exceptions; break;
+    case MB_DIAG_SERVER_MESSAGES: value = stats.serverMessages; break;
+    case MB_DIAG_NO_RESPONSE:     value = stats.noResponse; break;
+    case MB_DIAG_OVERRUNS:        value = stats.overruns; break;
+    default:
+      *exception = MB_EX_ILLEGAL_FUNCTION;
+      return 0;
+  }
+  frame[4] = (uint8_t)(value >> 8);
+  frame[5] = (uint8_t)(value & 0xFF);
+  return 6;
+}
+
+/**
+ * @brief Tolkar PDU:n i frame[1..] och bygger svaret på samma plats.
+ * @return Svarslängd inklusive slavadress men utan CRC, eller 0 vid undantag
+ * (undantagskoden läggs då i *exception).
+ */
+uint16_t ModbusSlave::processPdu(uint8_t *exception) {
+  uint16_t start, count, pos;
+  uint16_t *regs;
+
+  switch (frame[1]) {
+    case MB_FC_READ_HOLDING:
+    case MB_FC_READ_INPUT:
+      // Båda funktionerna läser samma banker
+      if (frameLen != 8) { *exception = MB_EX_ILLEGAL_VALUE; return 0; }
+      start = getWord(2);
+      count = getWord(4);
+      if (count == 0 || count > RTU_MAX_READ_REGS) { *exception = MB_EX_ILLEGAL_VALUE; return 0; }
+      regs = resolve(start, count, false);
+      if (regs == nullptr) { *exception = MB_EX_ILLEGAL_ADDRESS; return 0; }
+      frame[2] = (uint8_t)(count * 2);
+      pos = 3;
+      for (uint16_t i = 0; i < count; i++) {
+        uint16_t value = regs[i]; // Ett ord i taget; Wire-avbrotten skriver hela ord
+        frame[pos++] = (uint8_t)(value >> 8);
+        frame[pos++] = (uint8_t)(value & 0xFF);
+      }
+      return pos;
+
+    case MB_FC_WRITE_SINGLE:
+      if (frameLen != 8) { *exception = MB_EX_ILLEGAL_VALUE; return 0; }
+      regs = resolve(getWord(2), 1, true);
+      if (regs == nullptr) { *exception = MB_EX_ILLEGAL_ADDRESS; return 0; }
+      *regs = getWord(4);
+      return 6; // Eko av förfrågan
+
+    case MB_FC_WRITE_MULTIPLE:
+      start = getWord(2);
+      count = getWord(4);
+      if (count == 0 || count > RTU_MAX_WRITE_REGS || frame[6] != count * 2
+          || frameLen != 9 + count * 2) { *exception = MB_EX_ILLEGAL_VALUE; return 0; }
+      regs = resolve(start, count, true);
+      if (regs == nullptr) { *exception = MB_EX_ILLEGAL_ADDRESS; return 0; }
+      for (uint16_t i = 0; i < count; i++) {
+        regs[i] = getWord(7 + i * 2);
+      }
+      return 6; // Adress + funktion + start + antal
+
+    case MB_FC_DIAGNOSTICS:
+      return processDiagnostics(exception);
+
+    default:
+      *exception = MB_EX_ILLEGAL_FUNCTION;
+      return 0;
+  }
+}
+
+void ModbusSlave::send(uint16_t length) {
+  uint16_t crc = crc16(frame, length);
+  frame[length++] = (uint8_t)(crc & 0xFF);
+  frame[length++] = (uint8_t)(crc >> 8);
+
+  if (dirPin > 1) digitalWrite(dirPin, HIGH); // Driv bussen
+  port.write(frame, length);
+  port.flush(); // Väntar tills TX-bufferten är tom
+  if (dirPin > 1) {
+    delayMicroseconds(charMicros); // Sista tecknet kan ligga kvar i skiftregistret
+    digitalWrite(dirPin, LOW);
+  }
+}
+
+void ModbusSlave::poll() {
+  while (port.available() > 0) {
+    uint8_t rx = (uint8_t)port.read();
+    if (frameLen < FRAME_SIZE) {
+      frame[frameLen++] = rx;
+    } else {
+      frameOverflow = true;
+    }
+    lastByteMicros = micros();
+  }
+
+  // Ramen är komplett när bussen varit tyst i T3.5
+  if (frameLen == 0 || micros() - lastByteMicros < t35Micros) {
+    return;
+  }
+
+  uint8_t address = frame[0];
+  stats.busMessages++;
+  if (frameOverflow) {
+    stats.overruns++;
+  } else if (frameLen < 4 || crc16(frame, frameLen) != 0) {
+    // CRC över hela ramen inklusive CRC-fältet blir 0 för en korrekt ram
+    stats.crcErrors++;
+  } else if (address == id || address == 0) {
+    stats.serverMessages++;
+    uint8_t exception = 0;
+    uint16_t responseLen = processPdu(&exception);
+    // Broadcast (adress 0) besvaras aldrig
+    if (address == 0) {
+      stats.noResponse++;
+    } else {
+      if (responseLen == 0) {
+        frame[1] |= 0x80;
+        frame[2] = exception;
+        responseLen = 3;
+        stats.exceptions++;
+      }
+      send(responseLen);
+    }
+  }
+  frameLen = 0;
+  frameOverflow = false;
+}
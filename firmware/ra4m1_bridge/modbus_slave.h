@@ -0,0 +1,113 @@
+#ifndef MODBUS_SLAVE_H
+#define MODBUS_SLAVE_H
+
+#include <Arduino.h>
+
+// --- Modbus RTU-slav över glesa registerbanker ---
+// Ersätter smarmengol-bibliotekets poll(), som bara tar en sammanhängande array med
+// 8-bitars storlek. Varje bank är en egen array med en Modbus-startadress
+// (BANK_*_START/_LEN i registers.h); en förfrågan måste ligga helt inom en bank,
+// annars svarar slaven med undantag 02. De publika adresserna är desamma som förut.
+
+// Stödda funktionskoder
+#define MB_FC_READ_HOLDING      0x03
+#define MB_FC_READ_INPUT        0x04
+#define MB_FC_WRITE_SINGLE      0x06
+#define MB_FC_DIAGNOSTICS       0x08
+#define MB_FC_WRITE_MULTIPLE    0x10
+
+// FC08: stödda underfunktioner
+#define MB_DIAG_RETURN_QUERY    0x00 // Eko av förfrågan
+#define MB_DIAG_RESTART_COMM    0x01 // Nollställer räknarna (ingen omstart)
+#define MB_DIAG_CLEAR_COUNTERS  0x0A
+#define MB_DIAG_BUS_MESSAGES    0x0B
+#define MB_DIAG_CRC_ERRORS      0x0C
+#define MB_DIAG_EXCEPTIONS      0x0D
+#define MB_DIAG_SERVER_MESSAGES 0x0E
+#define MB_DIAG_NO_RESPONSE     0x0F
+#define MB_DIAG_OVERRUNS        0x12
+#define MB_DIAG_CLEAR_OVERRUNS  0x14
+
+// Undantagskoder
+#define MB_EX_ILLEGAL_FUNCTION  0x01
+#define MB_EX_ILLEGAL_ADDRESS   0x02
+#define MB_EX_ILLEGAL_VALUE     0x03
+
+struct RegisterBank {
+  uint16_t start;   // Första Modbus-adressen
+  uint16_t length;  // Antal ord i regs
+  uint16_t *regs;
+  bool writable;    // FC06/FC16 tillåtna
+};
+
+// Bussräknare enligt Modbus-specen (FC08), räknar runt
+struct ModbusCounters {
+  uint16_t busMessages;     // Alla ramar på bussen
+  uint16_t crcErrors;
+  uint16_t exceptions;      // Skickade undantagssvar
+  uint16_t serverMessages;  // Ramar till den här slaven, inklusive broadcast
+  uint16_t noResponse;      // Broadcast, besvaras inte
+  uint16_t overruns;        // Ramar längre än bufferten
+};
+
+class ModbusSlave {
+ public:
+  /**
+   * @param dirPin DE/RE för RS485-transceivern, 0 eller 1 = ingen (som i smarmengol).
+   * @param banks Bankerna i stigande adressordning.
+   */
+  ModbusSlave(uint8_t id, Stream &port, uint8_t dirPin, const RegisterBank *banks, uint8_t bankCount);
+
+  /**
+   * @brief Sätter ramtimingen (T3.5) för porten, som redan ska vara startad med samma baud.
+   */
+  void begin(unsigned long baud);
+
+  /**
+   * @brief Samlar mottagna bytes och besvarar en komplett ram. Blockerar bara medan svaret skickas.
+   */
+  void poll();
+
+  /**
+   * @brief Slår upp count ord från address.
+   * @return Pekare till första ordet, eller nullptr om intervallet inte ligger inom en bank
+   * (eller banken inte är skrivbar och write är satt).
+   */
+  uint16_t *resolve(uint16_t address, uint16_t count, bool write) const;
+
+  const ModbusCounters &counters() const { return stats; }
+
+  /**
+   * @brief Anropas när en master nollställer räknarna (FC08 0x01/0x0A), så att
+   * bryggans egna räknare nollställs samtidigt.
+   */
+  void onClearCounters(void (*handler)()) { clearHandler = handler; }
+
+ private:
+  // Max ADU-storlek enligt Modbus RTU (adress + PDU 253 + CRC 2)
+  static const uint16_t FRAME_SIZE = 256;
+
+  uint16_t processPdu(uint8_t *exception);
+  uint16_t processDiagnostics(uint8_t *exception);
+  void clearCounters();
+  uint16_t getWord(uint16_t pos) const;
+  void send(uint16_t length);
+
+  uint8_t id;
+  Stream &port;
+  uint8_t dirPin;
+  const RegisterBank *banks;
+  uint8_t bankCount;
+
+  unsigned long t35Micros = 1750;
+  unsigned long charMicros = 100;
+  unsigned long lastByteMicros = 0;
+  uint8_t frame[FRAME_SIZE];
+  uint16_t frameLen = 0;
+  bool frameOverflow = false;
+
+  ModbusCounters stats = {};
+  void (*clearHandler)() = nullptr;
+};
+
+#endif // MODBUS_SLAVE_H
@@ -1,7 +1,7 @@
 /*
  * Thermia I2C <-> Modbus Bridge
  * Hårdvara: Seeed Studio XIAO RA4M1
- * Bibliotek: Modbus-Master-Slave-for-Arduino (smarmengol)
+ * Modbus RTU: modbus_slave.cpp (registerbanker, se registers.h)
  */
 
 // ============================================================================
@@ -16,22 +16,18 @@
 #include <Wire.h>
 #include <OneWire.h>
 #include <DallasTemperature.h>
-#include <ModbusRtu.h>   // Smarmengol biblioteket
 #include <EEPROM.h>
-#include <SoftwareSerial.h>
 
 // --- Konfiguration beroende på Scenario ---
+// Modbus går alltid på hårdvaru-UART:en Serial1 (TX=D6, RX=D7), avbrottsdriven med
+// ringbuffertar i kärnan. Baud och paritet läses från EEPROM (se loadCommConfig()).
+#define COMM_SERIAL Serial1
 #ifdef CONFIG_PIGGYBACK_MODE
-  // SCENARIO 2: PIGGYBACK (Hardware Serial1)
-  #define COMM_SERIAL Serial1
-  #define COMM_BAUD 9600
-  #define RS485_DIR_PIN 0 // Används ej, sätt till 0
+  // SCENARIO 2: PIGGYBACK (C6 direkt på D6/D7)
+  #define RS485_DIR_PIN 0 // Används ej (0 eller 1 = ingen riktningspinne)
 #else
-  // SCENARIO 1 & 3: RS485 MODUL (SoftwareSerial)
-  SoftwareSerial rs485Serial(D4, D5); // RX=D4, TX=D5
-  #define COMM_SERIAL rs485Serial
-  #define COMM_BAUD 9600
-  #define RS485_DIR_PIN D2 
+  // SCENARIO 1 & 3: RS485 MODUL (DI på D6, RO på D7, DE/RE på D2)
+  #define RS485_DIR_PIN D2
 #endif
 
 // --- Debug Serial ---
@@ -39,47 +35,179 @@
 
 // --- Gemensam Hårdvara ---
 #define I2C_SLAVE_ADDR 0x2E   
-#define MODBUS_SLAVE_ID 10    
 #define ONE_WIRE_BUS D0        
 
-// --- Minnesmappning ---
-#define TOTAL_REGS 1020 
-#define SENSOR_START_REG 1000
-#define MAX_SENSORS 10 
-
-// --- Globala Data ---
-// Detta är "minnet" som Modbus och I2C delar på
-uint16_t au16data[TOTAL_REGS];
+// --- Minnesmappning (genereras ur firmware/pic_bridge/tools/registers.schema) ---
+#include "registers.h"
+#include "modbus_slave.h"
+#define MAX_SENSORS REG_DS18B20_SENSOR_LEN
+
+// Layoutversion i diagnostikbanken. Major ändras när en adress flyttas.
+#define FW_VERSION_MAJOR 1
+#define FW_VERSION_MINOR 0
+
+// --- Registerbanker ---
+// En array per bank i stället för en platt array upp till sensorerna på 1000+.
+// Modbus slår upp adresserna via banks[]; pumpen (I2C) använder bara thermiqRegs.
+uint16_t thermiqRegs[BANK_THERMIQ_LEN];
+uint16_t sensorRegs[BANK_SENSOR_LEN];
+uint16_t configRegs[BANK_CONFIG_LEN];
+uint16_t diagRegs[BANK_DIAG_LEN];
+
+const RegisterBank banks[] = {
+  { BANK_THERMIQ_START, BANK_THERMIQ_LEN, thermiqRegs, true },  // Börvärden skrivs till pumpen
+  { BANK_SENSOR_START,  BANK_SENSOR_LEN,  sensorRegs,  false },
+  { BANK_CONFIG_START,  BANK_CONFIG_LEN,  configRegs,  true },
+  { BANK_DIAG_START,    BANK_DIAG_LEN,    diagRegs,    false },
+};
 
-// Modbus Objekt (ID, Port, TxEnablePin)
-Modbus slave(MODBUS_SLAVE_ID, COMM_SERIAL, RS485_DIR_PIN);
+// Modbus Objekt (ID, Port, TxEnablePin, banker)
+ModbusSlave slave(MODBUS_SLAVE_ID, COMM_SERIAL, RS485_DIR_PIN, banks, sizeof(banks) / sizeof(banks[0]));
 
 OneWire oneWire(ONE_WIRE_BUS);
 DallasTemperature sensors(&oneWire);
 
-volatile uint8_t i2cIndex = 0;
+// --- I2C mot pumpen ---
+// Index i pumpens rymd; 16 bitar så att bytes efter index 255 kastas i stället för att slå runt
+volatile uint16_t i2cIndex = 0;
+
+// Max antal bytes som förladdas per läsning (Wire-bibliotekets buffert)
+#ifndef I2C_TX_BURST
+#define I2C_TX_BURST 32
+#endif
+
+// Pumpindex där ett värde i heltal + tiondelar börjar (registers.h); tiondelarna ligger på nästa index
+bool decimalWhole[REG_THERMIQ_WORDS];
 unsigned long lastTempRequest = 0;
 const unsigned long tempInterval = 10000;
 
+// --- Temperaturmätning utan blockering ---
+// Konverteringen startas och loop() fortsätter polla Modbus; resultaten läses
+// när konverteringstiden för den högsta upplösningen har gått, en givare per varv.
+enum TempState {
+  TEMP_IDLE,        // Väntar på nästa intervall, tillämpar ändrad upplösning
+  TEMP_CONVERTING,  // Konvertering pågår på bussen
+  TEMP_READING      // Läser scratchpad, en givare per loop()-varv
+};
+
+TempState tempState = TEMP_IDLE;
+unsigned long conversionStart = 0;
+unsigned long conversionWait = 0;
+uint8_t tempIndex = 0;
+
+#define DEFAULT_RESOLUTION 12
+
 struct SavedSensor {
   DeviceAddress addr;
   bool active;
+  uint8_t resolution;  // Upplösningen som senast skrevs till givaren (bit)
 };
 
 SavedSensor knownSensors[MAX_SENSORS];
 
+// --- Bakgrundssökning på 1-Wire (hot-plug) ---
+// Ett search()-steg (en givare, ~15 ms) per loop()-varv mellan konverteringarna.
+// När sökningen är klar markeras kända givare som inte hittades i REG_DS18B20_STALE.
+const unsigned long scanInterval = 30000;
+unsigned long lastScan = 0;
+bool scanRunning = false;
+uint16_t scanSeen = 0;  // Bit i: platsen hittades i pågående sökning
+uint8_t scanFound = 0;
+
+#define SENSOR_REG(reg) sensorRegs[(reg) - BANK_SENSOR_START]
+
+// --- Diagnostik (diagnostikbanken, kopieras dit i slutet av varje loop()-varv) ---
+#define DIAG_REG(reg) diagRegs[(reg) - BANK_DIAG_START]
+
+// Räknas i Wire-callbackarna (avbrott), räknar runt
+volatile uint16_t i2cRxEvents = 0;
+volatile uint16_t i2cRequestEvents = 0;
+volatile uint16_t i2cOverruns = 0;  // Kastade bytes och läsningar efter index 255
+
+// Tider i us, mättar på 65535
+unsigned long lastLoopMicros = 0;
+uint16_t loopPeriodMin = 0xFFFF;
+uint16_t loopPeriodMax = 0;
+uint16_t tempTimeLast = 0;
+uint16_t tempTimeMax = 0;
+
+// --- RS485-inställningar i EEPROM (efter givarnas ROM-adresser) ---
+#define EEPROM_COMM_ADDR 128
+#define COMM_CONFIG_MAGIC 0x4D42
+
+struct CommConfig {
+  uint16_t magic;
+  uint16_t baudDiv100;  // Som REG_MODBUS_BAUD
+  uint16_t parity;      // Som REG_MODBUS_PARITY
+};
+
+CommConfig commConfig;
+
+bool validCommConfig(uint16_t baudDiv100, uint16_t parity) {
+  static const uint16_t allowed[] = { 12, 24, 48, 96, 192, 384, 576, 1152, 2304 };
+  if (parity > 2) return false;
+  for (uint8_t i = 0; i < sizeof(allowed) / sizeof(allowed[0]); i++) {
+    if (allowed[i] == baudDiv100) return true;
+  }
+  return false;
+}
+
+// Läser sparad baud/paritet, eller schemats standard om EEPROM:en är tom eller ogiltig
+void loadCommConfig() {
+  EEPROM.get(EEPROM_COMM_ADDR, commConfig);
+  if (commConfig.magic != COMM_CONFIG_MAGIC || !validCommConfig(commConfig.baudDiv100, commConfig.parity)) {
+    commConfig.magic = COMM_CONFIG_MAGIC;
+    commConfig.baudDiv100 = MODBUS_DEFAULT_BAUD / 100;
+    commConfig.parity = MODBUS_DEFAULT_PARITY;
+  }
+  configRegs[REG_MODBUS_BAUD - BANK_CONFIG_START] = commConfig.baudDiv100;
+  configRegs[REG_MODBUS_PARITY - BANK_CONFIG_START] = commConfig.parity;
+}
+
+// Sparar baud/paritet som skrivits via Modbus. Porten byter först vid omstart,
+// så att svaret på skrivningen går ut med de gamla inställningarna.
+void handleCommConfig() {
+  uint16_t baudDiv100 = configRegs[REG_MODBUS_BAUD - BANK_CONFIG_START];
+  uint16_t parity = configRegs[REG_MODBUS_PARITY - BANK_CONFIG_START];
+  if (baudDiv100 == commConfig.baudDiv100 && parity == commConfig.parity) return;
+
+  if (!validCommConfig(baudDiv100, parity)) {
+    // Ogiltigt värde: visa det som gäller igen
+    configRegs[REG_MODBUS_BAUD - BANK_CONFIG_START] = commConfig.baudDiv100;
+    configRegs[REG_MODBUS_PARITY - BANK_CONFIG_START] = commConfig.parity;
+    return;
+  }
+  commConfig.baudDiv100 = baudDiv100;
+  commConfig.parity = parity;
+  EEPROM.put(EEPROM_COMM_ADDR, commConfig);
+  DEBUG_SERIAL.print("Modbus saved: ");
+  DEBUG_SERIAL.print((unsigned long)baudDiv100 * 100);
+  DEBUG_SERIAL.println(" baud, active after restart");
+}
+
 void setup() {
   DEBUG_SERIAL.begin(115200);
   
-  // Initiera Modbus Serial
-  COMM_SERIAL.begin(COMM_BAUD);
+  // Initiera Modbus Serial med sparade inställningar
+  loadCommConfig();
+  unsigned long baud = (unsigned long)commConfig.baudDiv100 * 100;
+  static const uint16_t serialConfig[] = { SERIAL_8N1, SERIAL_8O1, SERIAL_8E1 };
+  COMM_SERIAL.begin(baud, serialConfig[commConfig.parity]);
   
-  // Starta Modbus (Smarmengol biblioteket startar via konstruktorn och begin())
-  slave.start();
+  // Starta Modbus (ramtimingen följer baud)
+  slave.begin(baud);
+  slave.onClearCounters(clearDiagnostics);
+  DIAG_REG(REG_FW_MAJOR_VERSION) = FW_VERSION_MAJOR;
+  DIAG_REG(REG_FW_MINOR_VERSION) = FW_VERSION_MINOR;
 
-  // Initiera OneWire
+  // Initiera OneWire. requestTemperatures() returnerar direkt, handleTemperature() väntar ut konverteringen.
   sensors.begin();
-  
+  sensors.setWaitForConversion(false);
+
+  // Markera pumpens värden i heltal + tiondelar innan Wire-callbackarna startar
+  #define MARK_DECIMAL(whole) decimalWhole[whole] = true;
+  THERMIQ_DECIMAL_PAIRS(MARK_DECIMAL)
+
   // Initiera I2C Slav på D8/D9 (Wire)
   Wire.setSDA(D9);
   Wire.setSCL(D8);
@@ -93,52 +221,141 @@ void setup() {
   #else
     DEBUG_SERIAL.println("Mode: RS485 (Ctrl D2)");
   #endif
+  DEBUG_SERIAL.print("Modbus baud: ");
+  DEBUG_SERIAL.println(baud);
   
   initSensors();
 }
 
 void loop() {
-  // Modbus Poll: Vi skickar med vår data-array
-  slave.poll(au16data, TOTAL_REGS);
+  measureLoopPeriod();
+
+  // Modbus Poll: Adresserna slås upp i bankerna
+  slave.poll();
   
   yield();
+  unsigned long start = micros();
   handleTemperature();
+  tempTimeLast = saturate16(micros() - start);
+  if (tempTimeLast > tempTimeMax) tempTimeMax = tempTimeLast;
+
+  handleCommConfig();
+  updateDiagnostics();
+}
+
+// --- Diagnostik ---
+
+uint16_t saturate16(unsigned long value) {
+  return value > 0xFFFF ? 0xFFFF : (uint16_t)value;
+}
+
+// Tid mellan två loop()-varv, alltså hur länge Modbus och sensorerna som mest väntar
+void measureLoopPeriod() {
+  unsigned long now = micros();
+  if (lastLoopMicros != 0) {
+    uint16_t period = saturate16(now - lastLoopMicros);
+    if (period < loopPeriodMin) loopPeriodMin = period;
+    if (period > loopPeriodMax) loopPeriodMax = period;
+  }
+  lastLoopMicros = now;
+}
+
+// FC08 0x01/0x0A: nollställ bryggans räknare tillsammans med Modbus-räknarna
+void clearDiagnostics() {
+  noInterrupts();
+  i2cRxEvents = 0;
+  i2cRequestEvents = 0;
+  i2cOverruns = 0;
+  interrupts();
+  lastLoopMicros = 0;
+  loopPeriodMin = 0xFFFF;
+  loopPeriodMax = 0;
+  tempTimeMax = 0;
+}
+
+void updateDiagnostics() {
+  const ModbusCounters &mb = slave.counters();
+  DIAG_REG(REG_MB_BUS_MESSAGES) = mb.busMessages;
+  DIAG_REG(REG_MB_CRC_ERRORS) = mb.crcErrors;
+  DIAG_REG(REG_MB_EXCEPTIONS) = mb.exceptions;
+  DIAG_REG(REG_MB_OVERRUNS) = mb.overruns;
+  DIAG_REG(REG_I2C_RX_EVENTS) = i2cRxEvents;
+  DIAG_REG(REG_I2C_REQUEST_EVENTS) = i2cRequestEvents;
+  DIAG_REG(REG_I2C_OVERRUNS) = i2cOverruns;
+  DIAG_REG(REG_PERF_LOOP_PERIOD_MIN_US) = (loopPeriodMin == 0xFFFF) ? 0 : loopPeriodMin;
+  DIAG_REG(REG_PERF_LOOP_PERIOD_MAX_US) = loopPeriodMax;
+  DIAG_REG(REG_PERF_TEMP_LAST_US) = tempTimeLast;
+  DIAG_REG(REG_PERF_TEMP_MAX_US) = tempTimeMax;
 }
 
 // --- Sensorlogik ---
 
 void initSensors() {
-  DEBUG_SERIAL.println("Scanning OneWire...");
-  
   for (int i = 0; i < MAX_SENSORS; i++) {
-    int eepromAddr = i * 8;
-    for (int j = 0; j < 8; j++) {
-      knownSensors[i].addr[j] = EEPROM.read(eepromAddr + j);
-    }
+    EEPROM.get(i * sizeof(DeviceAddress), knownSensors[i].addr);
     knownSensors[i].active = false;
+    knownSensors[i].resolution = 0; // Okänd, skrivs innan första konverteringen
   }
 
-  int deviceCount = sensors.getDeviceCount();
+  // Första sökningen görs klart direkt så att givarna finns från start
+  DEBUG_SERIAL.println("Scanning OneWire...");
+  while (!scanStep()) {}
+  lastScan = millis();
   DEBUG_SERIAL.print("Found devices: ");
-  DEBUG_SERIAL.println(deviceCount);
-
-  for (int i = 0; i < deviceCount; i++) {
-    DeviceAddress tempAddr;
-    if (sensors.getAddress(tempAddr, i)) {
-      int index = registerSensor(tempAddr);
-      if (index >= 0) {
-         printAddress(tempAddr);
-         DEBUG_SERIAL.print(" -> Reg ");
-         DEBUG_SERIAL.println(SENSOR_START_REG + index);
-      }
+  DEBUG_SERIAL.println(scanFound);
+}
+
+/**
+ * @brief Ett steg i ROM-sökningen: hittar nästa givare på bussen.
+ * @return true när sökningen är klar (och REG_DS18B20_STALE/COUNT uppdaterade).
+ */
+bool scanStep() {
+  if (!scanRunning) {
+    oneWire.reset_search();
+    scanSeen = 0;
+    scanFound = 0;
+    scanRunning = true;
+  }
+
+  DeviceAddress addr;
+  if (oneWire.search(addr)) {
+    if (OneWire::crc8(addr, 7) == addr[7] && sensors.validFamily(addr)) {
+      scanFound++;
+      int index = registerSensor(addr);
+      if (index >= 0) scanSeen |= (1 << index);
     }
+    return false;
   }
+
+  // Sökningen klar: kända platser som inte svarade är inaktuella
+  uint16_t stale = 0;
+  for (int i = 0; i < MAX_SENSORS; i++) {
+    if (scanSeen & (1 << i)) continue;
+    if (knownSensors[i].active) {
+      DEBUG_SERIAL.print("Sensor lost in slot ");
+      DEBUG_SERIAL.println(i);
+    }
+    knownSensors[i].active = false;
+    if (!isEmptySlot(knownSensors[i].addr)) stale |= (1 << i);
+  }
+  SENSOR_REG(REG_DS18B20_STALE) = stale;
+  SENSOR_REG(REG_DS18B20_COUNT) = scanFound;
+  scanRunning = false;
+  return true;
 }
 
+// Aktiverar platsen för en funnen givare, eller sparar den på en ledig plats.
+// EEPROM skrivs bara för en ny givare.
 int registerSensor(DeviceAddress addr) {
   for (int i = 0; i < MAX_SENSORS; i++) {
     if (matchAddress(addr, knownSensors[i].addr)) {
-      knownSensors[i].active = true;
+      if (!knownSensors[i].active) {
+        knownSensors[i].active = true;
+        knownSensors[i].resolution = 0; // Kan ha tappat matningen: skriv upplösningen igen
+        printAddress(addr);
+        DEBUG_SERIAL.print(" -> Reg ");
+        DEBUG_SERIAL.println(REG_DS18B20_SENSOR_BASE + i);
+      }
       return i;
     }
   }
@@ -147,33 +364,99 @@ int registerSensor(DeviceAddress addr) {
     if (isEmptySlot(knownSensors[i].addr)) {
       memcpy(knownSensors[i].addr, addr, 8);
       knownSensors[i].active = true;
+      knownSensors[i].resolution = 0;
       DEBUG_SERIAL.print("New sensor saved to slot ");
       DEBUG_SERIAL.println(i);
-      for (int j = 0; j < 8; j++) {
-        EEPROM.write((i * 8) + j, addr[j]);
-      }
+      EEPROM.put(i * sizeof(DeviceAddress), knownSensors[i].addr);
       return i;
     }
   }
   return -1;
 }
 
+// Önskad upplösning för en plats (9-12 bit, 0 eller ogiltigt = 12 bit)
+uint8_t requestedResolution(int i) {
+  uint16_t bits = configRegs[REG_DS18B20_RESOLUTION_BASE - BANK_CONFIG_START + i];
+  return (bits >= 9 && bits <= 12) ? (uint8_t)bits : DEFAULT_RESOLUTION;
+}
+
+// Skriver en ändrad upplösning till en givare. Returnerar true om den skrevs, så att
+// högst en givare konfigureras per loop()-varv. En misslyckad skrivning sparas inte
+// och görs om nästa gång bussen är ledig; mätningen körs under tiden så att en trasig
+// givare inte stoppar de andra. setResolution() kopierar scratchpaden till EEPROM och
+// blockerar då ~25 ms (REG_PERF_TEMP_MAX_US).
+bool applyResolution() {
+  for (int i = 0; i < MAX_SENSORS; i++) {
+    uint8_t bits = requestedResolution(i);
+    if (knownSensors[i].active && knownSensors[i].resolution != bits) {
+      if (!sensors.setResolution(knownSensors[i].addr, bits, true)) return false;
+      knownSensors[i].resolution = bits;
+      return true;
+    }
+  }
+  return false;
+}
+
+// Rått värde i 1/128 °C till °C * 100, avrundat
+int16_t rawToCenti(int32_t raw) {
+  int32_t scaled = raw * 100;
+  return (int16_t)((scaled + (scaled >= 0 ? 64 : -64)) / 128);
+}
+
 void handleTemperature() {
   unsigned long now = millis();
-  if (now - lastTempRequest >= tempInterval) {
-    lastTempRequest = now;
-    sensors.requestTemperatures(); 
-    
-    for (int i = 0; i < MAX_SENSORS; i++) {
-      if (knownSensors[i].active) {
-        float tempC = sensors.getTempC(knownSensors[i].addr);
-        if(tempC != DEVICE_DISCONNECTED_C) {
-          int16_t storedTemp = (int16_t)(tempC * 100);
-          // Uppdatera arrayen direkt
-          au16data[SENSOR_START_REG + i] = storedTemp;
+
+  switch (tempState) {
+    case TEMP_IDLE: {
+      // Bussen är ledig mellan konverteringarna: sök först, konfigurera sedan
+      if (scanRunning || now - lastScan >= scanInterval) {
+        if (scanStep()) lastScan = now;
+        return;
+      }
+      if (applyResolution()) return;
+      if (now - lastTempRequest < tempInterval) return;
+      lastTempRequest = now;
+
+      // Konverteringstiden följer den högsta upplösningen på bussen
+      uint8_t maxBits = 9;
+      for (int i = 0; i < MAX_SENSORS; i++) {
+        if (knownSensors[i].active && knownSensors[i].resolution > maxBits) {
+          maxBits = knownSensors[i].resolution;
         }
       }
+      conversionWait = sensors.millisToWaitForConversion(maxBits);
+      sensors.requestTemperatures(); // Alla givare samtidigt (Skip ROM), returnerar direkt
+      conversionStart = now;
+      tempState = TEMP_CONVERTING;
+      break;
     }
+
+    case TEMP_CONVERTING:
+      if (now - conversionStart < conversionWait) return;
+      tempIndex = 0;
+      tempState = TEMP_READING;
+      break;
+
+    case TEMP_READING:
+      // Hoppa till nästa aktiva givare och läs bara den
+      while (tempIndex < MAX_SENSORS && !knownSensors[tempIndex].active) tempIndex++;
+      if (tempIndex >= MAX_SENSORS) {
+        tempState = TEMP_IDLE;
+        return;
+      }
+      {
+        int32_t raw = sensors.getTemp(knownSensors[tempIndex].addr);
+        if (raw != DEVICE_DISCONNECTED_RAW) {
+          // Uppdatera sensorbanken direkt, fast punkt utan float
+          SENSOR_REG(REG_DS18B20_SENSOR_BASE + tempIndex) = (uint16_t)rawToCenti(raw);
+          SENSOR_REG(REG_DS18B20_STALE) &= ~(1 << tempIndex);
+        } else {
+          // Svarar inte: behåll senaste värdet, nästa sökning avgör om den är borta
+          SENSOR_REG(REG_DS18B20_STALE) |= (1 << tempIndex);
+        }
+      }
+      tempIndex++;
+      break;
   }
 }
 
@@ -202,24 +485,65 @@ void printAddress(DeviceAddress deviceAddress) {
 
 // --- I2C Callbacks ---
 
+// Ordet för ett värde i heltal + tiondelar (värde * 10). Tiondelarna följer heltalets tecken;
+// ett ogiltigt tiondelsvärde begränsas till 9 så att heltalet går att få tillbaka ur ordet.
+uint16_t decimalWord(int8_t whole, uint8_t tenths) {
+  if (tenths > 9) tenths = 9;
+  return (uint16_t)(int16_t)(whole * 10 + (whole < 0 ? -tenths : tenths));
+}
+
+// Lägger en byte från pumpen i pumpbanken. Vanliga register teckenutökas till ett eget ord;
+// heltal + tiondelar blir ett ord med tecken på heltalets index, och tiondelarna behåller sitt.
+void storePumpByte(uint8_t index, uint8_t val) {
+  if (decimalWhole[index]) {
+    thermiqRegs[index] = decimalWord((int8_t)val, (uint8_t)thermiqRegs[index + 1]);
+    return;
+  }
+  thermiqRegs[index] = (uint16_t)(int16_t)(int8_t)val;
+  if (index > 0 && decimalWhole[index - 1]) {
+    int8_t whole = (int8_t)((int16_t)thermiqRegs[index - 1] / 10);
+    thermiqRegs[index - 1] = decimalWord(whole, val);
+  }
+}
+
+// Byten pumpen ska läsa på ett index, ur samma ord som Modbus ser
+uint8_t loadPumpByte(uint8_t index) {
+  if (decimalWhole[index]) {
+    return (uint8_t)(int8_t)((int16_t)thermiqRegs[index] / 10);
+  }
+  return (uint8_t)(thermiqRegs[index] & 0xFF);
+}
+
+// Hela skrivningen kommer i ett anrop (efter STOP), så ett värde i två bytes uppdateras
+// utan att Modbus i loop() kan läsa det halvt.
 void receiveEvent(int howMany) {
+  i2cRxEvents++;
   if (howMany == 0) return;
   i2cIndex = Wire.read();
   while (Wire.available()) {
     uint8_t val = Wire.read();
-    if (i2cIndex < 256) {
-      int8_t signedVal = (int8_t)val;
-      // Skriv direkt till den globala arrayen
-      au16data[i2cIndex] = (int16_t)signedVal;
+    if (i2cIndex < REG_THERMIQ_WORDS) {
+      storePumpByte((uint8_t)i2cIndex, val);
       i2cIndex++;
-    } else { Wire.read(); }
+    } else {
+      i2cOverruns++;
+    }
   }
 }
 
+// Fyller Wire:s TX-buffert från aktuellt index och framåt, så att en burstläsning
+// får en byte per register i stället för en byte per transaktion. Pumpen sätter
+// index med en skrivning före varje läsning.
 void requestEvent() {
-  if (i2cIndex < 256) {
-    // Läs direkt från den globala arrayen
-    uint16_t val16 = au16data[i2cIndex];
-    Wire.write((uint8_t)val16);
-  } else { Wire.write(0x00); }
-}
\ No newline at end of file
+  uint8_t buf[I2C_TX_BURST];
+  uint8_t n = 0;
+  for (uint16_t index = i2cIndex; index < REG_THERMIQ_WORDS && n < I2C_TX_BURST; index++) {
+    buf[n++] = loadPumpByte((uint8_t)index);
+  }
+  i2cRequestEvents++;
+  if (n == 0) {
+    buf[n++] = 0x00; // Utanför rymden
+    i2cOverruns++;
+  }
+  Wire.write(buf, n);
+}
@@ -0,0 +1,63 @@
+// GENERERAD FIL - ändra inte för hand.
+// Skapad av tools/gen_registers.cpp från tools/registers.schema (firmware/pic_bridge).
+// Modbus-adresser. Varje bank är en egen array; ThermIQ-byte N ligger i ord N, teckenutökad.
+// Hot-registren läses i 2 block (start+antal register): 0+26, 1000+11
+
+#ifndef RA4M1_REGISTERS_H
+#define RA4M1_REGISTERS_H
+
+// --- THERMIQ (Pumpens I2C Master Write, ett ord per byte) ---
+#define REG_THERMIQ_WORDS                  256 // Pumpens indexrymd (8-bitars index)
+#define REG_T_OUTDOOR                      0 // Outdoor (°C)
+#define REG_T_INDOOR                       1 // Indoor (°C * 10). Heltal (1) + tiondelar (2), ett ord
+#define REG_T_INDOOR_DEC                   2 // Tiondelarna som pumpen skrev
+#define REG_T_SUPPLY                       5 // Supply Line (°C)
+#define REG_T_RETURN                       6 // Return Line (°C)
+#define REG_T_HOTWATER                     7 // Hotwater (°C)
+#define REG_S_STATUS                       16 // Status 16. Bit 0 brine, 1 kompressor, 2 cirk., 3 VV, 7 tillsats
+#define REG_I_INTEGRAL                     25 // Integral
+#define REG_SET_ROOM_TARGET                50 // Rum Börvärde (°C) [rw]
+#define REG_P_CURVE                        52 // Kurva [rw]
+
+// Heltal + tiondelar från pumpen, ett ord på heltalsadressen: THERMIQ_DECIMAL_PAIRS(X) -> X(adress) ...
+#define THERMIQ_DECIMAL_PAIRS(X) X(1)
+
+// --- Modbus (standard; baud och paritet kan ändras via konfigurationsbanken) ---
+#define MODBUS_SLAVE_ID                    10
+#define MODBUS_DEFAULT_BAUD                115200
+#define MODBUS_DEFAULT_PARITY              0 // 8N1
+
+// --- RA4M1 ---
+#define REG_DS18B20_SENSOR_BASE            1000 // Extra Sensor (°C * 100), 10 ord
+#define REG_DS18B20_SENSOR_LEN             10
+#define REG_DS18B20_STALE                  1010 // Extra Sensor Inaktuella
+#define REG_DS18B20_COUNT                  1011 // Extra Sensor Antal. Vid senaste sökningen
+#define REG_DS18B20_RESOLUTION_BASE        1050 // Extra Sensor Upplösning. 9-12 bit, 0 = 12 bit [rw], 10 ord
+#define REG_DS18B20_RESOLUTION_LEN         10
+#define REG_MODBUS_BAUD                    1060 // Modbus Baud (rått * 100). Baud / 100, 12-2304 [rw]
+#define REG_MODBUS_PARITY                  1061 // Modbus Paritet. 0 ingen, 1 udda, 2 jämn [rw]
+#define REG_FW_MAJOR_VERSION               1100 // Bridge Firmware Major
+#define REG_FW_MINOR_VERSION               1101 // Bridge Firmware Minor
+#define REG_MB_BUS_MESSAGES                1102 // Modbus Ramar. Alla ramar på bussen
+#define REG_MB_CRC_ERRORS                  1103 // Modbus CRC-fel
+#define REG_MB_EXCEPTIONS                  1104 // Modbus Undantag. Skickade undantagssvar
+#define REG_MB_OVERRUNS                    1105 // Modbus Överskridningar. För långa ramar
+#define REG_I2C_RX_EVENTS                  1106 // I2C Skrivningar. receiveEvent()
+#define REG_I2C_REQUEST_EVENTS             1107 // I2C Läsningar. requestEvent()
+#define REG_I2C_OVERRUNS                   1108 // I2C Kastade Bytes. Index efter 255
+#define REG_PERF_LOOP_PERIOD_MIN_US        1109 // Loop Period Min (us)
+#define REG_PERF_LOOP_PERIOD_MAX_US        1110 // Loop Period Max (us). Mättar på 65535
+#define REG_PERF_TEMP_LAST_US              1111 // Temperatur Tid Senast (us). handleTemperature()
+#define REG_PERF_TEMP_MAX_US               1112 // Temperatur Tid Max (us). ~25 ms när en upplösning skrivs
+
+// --- Registerbanker (Modbus-adress = BANK_<namn>_START + index i bankens array) ---
+#define BANK_THERMIQ_START                 0 // Pumpens indexrymd
+#define BANK_THERMIQ_LEN                   256
+#define BANK_SENSOR_START                  1000
+#define BANK_SENSOR_LEN                    12
+#define BANK_CONFIG_START                  1050
+#define BANK_CONFIG_LEN                    12
+#define BANK_DIAG_START                    1100
+#define BANK_DIAG_LEN                      13
+
+#endif /* RA4M1_REGISTERS_H */